@@ -0,0 +1,180 @@
+//******************************************************************************************
+// bench.cpp - Small microbenchmark framework for the host build.                         *
+//******************************************************************************************
+// Options:                                                                                *
+//   --filter <text>   Only run benchmarks with <text> in their name                       *
+//   --out <file>      Write the JSON results to <file> instead of stdout                  *
+//   --quick           Shorter runs, for a smoke test                                      *
+// The environment variable AQ_BENCH_TAG (for example a commit hash) is copied into the    *
+// JSON output, so results of different commits can be compared with compare.py.          *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "bench.h"
+#include "native/hal_native.h"
+#include "alloccount.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+#define BATCHES      5                                        // Number of measured batches
+#define MINBATCHNS   40000000ULL                              // Minimal time of one batch
+
+struct result_t
+{
+  const char* name ;
+  uint64_t    iterations ;                                    // Per batch
+  double      ns_per_op ;                                     // Median of batches
+  double      allocs_per_op ;
+  double      bytes_per_op ;
+  double      app_allocs_per_op ;                             // Allocations of the firmware
+  bool        failed ;                                        // BENCH_NOALLOC violated
+} ;
+
+static std::vector<result_t> results ;
+static const char*           filter = nullptr ;
+static const char*           outfile = nullptr ;
+static uint64_t              minbatch = MINBATCHNS ;
+
+
+static uint64_t now_ns()
+{
+  struct timespec ts ;
+
+  clock_gettime ( CLOCK_MONOTONIC, &ts ) ;
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec ;
+}
+
+
+void bench_init ( int argc, char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; i++ )
+  {
+    if ( ( strcmp ( argv[i], "--filter" ) == 0 ) && ( i + 1 < argc ) )
+    {
+      filter = argv[++i] ;
+    }
+    else if ( ( strcmp ( argv[i], "--out" ) == 0 ) && ( i + 1 < argc ) )
+    {
+      outfile = argv[++i] ;
+    }
+    else if ( strcmp ( argv[i], "--quick" ) == 0 )
+    {
+      minbatch = MINBATCHNS / 20 ;
+    }
+    else
+    {
+      fprintf ( stderr, "Usage: %s [--filter text] [--out file] [--quick]\n", argv[0] ) ;
+      exit ( 2 ) ;
+    }
+  }
+}
+
+
+//******************************************************************************************
+//                                B E N C H _ R U N                                        *
+//******************************************************************************************
+// Find a number of iterations that takes at least minbatch, then measure some batches.    *
+//******************************************************************************************
+void bench_run ( const char* name, bench_op_t op, int flags )
+{
+  uint64_t            n = 1 ;
+  uint64_t            t ;
+  uint64_t            i ;
+  std::vector<double> ns ;
+  hal_alloc_t         a0 ;
+  uint32_t            app0 ;
+  result_t            res ;
+
+  if ( filter && ( strstr ( name, filter ) == nullptr ) )
+  {
+    return ;
+  }
+  while ( true )                                              // Calibrate
+  {
+    t = now_ns() ;
+    for ( i = 0 ; i < n ; i++ )
+    {
+      op() ;
+    }
+    t = now_ns() - t ;
+    if ( t >= minbatch / 4 )
+    {
+      break ;
+    }
+    n *= 2 ;
+  }
+  n = n * minbatch / ( t ? t : 1 ) + 1 ;
+  a0 = hal_alloc ;
+  app0 = alloc_count ( ALLOC_APP ) ;
+  for ( int b = 0 ; b < BATCHES ; b++ )
+  {
+    t = now_ns() ;
+    for ( i = 0 ; i < n ; i++ )
+    {
+      op() ;
+    }
+    ns.push_back ( (double)( now_ns() - t ) / n ) ;
+  }
+  std::sort ( ns.begin(), ns.end() ) ;
+  res.name = name ;
+  res.iterations = n ;
+  res.ns_per_op = ns[BATCHES / 2] ;
+  res.allocs_per_op = (double)( hal_alloc.allocs - a0.allocs ) / ( n * BATCHES ) ;
+  res.bytes_per_op = (double)( hal_alloc.bytes - a0.bytes ) / ( n * BATCHES ) ;
+  res.app_allocs_per_op = (double)( alloc_count ( ALLOC_APP ) - app0 ) / ( n * BATCHES ) ;
+  res.failed = ( flags & BENCH_NOALLOC ) && ( alloc_count ( ALLOC_APP ) != app0 ) ;
+  results.push_back ( res ) ;
+  fprintf ( stderr, "%-28s %12.1f ns/op %14.0f op/s %8.2f allocs/op %9.1f bytes/op "
+                    "%6.2f app%s\n",
+            name, res.ns_per_op, 1e9 / res.ns_per_op, res.allocs_per_op,
+            res.bytes_per_op, res.app_allocs_per_op,
+            res.failed ? "  FAIL: firmware allocates" : "" ) ;
+}
+
+
+//******************************************************************************************
+//                             B E N C H _ R E P O R T                                     *
+//******************************************************************************************
+// Write the results as JSON.  Returns the exit code for main(): 1 if a benchmark with     *
+// BENCH_NOALLOC allocated in the firmware.                                                *
+//******************************************************************************************
+int bench_report()
+{
+  FILE*       f = stdout ;
+  const char* tag = getenv ( "AQ_BENCH_TAG" ) ;
+  int         failed = 0 ;
+
+  if ( outfile && ( ( f = fopen ( outfile, "w" ) ) == nullptr ) )
+  {
+    perror ( outfile ) ;
+    return 1 ;
+  }
+  fprintf ( f, "{\n  \"suite\": \"aqled-bench\",\n  \"format\": 1,\n" ) ;
+  fprintf ( f, "  \"tag\": \"%s\",\n  \"results\": [\n", tag ? tag : "" ) ;
+  for ( size_t i = 0 ; i < results.size() ; i++ )
+  {
+    const result_t& r = results[i] ;
+    fprintf ( f, "    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, "
+                 "\"ops_per_sec\": %.0f, \"allocs_per_op\": %.3f, "
+                 "\"bytes_per_op\": %.1f, \"app_allocs_per_op\": %.3f }%s\n",
+              r.name, (unsigned long long)r.iterations, r.ns_per_op,
+              1e9 / r.ns_per_op, r.allocs_per_op, r.bytes_per_op,
+              r.app_allocs_per_op, i + 1 < results.size() ? "," : "" ) ;
+    failed += r.failed ;
+  }
+  fprintf ( f, "  ]\n}\n" ) ;
+  if ( f != stdout )
+  {
+    fclose ( f ) ;
+  }
+  if ( failed )
+  {
+    fprintf ( stderr, "%d benchmark(s) allocate in the firmware\n", failed ) ;
+    return 1 ;
+  }
+  return 0 ;
+}
@@ -0,0 +1,29 @@
+//******************************************************************************************
+// bench.h - Small microbenchmark framework for the host build.                           *
+//******************************************************************************************
+// A benchmark is a name and an operation.  The operation is repeated in batches until a   *
+// batch takes long enough to be measured; the median of a few batches is reported.        *
+// Heap allocations are counted by the host HAL (see native/alloc_native.cpp), in total    *
+// and for the firmware itself ("app").  A benchmark with BENCH_NOALLOC must not allocate  *
+// in the firmware; if it does, it is reported as failed and the exit code is 1.           *
+// Results are printed as a table on stderr and as JSON on stdout (or --out file).         *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+#define BENCH_NOALLOC  1                                      // Firmware must not allocate
+
+typedef std::function<void()> bench_op_t ;
+
+void bench_init ( int argc, char* argv[] ) ;                  // Parse options
+void bench_run ( const char* name, bench_op_t op,             // Measure an operation
+                 int flags = 0 ) ;
+int  bench_report() ;                                         // Print results
+
+#endif
@@ -0,0 +1,274 @@
+//******************************************************************************************
+// bench_main.cpp - Microbenchmarks of the hot paths of the firmware.                     *
+//******************************************************************************************
+// Build and run:                                                                          *
+//   pio run -e bench                                                                      *
+//   AQ_BENCH_TAG=$(git rev-parse --short HEAD) .pio/build/bench/program --out bench.json  *
+//   python3 host/bench/compare.py old.json bench.json                                     *
+// The firmware is not started with setup(), only the parts needed by a benchmark are      *
+// initialized.  Console output is off, only formatting and storage are measured.          *
+// The steady state paths are marked BENCH_NOALLOC: after setup() the firmware must not    *
+// use the heap.  Allocations of the webserver itself do not count.                        *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Snapshot released after the response, like at the disconnect           *
+//******************************************************************************************
+#include "bench.h"
+#include "../firmware.h"
+#include "native/hal_native.h"
+#include "parse.h"
+#include "push.h"
+
+
+//******************************************************************************************
+// The parameter parsing of handle_setconf() before parse_intlist(), for comparison.       *
+//******************************************************************************************
+static void oldparse ( const String& param, uint8_t* values )
+{
+  String value = param ;
+  int    inx ;
+
+  for ( int i = 0 ; i < 48 ; i++ )
+  {
+    values[i] = value.toInt() ;
+    inx = value.indexOf ( "," ) ;
+    if ( inx > 0 )
+    {
+      value = value.substring ( inx + 1 ) ;
+    }
+  }
+}
+
+
+//******************************************************************************************
+// Get the complete body of a response, like the webserver does, then release the request  *
+// as the disconnect does.                                                                 *
+//******************************************************************************************
+static size_t drain ( AsyncWebServerRequest* request )
+{
+  static uint8_t          buf[1460] ;
+  AsyncWebServerResponse* response = request->response() ;
+  size_t                  total = 0 ;
+  size_t                  n ;
+
+  if ( response )
+  {
+    while ( ( n = response->fill ( buf, sizeof(buf) ) ) != 0 )
+    {
+      if ( n == RESPONSE_TRY_AGAIN )
+      {
+        break ;
+      }
+      total += n ;
+    }
+  }
+  request->clearResponse() ;
+  request_gone ( request ) ;
+  return total ;
+}
+
+
+int main ( int argc, char* argv[] )
+{
+  AsyncWebServerRequest getconf ( "/getconf" ) ;
+  AsyncWebServerRequest getconf304 ( "/getconf" ) ;
+  AsyncWebServerRequest getbin ( "/conf.bin" ) ;
+  AsyncWebServerRequest state ( "/api/state" ) ;
+  AsyncWebServerRequest root ( "/" ) ;
+  AsyncWebServerRequest preview ( "/preview" ) ;
+  AsyncWebServerRequest putbin ( "/conf.bin", HTTP_POST ) ;
+  uint8_t               confbin[60] ;
+  AsyncWebServerRequest setconf ( "/setconf" ) ;
+  AsyncWebServerRequest setbody ( "/setconf", HTTP_POST ) ;
+  AsyncWebServerRequest overrule ( "/overrule" ) ;
+  AsyncWebServerRequest batch[2] = { AsyncWebServerRequest ( "/batch" ),
+                                     AsyncWebServerRequest ( "/batch" ) } ;
+  int                   binx = 0 ;
+  pushpos_t             pos[PUSH_CLIENTS] = {} ;
+  size_t                sent[PUSH_CLIENTS] = {} ;
+  AsyncWebServerRequest patch[2] = { AsyncWebServerRequest ( "/patchconf" ),
+                                     AsyncWebServerRequest ( "/patchconf" ) } ;
+  int                   pinx = 0 ;
+  uint8_t               values[48] ;
+  parse_err_t           err ;
+  String                setting ;
+  const char*           names[] = { "/index.html", "/style.css", "/logo.gif",
+                                    "/favicon.ico", "/ADSL-11.pw", "/about.txt" } ;
+  size_t                ninx = 0 ;
+  static uint8_t        chunk[1460] ;
+
+  bench_init ( argc, argv ) ;
+  hal_console_enable ( false ) ;                              // Measure formatting only
+  hal_fs_begin() ;                                            // LittleFS from data/
+  load_index() ;                                              // Fields of the home page
+  ltime = 12 * 3600 + 34 * 60 + 56 ;
+  for ( int i = 0 ; i < 48 ; i++ )                            // Typical schedule
+  {
+    setting += String ( ( i * 37 ) % 101 ) ;
+    setting += "," ;
+  }
+  setconf.addParam ( "setting", setting ) ;
+  overrule.addParam ( "setting", "50,60," ) ;
+  preview.addParam ( "setting", "30,70," ) ;
+  patch[0].addParam ( "patch", "A8=40" ) ;                    // One slider moved, back and
+  patch[1].addParam ( "patch", "A8=41" ) ;                    // forth, so every call saves
+  batch[0].addParam ( "ops", "O:80,60,30;P:A8-17=80,B8=40;G" ) ;   // Typical automation
+  batch[1].addParam ( "ops", "O:80,60,30;P:A8-17=81,B8=40;G" ) ;
+
+  bench_run ( "dbgprint/plain", []()
+  {
+    dbgprint ( "HTTP getconf request" ) ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "dbgprint/format", []()
+  {
+    dbgprint ( "%2d - %-25s Signal: %3d dBm Encryption %4s  %s",
+               3, "NETGEAR-11", -67, "WPA2", "Acceptable" ) ;
+  }, BENCH_NOALLOC ) ;
+
+  for ( int i = 0 ; i < 100 ; i++ )                           // A full logging page
+  {
+    dbgprint ( "%2d - %-25s Signal: %3d dBm", i, "NETGEAR-11", -67 ) ;
+  }
+  bench_run ( "cb_logging/page", []()
+  {
+    size_t index = 0 ;
+    size_t n ;
+    while ( ( n = cb_logging ( chunk, sizeof(chunk), index ) ) != 0 )
+    {
+      index += n ;
+    }
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "parse/setconf-old", [&]()
+  {
+    oldparse ( setting, values ) ;
+  } ) ;
+
+  bench_run ( "parse/setconf", [&]()
+  {
+    parse_intlist ( setting.c_str(), setting.length(), values, 48, 0, 100, &err ) ;
+  } ) ;
+
+  bench_run ( "handle_setconf", [&]()
+  {
+    handle_setconf ( &setconf ) ;
+    drain ( &setconf ) ;
+    run_commands() ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "handle_setconf/body", [&]()
+  {
+    uint8_t* body = (uint8_t*)setting.c_str() ;               // Same text as parameter
+    size_t   half = setting.length() / 2 ;                    // Split in a number
+
+    handle_setconf_body ( &setbody, body, half, 0, setting.length() ) ;
+    handle_setconf_body ( &setbody, body + half, setting.length() - half, half,
+                          setting.length() ) ;
+    handle_setconf ( &setbody ) ;
+    drain ( &setbody ) ;
+    run_commands() ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "handle_patchconf", [&]()
+  {
+    handle_patchconf ( &patch[pinx] ) ;
+    drain ( &patch[pinx] ) ;
+    run_commands() ;
+    pinx ^= 1 ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "handle_preview", [&]()
+  {
+    handle_preview ( &preview ) ;
+    drain ( &preview ) ;
+    run_commands() ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "handle_overrule", [&]()
+  {
+    handle_overrule ( &overrule ) ;
+    drain ( &overrule ) ;
+    run_commands() ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "handle_batch", [&]()
+  {
+    handle_batch ( &batch[binx] ) ;
+    drain ( &batch[binx] ) ;
+    run_commands() ;
+    binx ^= 1 ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "push/fanout", [&]()                            // One frame to all clients
+  {
+    push_publish ( "output", "{\"A\":80,\"B\":60,\"overrule\":false}" ) ;
+    for ( int i = 0 ; i < PUSH_CLIENTS ; i++ )
+    {
+      size_t n ;
+      while ( ( ( n = push_fill ( &pos[i], chunk, sizeof(chunk), sent[i] ) ) !=
+                RESPONSE_TRY_AGAIN ) && n )
+      {
+        sent[i] += n ;
+      }
+    }
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "handle_getconf", [&]()
+  {
+    handle_getconf ( &getconf ) ;
+    drain ( &getconf ) ;
+  }, BENCH_NOALLOC ) ;
+
+  getconf304.addHeader ( "If-None-Match", confetag.c_str() ) ;   // Poll with the ETag
+  bench_run ( "handle_getconf/304", [&]()
+  {
+    handle_getconf ( &getconf304 ) ;
+    drain ( &getconf304 ) ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "handle_getconfbin", [&]()
+  {
+    handle_getconfbin ( &getbin ) ;
+    drain ( &getbin ) ;
+  }, BENCH_NOALLOC ) ;
+
+  handle_getconfbin ( &getbin ) ;                             // Body to post back
+  getbin.response()->fill ( confbin, sizeof(confbin) ) ;
+  getbin.clearResponse() ;
+  bench_run ( "handle_putconfbin", [&]()
+  {
+    handle_confbin_body ( &putbin, confbin, 20, 0, 60 ) ;     // Body in 2 parts
+    handle_confbin_body ( &putbin, confbin + 20, 40, 20, 60 ) ;
+    handle_putconfbin ( &putbin ) ;
+    drain ( &putbin ) ;
+    run_commands() ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "handle_state", [&]()
+  {
+    handle_state ( &state ) ;
+    drain ( &state ) ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "handle_root", [&]()
+  {
+    handle_root ( &root ) ;
+    drain ( &root ) ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "getContentType", [&]()
+  {
+    char ct[MIME_TYPELEN] ;
+    getContentType ( names[ninx], ct ) ;
+    ninx = ( ninx + 1 ) % 6 ;
+  }, BENCH_NOALLOC ) ;
+
+  bench_run ( "loop/schedule", []()
+  {
+    ltime += 60 ;                                             // Next minute
+    loop() ;
+  }, BENCH_NOALLOC ) ;
+
+  return bench_report() ;
+}
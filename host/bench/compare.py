@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+#******************************************************************************************
+# compare.py - Compare two result files of the host benchmarks.                           *
+#******************************************************************************************
+# Usage: compare.py [--threshold PCT] old.json new.json                                    *
+# Shows the change of time and allocations per operation.  The exit code is 1 if a         *
+# benchmark got slower than the threshold (default 10 %) or allocates more than before.    *
+#******************************************************************************************
+# 16-10-2026, AG - First setup                                                             *
+#******************************************************************************************
+import argparse
+import json
+import sys
+
+
+def load ( fnam ) :
+    with open ( fnam ) as f :
+        data = json.load ( f )
+    return data.get ( "tag", "" ), { r["name"] : r for r in data["results"] }
+
+
+def main() :
+    parser = argparse.ArgumentParser ( description = "Compare benchmark results" )
+    parser.add_argument ( "--threshold", type = float, default = 10.0,
+                          help = "Allowed slowdown in percent" )
+    parser.add_argument ( "old" )
+    parser.add_argument ( "new" )
+    args = parser.parse_args()
+    oldtag, old = load ( args.old )
+    newtag, new = load ( args.new )
+    bad = 0
+    print ( "%-28s %12s %12s %8s %10s %10s" % ( "benchmark", oldtag or "old ns/op",
+            newtag or "new ns/op", "change", "allocs", "" ) )
+    for name, n in new.items() :
+        o = old.get ( name )
+        if o is None :
+            print ( "%-28s %12s %12.1f %8s %10.2f" % ( name, "-", n["ns_per_op"], "new",
+                    n["allocs_per_op"] ) )
+            continue
+        change = ( n["ns_per_op"] - o["ns_per_op"] ) * 100.0 / o["ns_per_op"]
+        flag = ""
+        if change > args.threshold :
+            flag = "SLOWER"
+        if n["allocs_per_op"] > o["allocs_per_op"] + 0.001 :
+            flag += " MORE-ALLOCS"
+        if flag :
+            bad += 1
+        print ( "%-28s %12.1f %12.1f %+7.1f%% %4.2f->%-4.2f %s" % ( name, o["ns_per_op"],
+                n["ns_per_op"], change, o["allocs_per_op"], n["allocs_per_op"], flag ) )
+    return 1 if bad else 0
+
+
+if __name__ == "__main__" :
+    sys.exit ( main() )
@@ -0,0 +1,59 @@
+//******************************************************************************************
+// firmware.h - Functions and data of main.cpp, as used by the host harnesses.            *
+//******************************************************************************************
+// The harnesses in host/ are linked with the firmware sources (without the normal entry   *
+// point native/main_native.cpp) and call the firmware directly.                           *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Release of a request                                                   *
+// 17-10-2026, AG - Settings at boot                                                       *
+// 17-10-2026, AG - Content type in a buffer of the caller                                 *
+//******************************************************************************************
+#ifndef FIRMWARE_H
+#define FIRMWARE_H
+
+#include "hal.h"
+#include "fixstring.h"
+#include "mimetype.h"
+
+void                       setup() ;
+void                       loop() ;
+void                       run_commands() ;
+size_t                     cb_logging ( uint8_t *buffer, size_t maxLen, size_t index ) ;
+void                       handle_logging ( AsyncWebServerRequest *request ) ;
+void                       handle_test ( AsyncWebServerRequest *request ) ;
+void                       handle_getconf ( AsyncWebServerRequest *request ) ;
+void                       handle_setconf ( AsyncWebServerRequest *request ) ;
+void                       handle_patchconf ( AsyncWebServerRequest *request ) ;
+void                       handle_getconfbin ( AsyncWebServerRequest *request ) ;
+void                       handle_putconfbin ( AsyncWebServerRequest *request ) ;
+void                       handle_confbin_body ( AsyncWebServerRequest *request,
+                                                 uint8_t* data, size_t len,
+                                                 size_t index, size_t total ) ;
+void                       handle_setconf_body ( AsyncWebServerRequest *request,
+                                                  uint8_t* data, size_t len,
+                                                  size_t index, size_t total ) ;
+void                       handle_patchconf_body ( AsyncWebServerRequest *request,
+                                                    uint8_t* data, size_t len,
+                                                    size_t index, size_t total ) ;
+void                       handle_state ( AsyncWebServerRequest *request ) ;
+void                       handle_root ( AsyncWebServerRequest *request ) ;
+void                       load_index() ;
+void                       handle_preview ( AsyncWebServerRequest *request ) ;
+void                       handle_overrule ( AsyncWebServerRequest *request ) ;
+void                       handle_batch ( AsyncWebServerRequest *request ) ;
+void                       handle_events ( AsyncWebServerRequest *request ) ;
+void                       handle_wait ( AsyncWebServerRequest *request ) ;
+const char*                load_settings() ;
+void                       request_gone ( AsyncWebServerRequest *request ) ;
+const char*                getContentType ( const char* filename, char* ct ) ;
+
+extern AsyncWebServer*     httpserver ;
+extern uint16_t            dbgcount ;
+extern FixedString<11>     confetag ;
+extern uint8_t             intensityA ;
+extern uint8_t             intensityB ;
+extern time_t              ltime ;
+extern bool                savedue ;
+
+#endif
@@ -0,0 +1,452 @@
+//******************************************************************************************
+// loadtest.cpp - HTTP load test of the firmware on the host.                             *
+//******************************************************************************************
+// The firmware is started in this process (setup(), then loop() in a thread of its own)   *
+// and a number of client threads send requests to it over the loopback interface.         *
+// With --target the firmware is not started and an external server (for example a real    *
+// controller) is loaded instead; the loop() jitter is not available then.                 *
+//                                                                                         *
+// Options:                                                                                *
+//   --clients <n>        Number of concurrent clients (default 4)                         *
+//   --duration <sec>     Length of the test (default 10)                                  *
+//   --mix <spec>         Request mix, "name=weight,..." (default see defmix below)         *
+//   --target <ip:port>   Load an external server                                          *
+//   --json <file>        Write the results as JSON                                        *
+// Names in the mix are the routes in the table "routes" below.                            *
+//                                                                                         *
+// Reported: requests per second, latency percentiles per route, errors, peak memory of    *
+// the process and the period of loop(), which shows how much the request handling delays  *
+// the output updates.  For a local server also the heap allocations of the firmware and   *
+// the webserver after setup() (see alloccount.h).                                         *
+// A 503 is the answer of the admission control (src/admit.h), it is counted as refused,   *
+// not as an error.  This build raises the rate per client (platformio.ini), else nearly   *
+// all requests from the one address of the load test would be refused; the limit on the   *
+// active requests is the one of the firmware, so more clients than ADMIT_ACTIVE show it.  *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "../firmware.h"
+#include "native/hal_native.h"
+#include "alloccount.h"
+#include "admit.h"
+#include <unistd.h>
+#include <errno.h>
+#include <malloc.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct route_t                                                // A request of the mix
+{
+  const char* name ;
+  const char* path ;
+} ;
+
+static const route_t routes[] =
+{
+  { "root",     "/" },
+  { "getconf",  "/getconf" },
+  { "setconf",  "/setconf?setting=0,0,0,0,0,0,0,0,0,0,0,0,5,5,20,20,40,40,60,60,"
+                "80,80,90,90,90,90,90,90,90,90,80,80,60,60,40,40,20,20,5,5,0,0,0,0,"
+                "0,0,0,0," },
+  { "overrule", "/overrule?setting=50,60," },
+  { "logging",  "/logging" },
+  { "test",     "/test" },
+  { "css",      "/style.css" },
+  { "gif",      "/logo.gif" },
+  { "ico",      "/favicon.ico" },
+  { "about",    "/about.html" },
+  { "missing",  "/nothere.txt" },
+} ;
+#define NROUTES ( sizeof(routes) / sizeof(routes[0]) )
+
+static const char*          defmix = "getconf=40,root=10,css=10,gif=5,ico=5,logging=10,"
+                                     "test=10,overrule=5,setconf=5" ;
+
+struct sample_t                                               // Result of one request
+{
+  uint8_t  route ;
+  uint16_t status ;                                           // 0 for network error
+  uint32_t us ;                                               // Latency in microseconds
+} ;
+
+static std::vector<int>     weights ( NROUTES, 0 ) ;          // Weight per route
+static int                  totalweight ;
+static struct sockaddr_in   target ;                          // Server to load
+static std::atomic<bool>    running { true } ;
+static std::atomic<bool>    loopstop { false } ;
+static std::mutex           resmutex ;
+static std::vector<sample_t> samples ;                        // All results
+static std::vector<uint32_t> loopperiods ;                    // Period of loop() in us
+static size_t               peakheap ;                        // Peak malloc'ed memory
+
+
+static uint64_t now_us()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>
+         ( std::chrono::steady_clock::now().time_since_epoch() ).count() ;
+}
+
+
+//******************************************************************************************
+// Parse the mix specification "name=weight,...".                                          *
+//******************************************************************************************
+static bool parsemix ( const char* spec )
+{
+  std::string s ( spec ) ;
+  size_t      pos = 0 ;
+
+  while ( pos < s.size() )
+  {
+    size_t      comma = s.find ( ',', pos ) ;
+    std::string item = s.substr ( pos, comma == std::string::npos ? std::string::npos
+                                                                  : comma - pos ) ;
+    size_t      eq = item.find ( '=' ) ;
+    size_t      i ;
+    pos = comma == std::string::npos ? s.size() : comma + 1 ;
+    if ( item.empty() )
+    {
+      continue ;
+    }
+    for ( i = 0 ; i < NROUTES ; i++ )
+    {
+      if ( item.substr ( 0, eq ) == routes[i].name )
+      {
+        break ;
+      }
+    }
+    if ( i == NROUTES )
+    {
+      fprintf ( stderr, "Unknown route in mix: %s\n", item.c_str() ) ;
+      return false ;
+    }
+    weights[i] = eq == std::string::npos ? 1 : atoi ( item.c_str() + eq + 1 ) ;
+  }
+  for ( int w : weights )
+  {
+    totalweight += w ;
+  }
+  return totalweight > 0 ;
+}
+
+
+//******************************************************************************************
+// Do one request.  Returns the HTTP status or 0 on a network error.                       *
+//******************************************************************************************
+static int request ( const char* path )
+{
+  char    buf[4096] ;
+  int     fd ;
+  int     one = 1 ;
+  int     status = 0 ;
+  ssize_t n ;
+  bool    first = true ;
+
+  fd = socket ( AF_INET, SOCK_STREAM, 0 ) ;
+  setsockopt ( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one) ) ;
+  if ( connect ( fd, (struct sockaddr*)&target, sizeof(target) ) < 0 )
+  {
+    close ( fd ) ;
+    return 0 ;
+  }
+  n = snprintf ( buf, sizeof(buf), "GET %s HTTP/1.1\r\nHost: aqledverl\r\n"
+                 "Accept-Encoding: gzip, deflate\r\n"      // Like a browser
+                 "Connection: close\r\n\r\n", path ) ;
+  if ( send ( fd, buf, n, MSG_NOSIGNAL ) != n )
+  {
+    close ( fd ) ;
+    return 0 ;
+  }
+  while ( ( n = recv ( fd, buf, sizeof(buf) - 1, 0 ) ) > 0 )  // Read until closed
+  {
+    if ( first )
+    {
+      buf[n] = '\0' ;
+      sscanf ( buf, "HTTP/%*s %d", &status ) ;
+      first = false ;
+    }
+  }
+  close ( fd ) ;
+  return n < 0 ? 0 : status ;
+}
+
+
+static void client ( unsigned seed )
+{
+  std::vector<sample_t> res ;
+  sample_t              s ;
+  uint64_t              t ;
+  int                   r ;
+
+  while ( running )
+  {
+    r = rand_r ( &seed ) % totalweight ;
+    for ( s.route = 0 ; r >= weights[s.route] ; s.route++ )
+    {
+      r -= weights[s.route] ;
+    }
+    t = now_us() ;
+    s.status = request ( routes[s.route].path ) ;
+    s.us = now_us() - t ;
+    res.push_back ( s ) ;
+  }
+  std::lock_guard<std::mutex> lock ( resmutex ) ;
+  samples.insert ( samples.end(), res.begin(), res.end() ) ;
+}
+
+
+//******************************************************************************************
+// Run loop() like main_native.cpp does and record the time between 2 runs.                *
+//******************************************************************************************
+static void looprunner()
+{
+  uint64_t prev = now_us() ;
+  uint64_t t ;
+
+  while ( ! loopstop )
+  {
+    {
+      SysLock lock ;
+      t = now_us() ;
+      loop() ;
+    }
+    loopperiods.push_back ( t - prev ) ;
+    prev = t ;
+    hal_delay ( 1 ) ;
+  }
+}
+
+
+static void heapsampler()
+{
+  while ( ! loopstop )
+  {
+    struct mallinfo2 mi = mallinfo2() ;
+    peakheap = std::max ( peakheap, mi.uordblks ) ;
+    hal_delay ( 5 ) ;
+  }
+}
+
+
+static uint32_t percentile ( std::vector<uint32_t>& v, double p )
+{
+  if ( v.empty() )
+  {
+    return 0 ;
+  }
+  return v[std::min ( v.size() - 1, (size_t)( p * v.size() / 100.0 ) )] ;
+}
+
+
+//******************************************************************************************
+// Print the results, and write them as JSON if requested.                                 *
+//******************************************************************************************
+static void report ( double seconds, int clients, FILE* json, bool local )
+{
+  std::vector<uint32_t> lat ;
+  std::vector<uint32_t> all ;
+  size_t                errors = 0 ;
+  size_t                refused = 0 ;
+  struct rusage         ru ;
+  bool                  firstroute = true ;
+
+  getrusage ( RUSAGE_SELF, &ru ) ;
+  printf ( "\n%-10s %8s %7s %8s %8s %8s %8s\n", "route", "requests", "errors",
+           "p50 us", "p90 us", "p99 us", "max us" ) ;
+  if ( json )
+  {
+    fprintf ( json, "{\n  \"suite\": \"aqled-loadtest\",\n  \"format\": 1,\n" ) ;
+    fprintf ( json, "  \"clients\": %d,\n  \"seconds\": %.1f,\n  \"routes\": [\n",
+              clients, seconds ) ;
+  }
+  for ( size_t r = 0 ; r <= NROUTES ; r++ )                   // NROUTES is the total
+  {
+    size_t err = 0 ;
+    size_t ref = 0 ;
+    lat.clear() ;
+    for ( const sample_t& s : samples )
+    {
+      if ( ( r == NROUTES ) || ( s.route == r ) )
+      {
+        lat.push_back ( s.us ) ;
+        if ( s.status == 503 )
+        {
+          ref++ ;                                             // Admission control
+        }
+        else if ( ( s.status == 0 ) || ( s.status >= 500 ) )
+        {
+          err++ ;
+        }
+      }
+    }
+    if ( lat.empty() )
+    {
+      continue ;
+    }
+    std::sort ( lat.begin(), lat.end() ) ;
+    if ( r == NROUTES )
+    {
+      errors = err ;
+      refused = ref ;
+      all = lat ;
+    }
+    printf ( "%-10s %8zu %7zu %8u %8u %8u %8u\n", r == NROUTES ? "total" : routes[r].name,
+             lat.size(), err, percentile ( lat, 50 ), percentile ( lat, 90 ),
+             percentile ( lat, 99 ), lat.back() ) ;
+    if ( json && ( r < NROUTES ) )
+    {
+      fprintf ( json, "%s    { \"name\": \"%s\", \"requests\": %zu, \"errors\": %zu, "
+                      "\"p50_us\": %u, \"p90_us\": %u, \"p99_us\": %u, \"max_us\": %u }",
+                firstroute ? "" : ",\n", routes[r].name, lat.size(), err,
+                percentile ( lat, 50 ), percentile ( lat, 90 ), percentile ( lat, 99 ),
+                lat.back() ) ;
+      firstroute = false ;
+    }
+  }
+  printf ( "\nRequests per second   %10.1f\n", all.size() / seconds ) ;
+  printf ( "Errors                %10zu\n", errors ) ;
+  printf ( "Refused (503)         %10zu\n", refused ) ;
+  printf ( "Peak RSS              %10ld kB\n", ru.ru_maxrss ) ;
+  if ( local )
+  {
+    std::sort ( loopperiods.begin(), loopperiods.end() ) ;
+    printf ( "Peak heap in use      %10zu bytes\n", peakheap ) ;
+    printf ( "Allocations firmware  %10u\n", alloc_count ( ALLOC_APP ) ) ;
+    printf ( "Allocations webserver %10u\n", alloc_count ( ALLOC_WEB ) ) ;
+    printf ( "Admitted              %10u\n", (unsigned)admit_stats().accepted ) ;
+    printf ( "Refused busy/rate/heap %4u/%u/%u, peak %u active\n",
+             (unsigned)admit_stats().busy, (unsigned)admit_stats().limited,
+             (unsigned)admit_stats().lowheap, admit_stats().peak ) ;
+    printf ( "loop() period p50     %10u us\n", percentile ( loopperiods, 50 ) ) ;
+    printf ( "loop() period p99     %10u us\n", percentile ( loopperiods, 99 ) ) ;
+    printf ( "loop() period max     %10u us\n",
+             loopperiods.empty() ? 0 : loopperiods.back() ) ;
+  }
+  if ( json )
+  {
+    fprintf ( json, "\n  ],\n  \"requests\": %zu,\n  \"errors\": %zu,\n"
+                    "  \"refused\": %zu,\n"
+                    "  \"rps\": %.1f,\n  \"p50_us\": %u,\n  \"p99_us\": %u,\n"
+                    "  \"peak_rss_kb\": %ld", all.size(), errors, refused, all.size() / seconds,
+              percentile ( all, 50 ), percentile ( all, 99 ), ru.ru_maxrss ) ;
+    if ( local )
+    {
+      fprintf ( json, ",\n  \"peak_heap\": %zu,\n  \"loop_p50_us\": %u,\n"
+                      "  \"loop_p99_us\": %u,\n  \"loop_max_us\": %u,\n"
+                      "  \"app_allocs\": %u,\n  \"web_allocs\": %u",
+                peakheap, percentile ( loopperiods, 50 ), percentile ( loopperiods, 99 ),
+                loopperiods.empty() ? 0 : loopperiods.back(),
+                alloc_count ( ALLOC_APP ), alloc_count ( ALLOC_WEB ) ) ;
+    }
+    fprintf ( json, "\n}\n" ) ;
+    fclose ( json ) ;
+  }
+}
+
+
+int main ( int argc, char* argv[] )
+{
+  int                      clients = 4 ;
+  double                   duration = 10 ;
+  const char*              mix = defmix ;
+  const char*              ext = nullptr ;
+  FILE*                    json = nullptr ;
+  std::vector<std::thread> threads ;
+  std::thread              lp ;
+  std::thread              hs ;
+  uint64_t                 t0 ;
+
+  for ( int i = 1 ; i < argc ; i++ )
+  {
+    const char* val = i + 1 < argc ? argv[i + 1] : nullptr ;
+    if ( val && ( strcmp ( argv[i], "--clients" ) == 0 ) )
+    {
+      clients = atoi ( val ) ;
+    }
+    else if ( val && ( strcmp ( argv[i], "--duration" ) == 0 ) )
+    {
+      duration = atof ( val ) ;
+    }
+    else if ( val && ( strcmp ( argv[i], "--mix" ) == 0 ) )
+    {
+      mix = val ;
+    }
+    else if ( val && ( strcmp ( argv[i], "--target" ) == 0 ) )
+    {
+      ext = val ;
+    }
+    else if ( val && ( strcmp ( argv[i], "--json" ) == 0 ) )
+    {
+      if ( ( json = fopen ( val, "w" ) ) == nullptr )
+      {
+        perror ( val ) ;
+        return 1 ;
+      }
+    }
+    else
+    {
+      fprintf ( stderr, "Usage: %s [--clients n] [--duration sec] [--mix spec] "
+                        "[--target ip:port] [--json file]\n", argv[0] ) ;
+      return 2 ;
+    }
+    i++ ;
+  }
+  if ( ! parsemix ( mix ) )
+  {
+    return 2 ;
+  }
+  memset ( &target, 0, sizeof(target) ) ;
+  target.sin_family = AF_INET ;
+  if ( ext )                                                  // External server?
+  {
+    const char* colon = strchr ( ext, ':' ) ;
+    std::string ip ( ext, colon ? colon - ext : strlen ( ext ) ) ;
+    inet_pton ( AF_INET, ip.c_str(), &target.sin_addr ) ;
+    target.sin_port = htons ( colon ? atoi ( colon + 1 ) : 80 ) ;
+  }
+  else                                                        // No, start the firmware
+  {
+    setenv ( "AQ_HTTP_PORT", "0", 0 ) ;                       // Free port unless given
+    hal_console_enable ( false ) ;
+    {
+      SysLock lock ;
+      setup() ;
+    }
+    target.sin_addr.s_addr = htonl ( INADDR_LOOPBACK ) ;
+    target.sin_port = htons ( httpserver->port() ) ;
+    lp = std::thread ( looprunner ) ;
+    hs = std::thread ( heapsampler ) ;
+  }
+  printf ( "Load test with %d clients for %.0f seconds on port %d\n", clients, duration,
+           ntohs ( target.sin_port ) ) ;
+  t0 = now_us() ;
+  for ( int i = 0 ; i < clients ; i++ )
+  {
+    threads.push_back ( std::thread ( client, 1234 + i ) ) ;
+  }
+  std::this_thread::sleep_for ( std::chrono::milliseconds ( (int)( duration * 1000 ) ) ) ;
+  running = false ;
+  for ( std::thread& t : threads )
+  {
+    t.join() ;
+  }
+  duration = ( now_us() - t0 ) / 1e6 ;
+  if ( ! ext )
+  {
+    loopstop = true ;
+    lp.join() ;
+    hs.join() ;
+  }
+  report ( duration, clients, json, ext == nullptr ) ;
+  fflush ( stdout ) ;
+  _exit ( 0 ) ;                                               // Do not wait for the ticker
+}
@@ -0,0 +1,392 @@
+//******************************************************************************************
+// soak.cpp - Heap fragmentation soak test of the firmware on the host.                   *
+//******************************************************************************************
+// The request handlers of the firmware are called millions of times with all heap         *
+// allocations going to a model of the ESP8266 heap (umm_model.h).  A number of            *
+// connections are in flight at the same time, each one in a random state, so the life     *
+// times of the allocations interleave like they do on the controller.  Besides the        *
+// allocations of the firmware and the request/response objects, every connection takes   *
+// the memory that lwIP and AsyncTCP would take: a pcb, a client, a receive buffer with    *
+// the request and a send buffer per TCP segment until it is acknowledged.                 *
+//                                                                                         *
+// The host objects (String, AsyncWebServerRequest) are not the same size as on the        *
+// ESP8266, so the numbers are an approximation.  The trend over a long run is what        *
+// counts: free heap, largest free block and fragmentation should level off.               *
+// Static files are not part of the mix: the host file responses use stdio buffers that    *
+// are nothing like the LittleFS objects.                                                  *
+//                                                                                         *
+// Options:                                                                                *
+//   --requests <n>       Number of requests (default 1000000)                             *
+//   --conns <n>          Connections in flight (default 4)                                *
+//   --heap <bytes>       Free heap after startup (default 40000)                          *
+//   --interval <n>       Report every n requests (default 50000)                          *
+//   --csv <file>         Write the reports as CSV                                          *
+//   --max-frag <pct>     Fail if the fragmentation gets above pct                         *
+//   --min-block <bytes>  Fail if the largest free block gets below bytes                  *
+//   --seed <n>           Seed of the random generator                                     *
+// The exit code is 1 if a limit is exceeded or if "new" failed (the controller would      *
+// reset), else 0.                                                                         *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "../firmware.h"
+#include "native/hal_native.h"
+#include "soak.h"
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <random>
+#include <vector>
+
+#define PCBSIZE     176                                       // Size of a struct tcp_pcb
+#define CLIENTSIZE  120                                       // Size of an AsyncClient
+#define HEADERSIZE  400                                       // Typical request headers
+#define MSS         1460                                      // TCP segment size
+#define PBUFHEAD    56                                        // pbuf and protocol headers
+
+enum route_e { R_GETCONF, R_SETCONF, R_OVERRULE, R_LOGGING, R_TEST, R_CTYPE, NROUTES } ;
+
+struct conn_t                                                 // A connection in flight
+{
+  int                    state ;                              // 0 is idle
+  int                    route ;
+  void*                  pcb ;
+  void*                  client ;
+  void*                  txbuf ;                              // Not yet acknowledged
+  AsyncWebServerRequest* request ;
+} ;
+
+static const int         mix[NROUTES] = { 40, 5, 10, 15, 20, 10 } ;   // Weight per route
+static const char*       ctnames[] = { "/index.html", "/style.css", "/logo.gif",
+                                       "/favicon.ico", "/about.html", "/config.pw" } ;
+static std::mt19937      rng ;
+static uint8_t           txdata[MSS] ;                        // Segment to send
+static uint32_t          freeheap()                 { return soak_heap->freeBytes() ; }
+
+
+static int pickroute()
+{
+  int total = 0 ;
+  int r ;
+  int i ;
+
+  for ( i = 0 ; i < NROUTES ; i++ )
+  {
+    total += mix[i] ;
+  }
+  r = rng() % total ;
+  for ( i = 0 ; r >= mix[i] ; i++ )
+  {
+    r -= mix[i] ;
+  }
+  return i ;
+}
+
+
+//******************************************************************************************
+// A new request on this connection: pcb, client and the received request in a pbuf.       *
+//******************************************************************************************
+static void conn_open ( conn_t* c )
+{
+  static const char* urls[NROUTES] = { "/getconf", "/setconf", "/overrule",
+                                       "/logging", "/test", "/" } ;
+  void*              rxbuf ;
+  String             setting ;
+  int                i ;
+
+  c->route = pickroute() ;
+  c->pcb = malloc ( PCBSIZE ) ;
+  c->client = malloc ( CLIENTSIZE ) ;
+  rxbuf = malloc ( PBUFHEAD + HEADERSIZE + 200 ) ;            // Request with parameters
+  c->request = new AsyncWebServerRequest ( urls[c->route] ) ;
+  if ( c->route == R_SETCONF )
+  {
+    for ( i = 0 ; i < 48 ; i++ )
+    {
+      setting += String ( (int)( rng() % 101 ) ) ;
+      setting += ',' ;
+    }
+    c->request->addParam ( "setting", setting ) ;
+  }
+  else if ( c->route == R_OVERRULE )
+  {
+    setting = String ( (int)( rng() % 101 ) ) + "," + String ( (int)( rng() % 101 ) ) ;
+    c->request->addParam ( "setting", setting ) ;
+  }
+  c->request->addHeader ( "Host", "aqled.local" ) ;
+  c->request->addHeader ( "User-Agent", "Mozilla/5.0 (X11; Linux x86_64)" ) ;
+  free ( rxbuf ) ;                                            // Parsed, pbuf released
+  c->state = 1 ;
+}
+
+
+//******************************************************************************************
+// Call the handler.                                                                       *
+//******************************************************************************************
+static void conn_handle ( conn_t* c )
+{
+  switch ( c->route )
+  {
+    case R_GETCONF :
+      handle_getconf ( c->request ) ;
+      break ;
+    case R_SETCONF :
+      handle_setconf ( c->request ) ;
+      break ;
+    case R_OVERRULE :
+      handle_overrule ( c->request ) ;
+      break ;
+    case R_LOGGING :
+      handle_logging ( c->request ) ;
+      break ;
+    case R_TEST :
+      handle_test ( c->request ) ;
+      break ;
+    default :
+    {
+      char ct[MIME_TYPELEN] ;
+      getContentType ( ctnames[rng() % 6], ct ) ;
+      c->request->send ( 404 ) ;
+      break ;
+    }
+  }
+  c->state = 2 ;
+}
+
+
+//******************************************************************************************
+// Send the next segment.  The previous segment is acknowledged now.  The first segment    *
+// holds the headers.                                                                      *
+//******************************************************************************************
+static void conn_send ( conn_t* c )
+{
+  AsyncWebServerResponse* response = c->request->response() ;
+  size_t                  n ;
+
+  free ( c->txbuf ) ;
+  c->txbuf = nullptr ;
+  if ( c->state == 2 )
+  {
+    String head = response->head() ;                          // Assembled on the ESP too
+    c->txbuf = malloc ( PBUFHEAD + head.length() ) ;
+    c->state = 3 ;
+    return ;
+  }
+  n = response->fill ( txdata, sizeof(txdata) ) ;
+  if ( n == RESPONSE_TRY_AGAIN )
+  {
+    return ;                                                  // Try again next time
+  }
+  if ( n == 0 )
+  {
+    c->state = 4 ;                                            // All sent
+    return ;
+  }
+  c->txbuf = malloc ( PBUFHEAD + n ) ;
+}
+
+
+static void conn_close ( conn_t* c )
+{
+  delete c->request ;
+  free ( c->client ) ;
+  free ( c->pcb ) ;
+  *c = conn_t() ;
+}
+
+
+//******************************************************************************************
+// Next step for a connection.  Returns true if a request has been completed.              *
+//******************************************************************************************
+static bool conn_step ( conn_t* c )
+{
+  ModelScope scope ;
+
+  switch ( c->state )
+  {
+    case 0 :
+      conn_open ( c ) ;
+      break ;
+    case 1 :
+      conn_handle ( c ) ;
+      run_commands() ;                                        // Like the next loop()
+      break ;
+    case 2 :
+    case 3 :
+      conn_send ( c ) ;
+      break ;
+    default :
+      conn_close ( c ) ;
+      return true ;
+  }
+  return false ;
+}
+
+
+//******************************************************************************************
+// What the firmware allocates at startup: the first log lines.                            *
+//******************************************************************************************
+static void boot()
+{
+  ModelScope scope ;
+
+  dbgprint ( "Starting AqLed..." ) ;
+  dbgprint ( "FS Total %d, used %d", 1040384, 266240 ) ;
+  for ( int i = 0 ; i < 8 ; i++ )
+  {
+    dbgprint ( "%-32s - %6d", "/somefile.html", 1234 ) ;
+  }
+  dbgprint ( "HTTP-server started on port %d", 80 ) ;
+}
+
+
+int main ( int argc, char* argv[] )
+{
+  size_t               requests = 1000000 ;
+  size_t               nconns = 4 ;
+  size_t               heap = 40000 ;
+  size_t               interval = 50000 ;
+  const char*          csvname = nullptr ;
+  int                  maxfrag = -1 ;
+  long                 minblock = -1 ;
+  FILE*                csv = nullptr ;
+  std::vector<conn_t>  conns ;
+  size_t               done = 0 ;
+  size_t               minfree ;
+  size_t               minmaxblk ;
+  int                  peakfrag = 0 ;
+  bool                 crashed = false ;
+  bool                 fail ;
+
+  for ( int i = 1 ; i < argc ; i++ )
+  {
+    const char* val = ( i + 1 < argc ) ? argv[i+1] : "" ;
+    if ( strcmp ( argv[i], "--requests" ) == 0 )
+    {
+      requests = strtoul ( val, nullptr, 10 ) ; i++ ;
+    }
+    else if ( strcmp ( argv[i], "--conns" ) == 0 )
+    {
+      nconns = strtoul ( val, nullptr, 10 ) ; i++ ;
+    }
+    else if ( strcmp ( argv[i], "--heap" ) == 0 )
+    {
+      heap = strtoul ( val, nullptr, 10 ) ; i++ ;
+    }
+    else if ( strcmp ( argv[i], "--interval" ) == 0 )
+    {
+      interval = strtoul ( val, nullptr, 10 ) ; i++ ;
+    }
+    else if ( strcmp ( argv[i], "--csv" ) == 0 )
+    {
+      csvname = val ; i++ ;
+    }
+    else if ( strcmp ( argv[i], "--max-frag" ) == 0 )
+    {
+      maxfrag = atoi ( val ) ; i++ ;
+    }
+    else if ( strcmp ( argv[i], "--min-block" ) == 0 )
+    {
+      minblock = atol ( val ) ; i++ ;
+    }
+    else if ( strcmp ( argv[i], "--seed" ) == 0 )
+    {
+      rng.seed ( strtoul ( val, nullptr, 10 ) ) ; i++ ;
+    }
+    else
+    {
+      fprintf ( stderr, "Usage: %s [--requests n] [--conns n] [--heap bytes] "
+                "[--interval n] [--csv file] [--max-frag pct] [--min-block bytes] "
+                "[--seed n]\n", argv[0] ) ;
+      return 2 ;
+    }
+  }
+  if ( nconns == 0 || interval == 0 || heap < 4096 || heap > 0x7FFF * 8 )
+  {
+    fprintf ( stderr, "Bad option value\n" ) ;
+    return 2 ;
+  }
+  if ( csvname && ( csv = fopen ( csvname, "w" ) ) == nullptr )
+  {
+    perror ( csvname ) ;
+    return 2 ;
+  }
+  soak_init ( heap ) ;
+  hal_set_free_heap ( freeheap ) ;
+  hal_console_enable ( false ) ;
+  conns.resize ( nconns ) ;
+  boot() ;
+  minfree = soak_heap->freeBytes() ;
+  minmaxblk = soak_heap->maxFreeBlock() ;
+  printf ( "%10s %8s %8s %5s %8s %6s\n",
+           "Requests", "Free", "MaxBlock", "Frag", "Failures", "Log" ) ;
+  if ( csv )
+  {
+    fprintf ( csv, "requests,free,maxblock,frag,failures,loglines\n" ) ;
+  }
+  while ( done < requests )
+  {
+    size_t maxblk ;
+    int    frag ;
+    try
+    {
+      if ( ! conn_step ( &conns[rng() % nconns] ) )
+      {
+        minfree = std::min ( minfree, soak_heap->freeBytes() ) ;
+        continue ;
+      }
+    }
+    catch ( std::bad_alloc& )                                 // "new" failed, ESP would reset
+    {
+      hal_use_heap ( false ) ;
+      crashed = true ;
+      break ;
+    }
+    done++ ;                                                  // A request completed
+    maxblk = soak_heap->maxFreeBlock() ;
+    frag = soak_heap->fragmentation() ;
+    minmaxblk = std::min ( minmaxblk, maxblk ) ;
+    peakfrag = std::max ( peakfrag, frag ) ;
+    if ( ( done % interval ) == 0 )                           // Time to report?
+    {
+      printf ( "%10zu %8zu %8zu %4d%% %8zu %6zu\n", done, soak_heap->freeBytes(),
+               maxblk, frag, soak_heap->failures(), (size_t)dbgcount ) ;
+      if ( csv )
+      {
+        fprintf ( csv, "%zu,%zu,%zu,%d,%zu,%zu\n", done, soak_heap->freeBytes(),
+                  maxblk, frag, soak_heap->failures(), (size_t)dbgcount ) ;
+      }
+    }
+  }
+  if ( csv )
+  {
+    fclose ( csv ) ;
+  }
+  printf ( "\n%zu requests, %zu connections, heap %zu bytes\n", done, nconns, heap ) ;
+  printf ( "Lowest free heap       %zu\n", minfree ) ;
+  printf ( "Smallest largest block %zu\n", minmaxblk ) ;
+  printf ( "Highest fragmentation  %d%%\n", peakfrag ) ;
+  printf ( "Failed allocations     %zu\n", soak_heap->failures() ) ;
+  if ( soak_heap->failures() )
+  {
+    printf ( "Last failed size       %zu\n", soak_failsize ) ;
+  }
+  fail = crashed ;
+  if ( crashed )
+  {
+    printf ( "FAIL: out of memory in new, the controller would reset\n" ) ;
+  }
+  if ( maxfrag >= 0 && peakfrag > maxfrag )
+  {
+    printf ( "FAIL: fragmentation %d%% above %d%%\n", peakfrag, maxfrag ) ;
+    fail = true ;
+  }
+  if ( minblock >= 0 && (long)minmaxblk < minblock )
+  {
+    printf ( "FAIL: largest free block %zu below %ld\n", minmaxblk, minblock ) ;
+    fail = true ;
+  }
+  fflush ( stdout ) ;
+  _exit ( fail ? 1 : 0 ) ;                                    // Skip destructors of the model
+}
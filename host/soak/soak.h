@@ -0,0 +1,23 @@
+//******************************************************************************************
+// soak.h - Heap fragmentation soak test of the firmware on the host.                     *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef SOAK_H
+#define SOAK_H
+
+#include "umm_model.h"
+#include "native/hal_native.h"
+
+extern UmmHeap* soak_heap ;                                   // Model of the ESP8266 heap
+extern size_t   soak_failsize ;                               // Size of last failed request
+
+void            soak_init ( size_t size ) ;                   // Create and install the model
+
+struct ModelScope                                             // Use the model in a scope
+{
+  ModelScope()                                 { hal_use_heap ( true ) ; }
+  ~ModelScope()                                { hal_use_heap ( false ) ; }
+} ;
+
+#endif
@@ -0,0 +1,60 @@
+//******************************************************************************************
+// soak_alloc.cpp - Route heap allocations of the firmware to the umm_malloc model.       *
+//******************************************************************************************
+// The model is installed as replacement heap of the host HAL (native/alloc_native.cpp).   *
+// Inside a ModelScope new memory comes from the model; at other times (the harness        *
+// itself, stdio) from glibc.                                                              *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "soak.h"
+#include "native/hal_native.h"
+
+UmmHeap* soak_heap = nullptr ;                                // The model
+size_t   soak_failsize = 0 ;                                  // Size of last failed request
+
+
+static void* model_malloc ( size_t size )
+{
+  void* p ;
+
+  if ( ( p = soak_heap->malloc ( size ) ) == nullptr )
+  {
+    soak_failsize = size ;
+  }
+  return p ;
+}
+
+
+static void* model_realloc ( void* ptr, size_t size )
+{
+  void* p ;
+
+  if ( ( p = soak_heap->realloc ( ptr, size ) ) == nullptr )
+  {
+    soak_failsize = size ;
+  }
+  return p ;
+}
+
+
+static void model_free ( void* ptr )
+{
+  soak_heap->free ( ptr ) ;
+}
+
+
+static bool model_owns ( const void* ptr )
+{
+  return soak_heap->owns ( ptr ) ;
+}
+
+
+static const hal_heap_t model = { model_malloc, model_realloc, model_free, model_owns } ;
+
+
+void soak_init ( size_t size )
+{
+  soak_heap = new UmmHeap ( size ) ;
+  hal_set_heap ( &model ) ;
+}
@@ -0,0 +1,316 @@
+//******************************************************************************************
+// umm_model.cpp - Model of the umm_malloc heap of the ESP8266 Arduino core.              *
+//******************************************************************************************
+// Block 0 is the head of the free list, the last block ends the heap.  The names of the   *
+// functions follow umm_malloc.c.                                                          *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "umm_model.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+UmmHeap::UmmHeap ( size_t size )
+{
+  uint16_t last ;
+
+  _nblocks = size / BLOCKSIZE ;
+  last = _nblocks - 1 ;
+  _next.assign ( _nblocks, 0 ) ;
+  _prev.assign ( _nblocks, 0 ) ;
+  _nfree.assign ( _nblocks, 0 ) ;
+  _pfree.assign ( _nblocks, 0 ) ;
+  _data = (uint8_t*)aligned_alloc ( SHADOWSIZE, (size_t)_nblocks * SHADOWSIZE ) ;
+  _nfree[0] = _pfree[0] = 1 ;                                 // Free list: only block 1
+  _next[0] = 1 ;
+  _next[1] = last | FREEMASK ;                                // One big free run
+  _nfree[1] = _pfree[1] = 0 ;
+  _next[last] = 0 ;                                           // End of heap
+  _prev[last] = 1 ;
+}
+
+
+//******************************************************************************************
+// Number of blocks needed for size bytes: 4 bytes in the first block, 8 in the others.    *
+//******************************************************************************************
+uint16_t UmmHeap::blocksFor ( size_t size )
+{
+  if ( size <= 4 )
+  {
+    return 1 ;
+  }
+  return 2 + ( size - 4 - 1 ) / BLOCKSIZE ;
+}
+
+
+uint16_t UmmHeap::blockOf ( const void* ptr ) const
+{
+  return ( (const uint8_t*)ptr - _data ) / SHADOWSIZE ;
+}
+
+
+void* UmmHeap::ptrOf ( uint16_t c ) const
+{
+  return _data + (size_t)c * SHADOWSIZE ;
+}
+
+
+bool UmmHeap::owns ( const void* ptr ) const
+{
+  return ( (const uint8_t*)ptr >= _data ) &&
+         ( (const uint8_t*)ptr < _data + (size_t)_nblocks * SHADOWSIZE ) ;
+}
+
+
+void UmmHeap::disconnect ( uint16_t c )
+{
+  _nfree[_pfree[c]] = _nfree[c] ;
+  _pfree[_nfree[c]] = _pfree[c] ;
+  _next[c] &= ~FREEMASK ;
+}
+
+
+void UmmHeap::split ( uint16_t c, uint16_t blocks, uint16_t freemask )
+{
+  uint16_t n = c + blocks ;
+
+  _next[n] = ( _next[c] & NUMMASK ) | freemask ;
+  _prev[n] = c ;
+  _prev[_next[c] & NUMMASK] = n ;
+  _next[c] = n ;
+}
+
+
+void UmmHeap::assimilateUp ( uint16_t c )
+{
+  uint16_t n = _next[c] & NUMMASK ;
+
+  if ( _next[n] & FREEMASK )                                  // Next run free?
+  {
+    disconnect ( n ) ;                                        // Yes, merge
+    _prev[_next[n] & NUMMASK] = c ;
+    _next[c] = ( _next[n] & NUMMASK ) | ( _next[c] & FREEMASK ) ;
+  }
+}
+
+
+uint16_t UmmHeap::assimilateDown ( uint16_t c, uint16_t freemask )
+{
+  uint16_t p = _prev[c] ;
+
+  _next[p] = ( _next[c] & NUMMASK ) | freemask ;
+  _prev[_next[c] & NUMMASK] = p ;
+  return p ;
+}
+
+
+uint16_t UmmHeap::findBest ( uint16_t blocks ) const
+{
+  uint16_t cf = _nfree[0] ;
+  uint16_t best = 0 ;
+  uint16_t bestsize = NUMMASK ;
+
+  while ( cf )
+  {
+    uint16_t size = runSize ( cf ) ;
+    if ( ( size >= blocks ) && ( size < bestsize ) )
+    {
+      best = cf ;
+      bestsize = size ;
+      if ( size == blocks )                                   // Exact fit
+      {
+        break ;
+      }
+    }
+    cf = _nfree[cf] ;
+  }
+  return best ;
+}
+
+
+//******************************************************************************************
+// Allocate blocks from the start of free run cf.                                          *
+//******************************************************************************************
+void UmmHeap::take ( uint16_t cf, uint16_t blocks )
+{
+  uint16_t n = cf + blocks ;
+
+  if ( runSize ( cf ) == blocks )
+  {
+    disconnect ( cf ) ;
+  }
+  else
+  {
+    split ( cf, blocks, FREEMASK ) ;                          // Rest stays free
+    _nfree[_pfree[cf]] = n ;
+    _pfree[n] = _pfree[cf] ;
+    _pfree[_nfree[cf]] = n ;
+    _nfree[n] = _nfree[cf] ;
+  }
+}
+
+
+void* UmmHeap::malloc ( size_t size )
+{
+  uint16_t blocks ;
+  uint16_t cf ;
+
+  if ( size == 0 )
+  {
+    return nullptr ;
+  }
+  blocks = blocksFor ( size ) ;
+  cf = ( size < (size_t)NUMMASK * BLOCKSIZE ) ? findBest ( blocks ) : 0 ;
+  if ( cf == 0 )
+  {
+    _failures++ ;
+    return nullptr ;
+  }
+  take ( cf, blocks ) ;
+  return ptrOf ( cf ) ;
+}
+
+
+void UmmHeap::free ( void* ptr )
+{
+  uint16_t c ;
+
+  if ( ptr == nullptr )
+  {
+    return ;
+  }
+  c = blockOf ( ptr ) ;
+  assimilateUp ( c ) ;
+  if ( _next[_prev[c]] & FREEMASK )                           // Previous run free?
+  {
+    assimilateDown ( c, FREEMASK ) ;                          // Yes, merge with it
+  }
+  else
+  {
+    _pfree[_nfree[0]] = c ;                                   // No, add to free list
+    _nfree[c] = _nfree[0] ;
+    _pfree[c] = 0 ;
+    _nfree[0] = c ;
+    _next[c] |= FREEMASK ;
+  }
+}
+
+
+//******************************************************************************************
+// Grow or shrink in place if possible: use the next run, then the previous run (moving    *
+// the data down).  Otherwise allocate a new run, copy and free the old one.               *
+//******************************************************************************************
+void* UmmHeap::realloc ( void* ptr, size_t size )
+{
+  uint16_t c ;
+  uint16_t blocks ;
+  uint16_t cursize ;
+  uint16_t nextsize = 0 ;
+  uint16_t prevsize = 0 ;
+  size_t   curbytes ;
+  void*    p ;
+
+  if ( ptr == nullptr )
+  {
+    return malloc ( size ) ;
+  }
+  if ( size == 0 )
+  {
+    free ( ptr ) ;
+    return nullptr ;
+  }
+  c = blockOf ( ptr ) ;
+  blocks = blocksFor ( size ) ;
+  cursize = runSize ( c ) ;
+  curbytes = (size_t)cursize * BLOCKSIZE - 4 ;
+  if ( isFree ( _next[c] & NUMMASK ) )
+  {
+    nextsize = runSize ( _next[c] & NUMMASK ) ;
+  }
+  if ( isFree ( _prev[c] ) )
+  {
+    prevsize = runSize ( _prev[c] ) ;
+  }
+  if ( cursize + nextsize >= blocks )                         // Fits with next run?
+  {
+    assimilateUp ( c ) ;
+  }
+  else if ( prevsize + cursize + nextsize >= blocks )         // Fits with previous run?
+  {
+    uint16_t p = _prev[c] ;
+    assimilateUp ( c ) ;
+    disconnect ( p ) ;
+    c = assimilateDown ( c, 0 ) ;
+    memmove ( ptrOf ( c ), ptr, curbytes ) ;
+  }
+  else                                                        // No, new run
+  {
+    if ( ( p = malloc ( size ) ) == nullptr )
+    {
+      return nullptr ;
+    }
+    memcpy ( p, ptr, curbytes < size ? curbytes : size ) ;
+    free ( ptr ) ;
+    return p ;
+  }
+  if ( runSize ( c ) > blocks )                               // Give back the rest
+  {
+    split ( c, blocks, 0 ) ;
+    free ( ptrOf ( c + blocks ) ) ;
+  }
+  return ptrOf ( c ) ;
+}
+
+
+//******************************************************************************************
+//                                 S T A T I S T I C S                                     *
+//******************************************************************************************
+size_t UmmHeap::freeBytes() const
+{
+  size_t   n = 0 ;
+
+  for ( uint16_t cf = _nfree[0] ; cf ; cf = _nfree[cf] )
+  {
+    n += runSize ( cf ) ;
+  }
+  return n * BLOCKSIZE ;
+}
+
+
+size_t UmmHeap::maxFreeBlock() const
+{
+  uint16_t m = 0 ;
+
+  for ( uint16_t cf = _nfree[0] ; cf ; cf = _nfree[cf] )
+  {
+    if ( runSize ( cf ) > m )
+    {
+      m = runSize ( cf ) ;
+    }
+  }
+  return (size_t)m * BLOCKSIZE ;
+}
+
+
+//******************************************************************************************
+// 0 is no fragmentation, 100 is all free memory in single blocks (umm_fragmentation_metric)*
+//******************************************************************************************
+int UmmHeap::fragmentation() const
+{
+  double sum = 0 ;
+  double sq = 0 ;
+
+  for ( uint16_t cf = _nfree[0] ; cf ; cf = _nfree[cf] )
+  {
+    double s = runSize ( cf ) ;
+    sum += s ;
+    sq += s * s ;
+  }
+  if ( sum == 0 )
+  {
+    return 0 ;
+  }
+  return 100 - (int)( sqrt ( sq ) * 100 / sum ) ;
+}
@@ -0,0 +1,61 @@
+//******************************************************************************************
+// umm_model.h - Model of the umm_malloc heap of the ESP8266 Arduino core.                *
+//******************************************************************************************
+// The heap is an array of 8 byte blocks.  Every allocation takes a run of blocks; the     *
+// first 4 bytes are the header with the indexes of the next and previous run.  Free runs  *
+// are in a doubly linked free list.  malloc() takes the best fitting free run and splits   *
+// it, free() merges a run with free neighbours, realloc() grows in place if possible.     *
+// This is the algorithm of umm_malloc as configured in the ESP8266 core (UMM_BEST_FIT).   *
+//                                                                                         *
+// The bookkeeping is exact in blocks, but the data lives in a shadow area with 16 bytes   *
+// per block, so the host gets properly aligned memory for its (larger) objects.           *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef UMM_MODEL_H
+#define UMM_MODEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class UmmHeap
+{
+  public:
+    explicit UmmHeap ( size_t size ) ;                        // Heap size in bytes
+    void*    malloc ( size_t size ) ;
+    void     free ( void* ptr ) ;
+    void*    realloc ( void* ptr, size_t size ) ;
+    bool     owns ( const void* ptr ) const ;
+    size_t   freeBytes() const ;                              // Like ESP.getFreeHeap()
+    size_t   maxFreeBlock() const ;                           // Like ESP.getMaxFreeBlockSize()
+    int      fragmentation() const ;                          // Like ESP.getHeapFragmentation()
+    size_t   failures() const                    { return _failures ; }
+
+  private:
+    static const size_t   BLOCKSIZE  = 8 ;                    // Size of a block on the ESP
+    static const size_t   SHADOWSIZE = 16 ;                   // Size of a block on the host
+    static const uint16_t FREEMASK   = 0x8000 ;               // Flag for free run
+    static const uint16_t NUMMASK    = 0x7FFF ;
+    uint16_t              _nblocks ;
+    std::vector<uint16_t> _next ;                             // Header: next run | free flag
+    std::vector<uint16_t> _prev ;                             // Header: previous run
+    std::vector<uint16_t> _nfree ;                            // Free list, only for free runs
+    std::vector<uint16_t> _pfree ;
+    uint8_t*              _data ;                             // Shadow data area
+    size_t                _failures = 0 ;                     // Failed allocations
+
+    static uint16_t blocksFor ( size_t size ) ;
+    uint16_t        blockOf ( const void* ptr ) const ;
+    void*           ptrOf ( uint16_t c ) const ;
+    uint16_t        runSize ( uint16_t c ) const   { return ( _next[c] & NUMMASK ) - c ; }
+    bool            isFree ( uint16_t c ) const    { return _next[c] & FREEMASK ; }
+    void            disconnect ( uint16_t c ) ;
+    void            split ( uint16_t c, uint16_t blocks, uint16_t freemask ) ;
+    void            assimilateUp ( uint16_t c ) ;
+    uint16_t        assimilateDown ( uint16_t c, uint16_t freemask ) ;
+    uint16_t        findBest ( uint16_t blocks ) const ;
+    void            take ( uint16_t cf, uint16_t blocks ) ;
+} ;
+
+#endif
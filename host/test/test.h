@@ -0,0 +1,35 @@
+//******************************************************************************************
+// test.h - Small unit test framework for the host build.                                 *
+//******************************************************************************************
+// A test is a function that checks results with CHECK(), CHECK_EQ() and CHECK_STR().  A   *
+// failed check is printed with its file and line, the test continues.  The exit code is   *
+// 1 if any check failed.                                                                  *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Tests of the other modules                                             *
+//******************************************************************************************
+#ifndef TEST_H
+#define TEST_H
+
+#include <string.h>
+
+#define CHECK(c)          test_check ( ( c ), #c, __FILE__, __LINE__ )
+#define CHECK_EQ(a,b)     test_check ( ( a ) == ( b ), #a " == " #b, __FILE__, __LINE__ )
+#define CHECK_STR(a,b)    test_check ( strcmp ( ( a ), ( b ) ) == 0, #a " == " #b,    \
+                                       __FILE__, __LINE__ )
+
+bool test_check ( bool ok, const char* what,                  // Count a check, print it if
+                  const char* file, int line ) ;              // it failed
+void test_run ( const char* name, void ( *test )() ) ;        // Run a test
+int  test_report() ;                                          // Print totals, exit code
+
+void test_parse() ;                                           // The tests, one per module
+void test_journal() ;
+void test_settings() ;
+void test_fsindex() ;
+void test_http() ;
+void test_mime() ;
+void test_template() ;
+void test_admit() ;
+
+#endif
@@ -0,0 +1,90 @@
+//******************************************************************************************
+// test_admit.cpp - Tests of the admission control of the webserver.                      *
+//******************************************************************************************
+// 17-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "test.h"
+#include "admit.h"
+
+#define HEAP    ( ADMIT_MINHEAP * 4 )                         // Enough free memory
+#define T0      1000000U                                      // Start time of the tests
+#define IP(n)   ( 0x0A000000U + ( n ) )                       // 10.0.0.n
+
+
+//******************************************************************************************
+// Number of requests of a client that are admitted at time now, one after the other.      *
+//******************************************************************************************
+static int burst ( uint32_t ip, uint32_t now )
+{
+  int n = 0 ;
+
+  while ( admit_request ( ip, now, HEAP ) == ADMIT_OK )
+  {
+    admit_release() ;
+    n++ ;
+  }
+  return n ;
+}
+
+
+static void test_buckets()
+{
+  admit_stats_t before = admit_stats() ;
+  int           i ;
+
+  CHECK_EQ ( burst ( IP(1), T0 ), ADMIT_BURST ) ;             // New client, full bucket
+  CHECK_EQ ( admit_request ( IP(1), T0, HEAP ), ADMIT_LIMITED ) ;
+  CHECK_EQ ( admit_stats().accepted - before.accepted, (uint32_t)ADMIT_BURST ) ;
+  CHECK_EQ ( admit_stats().limited - before.limited, 2u ) ;
+  CHECK_EQ ( burst ( IP(2), T0 ), ADMIT_BURST ) ;             // Other client, own bucket
+  CHECK_EQ ( burst ( IP(1), T0 + 1000 / ADMIT_RATE - 1 ), 0 ) ;    // Not a whole token
+  CHECK_EQ ( burst ( IP(1), T0 + 1000 / ADMIT_RATE ), 1 ) ;        // One token later
+  CHECK_EQ ( burst ( IP(1), T0 + 1000 / ADMIT_RATE + 3000 / ADMIT_RATE ), 3 ) ;
+  CHECK_EQ ( burst ( IP(1), T0 + 100000 ), ADMIT_BURST ) ;    // Not more than a bucket
+  CHECK_EQ ( burst ( IP(1), T0 + 100000 ), 0 ) ;
+  for ( i = 0 ; i < ADMIT_CLIENTS ; i++ )                     // Other clients take all
+  {                                                           // buckets, also of IP(1)
+    CHECK_EQ ( burst ( IP(10 + i), T0 + 100001 + i ), ADMIT_BURST ) ;
+  }
+  CHECK_EQ ( burst ( IP(1), T0 + 100100 ), ADMIT_BURST ) ;    // New bucket, full again
+  CHECK_EQ ( admit_stats().active, before.active ) ;
+}
+
+
+static void test_limits()
+{
+  admit_stats_t before = admit_stats() ;
+  int           i ;
+
+  for ( i = 0 ; i < ADMIT_ACTIVE ; i++ )                      // Budget of the server
+  {
+    CHECK_EQ ( admit_request ( IP(100 + i), T0, HEAP ), ADMIT_OK ) ;
+  }
+  CHECK_EQ ( admit_stats().active, ADMIT_ACTIVE ) ;
+  CHECK_EQ ( admit_stats().peak, ADMIT_ACTIVE ) ;
+  CHECK_EQ ( admit_request ( IP(100), T0, HEAP ), ADMIT_BUSY ) ;
+  CHECK_EQ ( admit_stats().busy - before.busy, 1u ) ;
+  admit_release() ;
+  CHECK_EQ ( admit_request ( IP(100), T0, HEAP ), ADMIT_OK ) ;
+  for ( i = 0 ; i < ADMIT_ACTIVE ; i++ )
+  {
+    admit_release() ;
+  }
+  CHECK_EQ ( admit_stats().active, 0 ) ;
+  admit_release() ;                                           // Never below 0
+  CHECK_EQ ( admit_stats().active, 0 ) ;
+  CHECK_EQ ( admit_request ( IP(100), T0, ADMIT_MINHEAP - 1 ), ADMIT_LOWHEAP ) ;
+  CHECK_EQ ( admit_stats().lowheap - before.lowheap, 1u ) ;
+  CHECK_EQ ( admit_stats().active, 0 ) ;
+  admit_command ( true ) ;
+  admit_command ( false ) ;
+  CHECK_EQ ( admit_stats().commands - before.commands, 1u ) ;
+  CHECK_EQ ( admit_stats().queuefull - before.queuefull, 1u ) ;
+}
+
+
+void test_admit()
+{
+  test_buckets() ;
+  test_limits() ;
+}
@@ -0,0 +1,97 @@
+//******************************************************************************************
+// test_fsindex.cpp - Tests of the index of the LittleFS in RAM.                          *
+//******************************************************************************************
+// 17-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "test.h"
+#include "fsindex.h"
+#include "native/hal_native.h"
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SAME1   "/f6059.txt"                                  // Same FNV-1a hash, 0x16fc162b
+#define SAME2   "/f264602.txt"
+
+
+static void test_hash()
+{
+  uint32_t size = 0 ;
+
+  fsindex_clear() ;
+  fsindex_add ( SAME1, 10 ) ;
+  CHECK_EQ ( fsindex_find ( SAME1, &size ), FSINDEX_YES ) ;
+  CHECK_EQ ( size, 10u ) ;
+  CHECK_EQ ( fsindex_find ( "f6059.txt", nullptr ), FSINDEX_YES ) ;  // '/' does not count
+  CHECK_EQ ( fsindex_find ( "/other.txt", nullptr ), FSINDEX_NO ) ;
+  fsindex_set ( SAME1, 11 ) ;
+  CHECK_EQ ( fsindex_find ( SAME1, &size ), FSINDEX_YES ) ;
+  CHECK_EQ ( size, 11u ) ;
+  fsindex_add ( SAME2, 20 ) ;                                 // Same hash, entry is shared
+  CHECK_EQ ( fsindex_count(), 1 ) ;
+  CHECK_EQ ( fsindex_find ( SAME1, &size ), FSINDEX_MAYBE ) ;
+  CHECK_EQ ( fsindex_find ( SAME2, &size ), FSINDEX_MAYBE ) ;
+  fsindex_set ( SAME2, 21 ) ;                                 // Stays shared
+  fsindex_remove ( SAME1 ) ;
+  CHECK_EQ ( fsindex_find ( SAME2, &size ), FSINDEX_MAYBE ) ;
+  fsindex_set ( "/a.txt", 5 ) ;                               // New file
+  CHECK_EQ ( fsindex_find ( "/a.txt", &size ), FSINDEX_YES ) ;
+  CHECK_EQ ( size, 5u ) ;
+  fsindex_remove ( "/a.txt" ) ;
+  CHECK_EQ ( fsindex_find ( "/a.txt", nullptr ), FSINDEX_NO ) ;
+  CHECK ( fsindex_complete() ) ;
+  fsindex_clear() ;
+  for ( int i = 0 ; i <= FSINDEX_SLOTS ; i++ )
+  {
+    char name[16] ;
+
+    snprintf ( name, sizeof(name), "/file%d", i ) ;
+    fsindex_add ( name, i ) ;
+  }
+  CHECK_EQ ( fsindex_count(), FSINDEX_SLOTS ) ;
+  CHECK ( ! fsindex_complete() ) ;
+}
+
+
+static void test_hal()
+{
+  char     hpath[300] ;
+  uint32_t size = 0 ;
+
+  hal_fs_begin() ;
+  CHECK ( fsindex_complete() ) ;
+  CHECK ( hal_fs_write ( SAME1, "0123456789", 10, false ) ) ;
+  CHECK_EQ ( fsindex_find ( SAME1, &size ), FSINDEX_YES ) ;
+  CHECK ( hal_fs_rename ( SAME1, SAME2 ) ) ;                  // Hash of "to" was not its own
+  CHECK_EQ ( fsindex_find ( SAME2, &size ), FSINDEX_YES ) ;
+  CHECK_EQ ( size, 10u ) ;
+  CHECK ( hal_fs_write ( SAME1, "0123456789", 10, false ) ) ; // Both now, shared
+  CHECK ( hal_fs_write ( SAME2, "01234", 5, false ) ) ;
+  CHECK_EQ ( fsindex_find ( SAME1, nullptr ), FSINDEX_MAYBE ) ;
+  CHECK_EQ ( hal_fs_size ( SAME1 ), 10 ) ;
+  CHECK_EQ ( hal_fs_size ( SAME2 ), 5 ) ;
+  CHECK ( hal_fs_remove ( SAME1 ) ) ;
+  CHECK ( ! hal_fs_exists ( SAME1 ) ) ;
+  CHECK ( hal_fs_exists ( SAME2 ) ) ;                         // Not lost with SAME1
+  CHECK_EQ ( hal_fs_size ( SAME2 ), 5 ) ;
+  CHECK ( hal_fs_rename ( SAME2, SAME1 ) ) ;
+  CHECK_EQ ( hal_fs_size ( SAME1 ), 5 ) ;
+  CHECK ( ! hal_fs_exists ( SAME2 ) ) ;
+  CHECK ( hal_fs_remove ( SAME1 ) ) ;
+  CHECK ( ! hal_fs_exists ( SAME1 ) ) ;
+  hal_fs_begin() ;                                            // Shared entry gone
+  CHECK_EQ ( fsindex_find ( SAME1, nullptr ), FSINDEX_NO ) ;
+  mkdir ( hal_fs_path ( "/sub", hpath, sizeof(hpath) ), 0755 ) ;
+  fsindex_set ( "/sub", 0 ) ;                                 // Cannot be removed as a file
+  CHECK ( ! hal_fs_remove ( "/sub" ) ) ;
+  CHECK ( hal_fs_exists ( "/sub" ) ) ;                        // Index still matches
+  rmdir ( hpath ) ;
+  hal_fs_begin() ;                                            // Index as it was
+}
+
+
+void test_fsindex()
+{
+  test_hash() ;
+  test_hal() ;
+}
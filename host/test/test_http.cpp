@@ -0,0 +1,267 @@
+//******************************************************************************************
+// test_http.cpp - Tests of the request handlers of the firmware.                         *
+//******************************************************************************************
+// The handlers are called without a connection, like in host/bench.  reply() gets the    *
+// status and the body of the response, then releases the request as the disconnect does. *
+//******************************************************************************************
+// 17-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "test.h"
+#include "../firmware.h"
+#include "admit.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+
+//******************************************************************************************
+// Status of the response, the body goes to text.                                          *
+//******************************************************************************************
+static int reply ( AsyncWebServerRequest* request, char* text = nullptr,
+                   size_t maxlen = 0 )
+{
+  AsyncWebServerResponse* response = request->response() ;
+  uint8_t                 buf[1460] ;
+  size_t                  total = 0 ;
+  size_t                  n ;
+  int                     code = 0 ;
+
+  if ( response )
+  {
+    code = response->code() ;
+    while ( ( ( n = response->fill ( buf, sizeof(buf) ) ) != 0 ) &&
+            ( n != RESPONSE_TRY_AGAIN ) )
+    {
+      if ( text && ( total + n < maxlen ) )
+      {
+        memcpy ( text + total, buf, n ) ;
+      }
+      total += n ;
+    }
+  }
+  if ( text && maxlen )
+  {
+    text[( total < maxlen ) ? total : maxlen - 1] = '\0' ;
+  }
+  request->clearResponse() ;
+  request_gone ( request ) ;
+  return code ;
+}
+
+
+//******************************************************************************************
+// getconf with the given If-None-Match header, nullptr for none.                          *
+//******************************************************************************************
+static int getconf ( const char* inm )
+{
+  AsyncWebServerRequest request ( "/getconf" ) ;
+
+  if ( inm )
+  {
+    request.addHeader ( "If-None-Match", inm ) ;
+  }
+  handle_getconf ( &request ) ;
+  return reply ( &request ) ;
+}
+
+
+static void test_etag()
+{
+  char tag[40] ;
+
+  CHECK_EQ ( getconf ( nullptr ), 200 ) ;                     // Makes confetag
+  CHECK_EQ ( getconf ( confetag.c_str() ), 304 ) ;
+  CHECK_EQ ( getconf ( "*" ), 304 ) ;
+  snprintf ( tag, sizeof(tag), "W/%s", confetag.c_str() ) ;
+  CHECK_EQ ( getconf ( tag ), 304 ) ;
+  snprintf ( tag, sizeof(tag), "\"1\", %s", confetag.c_str() ) ;
+  CHECK_EQ ( getconf ( tag ), 304 ) ;                         // Second one of a list
+  snprintf ( tag, sizeof(tag), "%sx", confetag.c_str() ) ;
+  CHECK_EQ ( getconf ( tag ), 200 ) ;                         // Longer tag
+  snprintf ( tag, sizeof(tag), "\"x%s", confetag.c_str() + 1 ) ;
+  CHECK_EQ ( getconf ( tag ), 200 ) ;
+  CHECK_EQ ( getconf ( "\"*\"" ), 200 ) ;                     // A tag, not "any"
+  CHECK_EQ ( getconf ( "" ), 200 ) ;
+}
+
+
+//******************************************************************************************
+// A batch with the given operations, the reply goes to text.                              *
+//******************************************************************************************
+static int batch ( const char* ops, char* text, size_t maxlen )
+{
+  AsyncWebServerRequest request ( "/batch" ) ;
+
+  request.addParam ( "ops", ops ) ;
+  handle_batch ( &request ) ;
+  return reply ( &request, text, maxlen ) ;
+}
+
+
+//******************************************************************************************
+// A batch with G shows the state as it is after the batch, before loop() applied it.  Its *
+// snapshot is taken first: if there is none the batch is not applied at all.              *
+//******************************************************************************************
+static void test_batch()
+{
+  AsyncWebServerRequest held[16] ;                            // Requests with a snapshot
+  char                  text[2048] ;
+  uint32_t              commands ;
+  int                   n ;
+  int                   i ;
+
+  CHECK_EQ ( batch ( "P:A9=55;O:10,20,5;G", text, sizeof(text) ), 200 ) ;
+  CHECK ( strstr ( text, "{\"ops\":3,\"changed\":1," ) == text ) ;
+  CHECK ( strstr ( text, "\"overrule\":{\"active\":true,\"A\":10,\"B\":20,"
+                         "\"remaining\":300}" ) ) ;
+  CHECK ( strstr ( text, "\"schedule\":{\"A\":[0,0,0,0,0,0,0,0,20,55," ) ) ;
+  run_commands() ;                                            // Now it is applied
+  CHECK_EQ ( batch ( "G", text, sizeof(text) ), 200 ) ;
+  CHECK ( strstr ( text, "\"schedule\":{\"A\":[0,0,0,0,0,0,0,0,20,55," ) ) ;
+  CHECK ( strstr ( text, "\"overrule\":{\"active\":true," ) ) ;
+  for ( n = 0 ; n < 16 ; n++ )                                // Take all snapshots
+  {
+    handle_state ( &held[n] ) ;
+    if ( held[n].response()->code() != 200 )
+    {
+      break ;
+    }
+  }
+  CHECK ( n < 16 ) ;
+  commands = admit_stats().commands ;
+  CHECK_EQ ( batch ( "P:A10=33;G", text, sizeof(text) ), 503 ) ;
+  CHECK_EQ ( admit_stats().commands, commands ) ;             // Not queued
+  CHECK_EQ ( batch ( "P:B10=34", text, sizeof(text) ), 200 ) ;  // No snapshot needed
+  CHECK_EQ ( admit_stats().commands, commands + 1 ) ;
+  for ( i = 0 ; i <= n ; i++ )
+  {
+    reply ( &held[i] ) ;
+  }
+  CHECK_EQ ( batch ( "P:A10=33;O:80", text, sizeof(text) ), 400 ) ;   // All or nothing
+  CHECK_EQ ( admit_stats().commands, commands + 1 ) ;
+  run_commands() ;
+  CHECK_EQ ( batch ( "G", text, sizeof(text) ), 200 ) ;
+  CHECK ( strstr ( text, "\"A\":[0,0,0,0,0,0,0,0,20,55,80," ) ) ;   // A10 not changed
+  CHECK ( strstr ( text, "\"B\":[0,0,0,0,0,0,0,0,10,30,34," ) ) ;
+}
+
+
+//******************************************************************************************
+// state_version as /api/state shows it now.                                               *
+//******************************************************************************************
+static long state_version()
+{
+  char        text[2048] ;
+  const char* p ;
+
+  batch ( "G", text, sizeof(text) ) ;
+  p = strstr ( text, "\"state_version\":" ) ;
+  return p ? atol ( p + 16 ) : -1 ;
+}
+
+
+//******************************************************************************************
+// A /wait for version, admitted first like AdmitHandler does.  Returns the status.        *
+//******************************************************************************************
+static int wait ( AsyncWebServerRequest* request, long version,
+                 const char* timeout = nullptr )
+{
+  static uint32_t ip = 0x0A010000 ;                           // Other client every time
+  char            num[12] ;
+
+  snprintf ( num, sizeof(num), "%ld", version ) ;
+  request->addParam ( "version", num ) ;
+  if ( timeout )
+  {
+    request->addParam ( "timeout", timeout ) ;
+  }
+  CHECK_EQ ( admit_request ( ip++, hal_millis(), hal_free_heap() ), ADMIT_OK ) ;
+  request->onDisconnect ( [request] ()
+                          {
+                            admit_release() ;
+                            request_gone ( request ) ;
+                          } ) ;
+  handle_wait ( request ) ;
+  return request->response() ? request->response()->code() : 0 ;
+}
+
+
+//******************************************************************************************
+// A parked /wait is answered when loop() changed the state and the filler is asked again. *
+// An answer at once counts as an active request until it is gone, a parked one does not.  *
+//******************************************************************************************
+static void test_wait()
+{
+  AsyncWebServerRequest now ( "/wait" ) ;                     // Answered at once
+  AsyncWebServerRequest timeout ( "/wait" ) ;                 // Time is up at once
+  AsyncWebServerRequest parked[16] ;
+  AsyncWebServerRequest again ( "/wait" ) ;
+  uint8_t               buf[1460] ;
+  char                  text[2048] ;
+  uint8_t               active ;
+  long                  version ;
+  size_t                len ;
+  int                   n ;
+  int                   i ;
+
+  loop() ;                                                    // Publish the batches
+  version = state_version() ;
+  CHECK ( version > 0 ) ;
+  active = admit_stats().active ;
+  CHECK_EQ ( wait ( &now, version - 1 ), 200 ) ;              // Older version
+  CHECK_EQ ( admit_stats().active, active + 1 ) ;             // Counts, not parked
+  CHECK ( now.response()->fill ( buf, sizeof(buf) ) != RESPONSE_TRY_AGAIN ) ;
+  now.disconnect() ;
+  CHECK_EQ ( admit_stats().active, active ) ;
+  CHECK_EQ ( wait ( &timeout, version, "0" ), 200 ) ;
+  CHECK ( timeout.response()->fill ( buf, sizeof(buf) ) != RESPONSE_TRY_AGAIN ) ;
+  timeout.disconnect() ;
+  for ( n = 0 ; n < 16 ; n++ )                                // Park until no room
+  {
+    if ( wait ( &parked[n], version ) != 200 )
+    {
+      break ;
+    }
+    CHECK_EQ ( parked[n].response()->fill ( buf, sizeof(buf) ), RESPONSE_TRY_AGAIN ) ;
+  }
+  CHECK_EQ ( n, 4 ) ;                                         // WAIT_CLIENTS
+  CHECK_EQ ( parked[n].response()->code(), 503 ) ;
+  CHECK_EQ ( admit_stats().active, active + 1 ) ;             // Only the refused one
+  parked[n].disconnect() ;
+  CHECK_EQ ( admit_stats().active, active ) ;
+  loop() ;                                                    // No change, still waiting
+  CHECK_EQ ( parked[0].response()->fill ( buf, sizeof(buf) ), RESPONSE_TRY_AGAIN ) ;
+  CHECK_EQ ( batch ( "O:11,22", text, sizeof(text) ), 200 ) ;
+  loop() ;                                                    // Change published
+  CHECK_EQ ( state_version(), version + 1 ) ;
+  len = parked[0].response()->fill ( buf, sizeof(buf) - 1 ) ;
+  CHECK ( ( len > 0 ) && ( len < sizeof(buf) ) ) ;
+  buf[len < sizeof(buf) ? len : 0] = '\0' ;
+  CHECK ( strstr ( (const char*)buf,
+                   "\"overrule\":{\"active\":true,\"A\":11,\"B\":22," ) ) ;
+  CHECK_EQ ( wait ( &again, version + 1 ), 200 ) ;            // Room again
+  CHECK_EQ ( again.response()->fill ( buf, sizeof(buf) ), RESPONSE_TRY_AGAIN ) ;
+  again.disconnect() ;
+  for ( i = 0 ; i < n ; i++ )
+  {
+    parked[i].disconnect() ;
+  }
+  CHECK_EQ ( admit_stats().active, active ) ;
+  for ( i = 0 ; i < n ; i++ )                                 // All entries free again
+  {
+    AsyncWebServerRequest request ( "/wait" ) ;
+
+    CHECK_EQ ( wait ( &request, version + 1 ), 200 ) ;
+    request.disconnect() ;
+  }
+  CHECK_EQ ( batch ( "C", text, sizeof(text) ), 200 ) ;       // No overrule for the rest
+  loop() ;
+}
+
+
+void test_http()
+{
+  load_settings() ;
+  test_etag() ;
+  test_batch() ;
+  test_wait() ;
+}
@@ -0,0 +1,228 @@
+//******************************************************************************************
+// test_journal.cpp - Tests of the journal of settings, also after a power failure.       *
+//******************************************************************************************
+// 17-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "test.h"
+#include "journal.h"
+#include "hal.h"
+#include "crc.h"
+#include <signal.h>
+#include <sys/resource.h>
+
+#define RECLEN      ( 12 + 8 + 4 )                            // Record with 8 bytes data
+
+static uint8_t fbuf[JOURNAL_SIZE] ;                           // Copy of a journal file
+
+
+//******************************************************************************************
+// Save 8 bytes that all have the value v.                                                 *
+//******************************************************************************************
+static bool save ( uint8_t v )
+{
+  uint8_t data[8] ;
+
+  memset ( data, v, sizeof(data) ) ;
+  return journal_save ( data, sizeof(data) ) ;
+}
+
+
+//******************************************************************************************
+// Load the journal, returns the value of the record found, -1 if there is none.           *
+//******************************************************************************************
+static int load()
+{
+  uint8_t data[16] ;
+  size_t  len = 0 ;
+
+  if ( ! journal_load ( data, sizeof(data), &len ) )
+  {
+    return -1 ;
+  }
+  return ( len == 8 ) ? data[7] : -2 ;
+}
+
+
+//******************************************************************************************
+// Start without journal files, like a new device.                                         *
+//******************************************************************************************
+static void clean()
+{
+  hal_fs_remove ( JOURNAL_FILE ) ;
+  hal_fs_remove ( JOURNAL_NEW ) ;
+  load() ;                                                    // Forget the last record
+}
+
+
+//******************************************************************************************
+// Replace a file by its first len bytes, as a cut off write leaves it.                    *
+//******************************************************************************************
+static void cut ( const char* path, size_t len )
+{
+  hal_fs_read ( path, 0, fbuf, len ) ;
+  hal_fs_write ( path, fbuf, len, false ) ;
+}
+
+
+static void test_empty()
+{
+  clean() ;
+  CHECK_EQ ( load(), -1 ) ;                                   // No file at all
+  CHECK_EQ ( journal_seq(), 0u ) ;
+  CHECK ( save ( 1 ) ) ;
+  CHECK ( save ( 2 ) ) ;
+  CHECK ( save ( 2 ) ) ;                                      // Same data, not written
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), 2 * RECLEN ) ;
+  CHECK_EQ ( load(), 2 ) ;
+  CHECK_EQ ( journal_seq(), 2u ) ;
+  CHECK ( save ( 2 ) ) ;                                      // Still known after load
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), 2 * RECLEN ) ;
+  hal_fs_write ( JOURNAL_FILE, fbuf, 0, false ) ;             // Empty file
+  CHECK_EQ ( load(), -1 ) ;
+  CHECK_EQ ( journal_seq(), 0u ) ;
+}
+
+
+static void test_truncated()
+{
+  for ( size_t len = 2 * RECLEN ; len < 3 * RECLEN ; len++ )  // Every cut in the last one
+  {
+    clean() ;
+    save ( 1 ) ;
+    save ( 2 ) ;
+    save ( 3 ) ;
+    cut ( JOURNAL_FILE, len ) ;
+    CHECK_EQ ( load(), 2 ) ;
+    CHECK_EQ ( journal_seq(), 2u ) ;
+  }
+  CHECK ( save ( 4 ) ) ;                                      // Damaged end is replaced
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), RECLEN ) ;
+  CHECK_EQ ( load(), 4 ) ;
+  CHECK_EQ ( journal_seq(), 3u ) ;
+}
+
+
+static void test_badcrc()
+{
+  long size ;
+
+  clean() ;
+  save ( 1 ) ;
+  save ( 2 ) ;
+  size = hal_fs_size ( JOURNAL_FILE ) ;
+  hal_fs_read ( JOURNAL_FILE, 0, fbuf, size ) ;
+  fbuf[size - 1] ^= 0x01 ;                                    // CRC of the last record
+  hal_fs_write ( JOURNAL_FILE, fbuf, size, false ) ;
+  CHECK_EQ ( load(), 1 ) ;
+  CHECK ( save ( 2 ) ) ;                                      // Not the same as record 1
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), RECLEN ) ;
+  CHECK_EQ ( load(), 2 ) ;
+  fbuf[size - RECLEN + 14] ^= 0x01 ;                          // Data of the last record
+  fbuf[size - 1] ^= 0x01 ;                                    // and the CRC as it was
+  hal_fs_write ( JOURNAL_FILE, fbuf, size, false ) ;
+  CHECK_EQ ( load(), 1 ) ;
+  fbuf[0] ^= 0x01 ;                                           // Magic of the first record
+  hal_fs_write ( JOURNAL_FILE, fbuf, size, false ) ;
+  CHECK_EQ ( load(), -1 ) ;
+}
+
+
+static void test_compact()
+{
+  int n = JOURNAL_SIZE / RECLEN ;                             // Records that fit
+
+  clean() ;
+  for ( int i = 1 ; i <= n ; i++ )
+  {
+    save ( i ) ;
+  }
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), n * RECLEN ) ;
+  CHECK ( save ( n + 1 ) ) ;                                  // Does not fit
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), RECLEN ) ;         // Only the new one
+  CHECK ( ! hal_fs_exists ( JOURNAL_NEW ) ) ;
+  CHECK_EQ ( load(), n + 1 ) ;
+  CHECK_EQ ( journal_seq(), (uint32_t)( n + 1 ) ) ;           // Numbers go on
+  CHECK ( save ( n + 2 ) ) ;
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), 2 * RECLEN ) ;
+  CHECK_EQ ( load(), n + 2 ) ;
+}
+
+
+static void test_leftover()
+{
+  long size ;
+
+  clean() ;                                                   // Power failed before the
+                                                              // rename of a compaction
+  save ( 5 ) ;
+  hal_fs_rename ( JOURNAL_FILE, JOURNAL_NEW ) ;
+  CHECK_EQ ( load(), 5 ) ;
+  CHECK ( hal_fs_exists ( JOURNAL_FILE ) ) ;
+  CHECK ( ! hal_fs_exists ( JOURNAL_NEW ) ) ;
+  clean() ;                                                   // Power failed while the new
+                                                              // journal was written
+  save ( 6 ) ;
+  size = hal_fs_size ( JOURNAL_FILE ) ;
+  hal_fs_read ( JOURNAL_FILE, 0, fbuf, size ) ;
+  hal_fs_write ( JOURNAL_NEW, fbuf, size - 5, false ) ;
+  save ( 7 ) ;
+  CHECK_EQ ( load(), 7 ) ;                                    // Old journal is used
+  CHECK ( ! hal_fs_exists ( JOURNAL_NEW ) ) ;
+  CHECK ( save ( 8 ) ) ;
+  CHECK_EQ ( load(), 8 ) ;
+  CHECK_EQ ( journal_seq(), 3u ) ;
+}
+
+
+static void test_failed_append()
+{
+  struct rlimit lim ;
+  long          size ;
+
+  clean() ;
+  save ( 1 ) ;
+  size = hal_fs_size ( JOURNAL_FILE ) ;
+  signal ( SIGXFSZ, SIG_IGN ) ;                               // Short write, no signal
+  getrlimit ( RLIMIT_FSIZE, &lim ) ;
+  lim.rlim_cur = size + 10 ;                                  // Room for a part of a record
+  setrlimit ( RLIMIT_FSIZE, &lim ) ;
+  CHECK ( ! save ( 2 ) ) ;
+  lim.rlim_cur = lim.rlim_max ;
+  setrlimit ( RLIMIT_FSIZE, &lim ) ;
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), size + 10 ) ;      // Part of the record written
+  CHECK ( save ( 3 ) ) ;                                      // Not after the part
+  CHECK_EQ ( load(), 3 ) ;
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), RECLEN ) ;
+}
+
+
+static void test_same_crc()
+{
+  static const uint8_t a[8] = { 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05 } ;
+  static const uint8_t b[8] = { 0x44, 0x03, 0x74, 0xDE, 0x04, 0x05, 0x05, 0x05 } ;
+  uint8_t              data[16] ;
+  size_t               len = 0 ;
+
+  CHECK_EQ ( crc32 ( a, 8 ), crc32 ( b, 8 ) ) ;               // Same CRC, other data
+  clean() ;
+  CHECK ( journal_save ( a, 8 ) ) ;
+  CHECK ( journal_save ( b, 8 ) ) ;
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), 2 * RECLEN ) ;     // Not taken for the same
+  CHECK ( journal_load ( data, sizeof(data), &len ) ) ;
+  CHECK ( ( len == 8 ) && ( memcmp ( data, b, 8 ) == 0 ) ) ;
+  CHECK ( journal_save ( b, 8 ) ) ;                           // Really the same
+  CHECK_EQ ( hal_fs_size ( JOURNAL_FILE ), 2 * RECLEN ) ;
+}
+
+
+void test_journal()
+{
+  test_empty() ;
+  test_truncated() ;
+  test_badcrc() ;
+  test_compact() ;
+  test_leftover() ;
+  test_failed_append() ;
+  test_same_crc() ;
+  clean() ;
+}
@@ -0,0 +1,66 @@
+//******************************************************************************************
+// test_main.cpp - Unit tests of the firmware on the host.                                *
+//******************************************************************************************
+// Build and run:                                                                          *
+//   pio run -e test                                                                       *
+//   .pio/build/test/program                                                               *
+// The firmware is not started with setup(); every test initializes what it needs.  The    *
+// files are in a new temporary directory (AQ_HOST_DIR is ignored), so a test never sees   *
+// the EEPROM or LittleFS of an earlier run.                                               *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Tests of the other modules                                             *
+//******************************************************************************************
+#include "test.h"
+#include "native/hal_native.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int  checks ;                                          // Checks done
+static int  failed ;                                          // Checks failed
+static bool current ;                                         // Current test has failed
+
+
+bool test_check ( bool ok, const char* what, const char* file, int line )
+{
+  checks++ ;
+  if ( ! ok )
+  {
+    failed++ ;
+    current = true ;
+    fprintf ( stderr, "  FAILED %s:%d: %s\n", file, line, what ) ;
+  }
+  return ok ;
+}
+
+
+void test_run ( const char* name, void ( *test )() )
+{
+  current = false ;
+  test() ;
+  fprintf ( stderr, "%-10s %s\n", name, current ? "FAILED" : "ok" ) ;
+}
+
+
+int test_report()
+{
+  fprintf ( stderr, "%d checks, %d failed\n", checks, failed ) ;
+  return failed ? 1 : 0 ;
+}
+
+
+int main()
+{
+  unsetenv ( "AQ_HOST_DIR" ) ;                                // Always a new directory
+  hal_console_enable ( false ) ;
+  hal_fs_begin() ;                                            // LittleFS from data/
+  test_run ( "parse", test_parse ) ;
+  test_run ( "journal", test_journal ) ;
+  test_run ( "settings", test_settings ) ;
+  test_run ( "fsindex", test_fsindex ) ;
+  test_run ( "http", test_http ) ;
+  test_run ( "mime", test_mime ) ;
+  test_run ( "template", test_template ) ;
+  test_run ( "admit", test_admit ) ;
+  return test_report() ;
+}
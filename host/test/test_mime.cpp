@@ -0,0 +1,55 @@
+//******************************************************************************************
+// test_mime.cpp - Tests of the content types and the files that are never served.       *
+//******************************************************************************************
+// 17-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "test.h"
+#include "mimetype.h"
+
+static char type[MIME_TYPELEN] ;                              // Result of mime_type()
+
+
+static void test_types()
+{
+  CHECK_STR ( mime_type ( "/style.css", type ), "text/css" ) ;
+  CHECK_STR ( mime_type ( "/logo.gif", type ), "image/gif" ) ;
+  CHECK_STR ( mime_type ( "/index.html", type ), "text/html" ) ;
+  CHECK_STR ( mime_type ( "/app.1a2b3c4d.js", type ), "application/javascript" ) ;
+  CHECK_STR ( mime_type ( "/api.json", type ), "application/json" ) ;   // Not js
+  CHECK_STR ( mime_type ( "/a.zip", type ), "application/x-zip" ) ;
+  CHECK_STR ( mime_type ( "/a.svg", type ), "image/svg+xml" ) ;
+  CHECK_STR ( mime_type ( "/INDEX.HTML", type ), "text/html" ) ;       // Any case
+  CHECK_STR ( mime_type ( "/Logo.Gif", type ), "image/gif" ) ;
+  CHECK_STR ( mime_type ( "/about.txt", type ), "text/plain" ) ;       // Not in the table
+  CHECK_STR ( mime_type ( "/a.htmlx", type ), "text/plain" ) ;         // Too long
+  CHECK_STR ( mime_type ( "/a.htm", type ), "text/plain" ) ;
+  CHECK_STR ( mime_type ( "/README", type ), "text/plain" ) ;          // No extension
+  CHECK_STR ( mime_type ( "/dir.css/file", type ), "text/plain" ) ;
+  CHECK_STR ( mime_type ( "/a.", type ), "text/plain" ) ;
+  CHECK_STR ( mime_type ( "", type ), "text/plain" ) ;
+  CHECK ( mime_type ( "/a.css", type ) == type ) ;
+}
+
+
+static void test_denied()
+{
+  CHECK ( mime_denied ( "/ADSL-11.pw" ) ) ;
+  CHECK ( mime_denied ( "/NET.PW" ) ) ;                       // Any case
+  CHECK ( mime_denied ( "/settings.jnl" ) ) ;
+  CHECK ( mime_denied ( "/settings.jnl.new" ) ) ;
+  CHECK ( mime_denied ( "/upload.tmp" ) ) ;
+  CHECK ( mime_denied ( ".pw" ) ) ;
+  CHECK ( ! mime_denied ( "/index.html" ) ) ;
+  CHECK ( ! mime_denied ( "/a.pwx" ) ) ;
+  CHECK ( ! mime_denied ( "/pw" ) ) ;
+  CHECK ( ! mime_denied ( "" ) ) ;
+  CHECK_STR ( mime_type ( "/ADSL-11.pw", type ), "" ) ;       // No type at all
+  CHECK_STR ( mime_type ( "/settings.jnl.new", type ), "" ) ;
+}
+
+
+void test_mime()
+{
+  test_types() ;
+  test_denied() ;
+}
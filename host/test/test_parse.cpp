@@ -0,0 +1,263 @@
+//******************************************************************************************
+// test_parse.cpp - Tests of the parsers of request parameters and bodies.                *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "test.h"
+#include "parse.h"
+
+static uint8_t     values[48] ;
+static parse_err_t err ;
+
+
+//******************************************************************************************
+// Parse a list with body_feed(), in parts of step bytes.                                  *
+//******************************************************************************************
+static bool body_list ( const char* text, size_t step, int n, int lo, int hi,
+                        bodyparse_t* bp )
+{
+  size_t len = strlen ( text ) ;
+
+  body_intlist ( bp, values, n, lo, hi ) ;
+  for ( size_t pos = 0 ; pos < len ; pos += step )
+  {
+    body_feed ( bp, text + pos, ( len - pos < step ) ? len - pos : step ) ;
+  }
+  return body_end ( bp ) ;
+}
+
+
+//******************************************************************************************
+// The same for a patch.                                                                   *
+//******************************************************************************************
+static bool body_change ( const char* text, size_t step, int hi, bodyparse_t* bp )
+{
+  size_t len = strlen ( text ) ;
+
+  body_patch ( bp, values, hi ) ;
+  for ( size_t pos = 0 ; pos < len ; pos += step )
+  {
+    body_feed ( bp, text + pos, ( len - pos < step ) ? len - pos : step ) ;
+  }
+  return body_end ( bp ) ;
+}
+
+
+static void test_intlist()
+{
+  const char* t ;
+
+  t = "1,2,3" ;
+  CHECK ( parse_intlist ( t, strlen ( t ), values, 3, 0, 100, &err ) ) ;
+  CHECK ( ( values[0] == 1 ) && ( values[1] == 2 ) && ( values[2] == 3 ) ) ;
+  CHECK_EQ ( err.pos, -1 ) ;
+  t = "1,2,3," ;                                              // Trailing comma
+  CHECK ( parse_intlist ( t, strlen ( t ), values, 3, 0, 100, &err ) ) ;
+  t = "0,100" ;                                               // Limits
+  CHECK ( parse_intlist ( t, strlen ( t ), values, 2, 0, 100, &err ) ) ;
+  t = "1,2" ;
+  CHECK ( ! parse_intlist ( t, strlen ( t ), values, 3, 0, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 3 ) ;
+  CHECK_STR ( err.msg, "too few values" ) ;
+  t = "1,2,3,4" ;
+  CHECK ( ! parse_intlist ( t, strlen ( t ), values, 3, 0, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 6 ) ;
+  CHECK_STR ( err.msg, "too many values" ) ;
+  t = "1,101" ;
+  CHECK ( ! parse_intlist ( t, strlen ( t ), values, 2, 0, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 2 ) ;
+  CHECK_STR ( err.msg, "value out of range" ) ;
+  t = "1,5" ;                                                 // Below lo
+  CHECK ( ! parse_intlist ( t, strlen ( t ), values, 2, 10, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 0 ) ;
+  t = "1,99999999999999999999" ;                              // No overflow
+  CHECK ( ! parse_intlist ( t, strlen ( t ), values, 2, 0, 255, &err ) ) ;
+  CHECK_STR ( err.msg, "value out of range" ) ;
+  t = "1,,2" ;
+  CHECK ( ! parse_intlist ( t, strlen ( t ), values, 3, 0, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 2 ) ;
+  CHECK_STR ( err.msg, "number expected" ) ;
+  t = "1;2" ;
+  CHECK ( ! parse_intlist ( t, strlen ( t ), values, 2, 0, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 1 ) ;
+  CHECK_STR ( err.msg, "comma expected" ) ;
+  t = "-1,2" ;
+  CHECK ( ! parse_intlist ( t, strlen ( t ), values, 2, 0, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 0 ) ;
+  CHECK ( ! parse_intlist ( "", 0, values, 1, 0, 100, &err ) ) ;
+  CHECK_STR ( err.msg, "too few values" ) ;
+}
+
+
+static void test_patch()
+{
+  const char* t ;
+
+  memset ( values, 0, sizeof(values) ) ;
+  t = "A8-17=80,b8=40," ;
+  CHECK ( parse_patch ( t, strlen ( t ), values, 100, &err ) ) ;
+  CHECK ( ( values[7 * 2] == 0 ) && ( values[8 * 2] == 80 ) && ( values[17 * 2] == 80 ) ) ;
+  CHECK ( ( values[18 * 2] == 0 ) && ( values[8 * 2 + 1] == 40 ) ) ;
+  CHECK ( ( values[9 * 2 + 1] == 0 ) ) ;
+  t = "A0-23=100" ;                                           // Limits
+  CHECK ( parse_patch ( t, strlen ( t ), values, 100, &err ) ) ;
+  CHECK ( ( values[0] == 100 ) && ( values[46] == 100 ) ) ;
+  CHECK ( ! parse_patch ( "", 0, values, 100, &err ) ) ;
+  CHECK_STR ( err.msg, "nothing to change" ) ;
+  t = "C8=1" ;
+  CHECK ( ! parse_patch ( t, strlen ( t ), values, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 0 ) ;
+  CHECK_STR ( err.msg, "lamp A or B expected" ) ;
+  t = "A24=1" ;
+  CHECK ( ! parse_patch ( t, strlen ( t ), values, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 1 ) ;
+  CHECK_STR ( err.msg, "hour out of range" ) ;
+  t = "A9-8=1" ;                                              // Range backwards
+  CHECK ( ! parse_patch ( t, strlen ( t ), values, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 3 ) ;
+  CHECK_STR ( err.msg, "hour out of range" ) ;
+  t = "A8=101" ;
+  CHECK ( ! parse_patch ( t, strlen ( t ), values, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 3 ) ;
+  CHECK_STR ( err.msg, "value out of range" ) ;
+  t = "A8" ;
+  CHECK ( ! parse_patch ( t, strlen ( t ), values, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 2 ) ;
+  CHECK_STR ( err.msg, "'=' expected" ) ;
+  t = "A=5" ;
+  CHECK ( ! parse_patch ( t, strlen ( t ), values, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 1 ) ;
+  CHECK_STR ( err.msg, "hour expected" ) ;
+  t = "A8=5;B8=5" ;
+  CHECK ( ! parse_patch ( t, strlen ( t ), values, 100, &err ) ) ;
+  CHECK_EQ ( err.pos, 4 ) ;
+  CHECK_STR ( err.msg, "comma expected" ) ;
+}
+
+
+static void test_batch()
+{
+  batch_t     b ;
+  const char* t ;
+  char        many[80] = "" ;
+
+  t = "P:A8=40;O:80,60,30;G" ;
+  CHECK ( parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( b.flags, BATCH_SET | BATCH_OVERRULE | BATCH_STATE ) ;
+  CHECK ( ( b.ops == 3 ) && ( b.ovA == 80 ) && ( b.ovB == 60 ) && ( b.ovmin == 30 ) ) ;
+  CHECK_EQ ( values[16], 40 ) ;
+  t = "o:80,60;" ;                                            // No end, trailing ';'
+  CHECK ( parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK ( ( b.flags == BATCH_OVERRULE ) && ( b.ovmin == 0 ) ) ;
+  t = "O:80,60," ;                                            // Trailing comma
+  CHECK ( parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK ( ( b.ovA == 80 ) && ( b.ovB == 60 ) && ( b.ovmin == 0 ) ) ;
+  t = "O:80,60,1440" ;
+  CHECK ( parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( b.ovmin, 1440 ) ;
+  t = "O:80,60;C" ;                                           // Later one counts
+  CHECK ( parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( b.flags, BATCH_CLEAR ) ;
+  for ( int i = 0 ; i < BATCH_MAXOPS ; i++ )
+  {
+    strcat ( many, "G;" ) ;
+  }
+  CHECK ( parse_batch ( many, strlen ( many ), values, 100, &b, &err ) ) ;
+  strcat ( many, "G" ) ;
+  CHECK ( ! parse_batch ( many, strlen ( many ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( err.pos, 2 * BATCH_MAXOPS ) ;
+  CHECK_STR ( err.msg, "too many operations" ) ;
+  CHECK ( ! parse_batch ( "", 0, values, 100, &b, &err ) ) ;
+  CHECK_STR ( err.msg, "no operations" ) ;
+  t = "G;X" ;
+  CHECK ( ! parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( err.pos, 2 ) ;
+  CHECK_STR ( err.msg, "operation P, O, C or G expected" ) ;
+  t = "Gx" ;
+  CHECK ( ! parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( err.pos, 1 ) ;
+  CHECK_STR ( err.msg, "';' expected" ) ;
+  t = "G;P" ;
+  CHECK ( ! parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( err.pos, 3 ) ;
+  CHECK_STR ( err.msg, "':' expected" ) ;
+  t = "G;P:A8=101" ;                                          // Position in whole text
+  CHECK ( ! parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( err.pos, 7 ) ;
+  CHECK_STR ( err.msg, "value out of range" ) ;
+  t = "G;O:80" ;
+  CHECK ( ! parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( err.pos, 6 ) ;
+  CHECK_STR ( err.msg, "too few values" ) ;
+  t = "O:80,60,1441" ;
+  CHECK ( ! parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( err.pos, 8 ) ;
+  CHECK_STR ( err.msg, "minutes out of range" ) ;
+  t = "O:80,60,5x" ;
+  CHECK ( ! parse_batch ( t, strlen ( t ), values, 100, &b, &err ) ) ;
+  CHECK_EQ ( err.pos, 9 ) ;
+  CHECK_STR ( err.msg, "minutes expected" ) ;
+}
+
+
+static void test_body()
+{
+  bodyparse_t bp ;
+  const char* t = "10,20,30," ;
+
+  for ( size_t step = 1 ; step <= strlen ( t ) ; step++ )     // Split anywhere
+  {
+    CHECK ( body_list ( t, step, 3, 0, 100, &bp ) ) ;
+    CHECK ( ( values[0] == 10 ) && ( values[1] == 20 ) && ( values[2] == 30 ) ) ;
+  }
+  CHECK ( body_list ( "10,20,30\r\n", 1, 3, 0, 100, &bp ) ) ; // Line end after the body
+  CHECK ( body_list ( "10,20,30\n", 4, 3, 0, 100, &bp ) ) ;
+  CHECK ( ! body_list ( "10,20\n,30", 1, 3, 0, 100, &bp ) ) ;
+  CHECK_EQ ( bp.err.pos, 6 ) ;
+  CHECK_STR ( bp.err.msg, "end expected" ) ;
+  CHECK ( ! body_list ( "10,20\n", 2, 3, 0, 100, &bp ) ) ;
+  CHECK_EQ ( bp.err.pos, 5 ) ;
+  CHECK_STR ( bp.err.msg, "too few values" ) ;
+  CHECK ( ! body_list ( "10,20,30,40", 3, 3, 0, 100, &bp ) ) ;
+  CHECK_EQ ( bp.err.pos, 9 ) ;
+  CHECK_STR ( bp.err.msg, "too many values" ) ;
+  CHECK ( ! body_list ( "10,2000", 5, 2, 0, 100, &bp ) ) ;   // Error in last number
+  CHECK_EQ ( bp.err.pos, 3 ) ;
+  CHECK_STR ( bp.err.msg, "value out of range" ) ;
+  CHECK ( ! body_list ( "10,x", 1, 2, 0, 100, &bp ) ) ;
+  CHECK_EQ ( bp.err.pos, 3 ) ;
+  CHECK_STR ( bp.err.msg, "number expected" ) ;
+  t = "A8-17=80,B8=40" ;
+  for ( size_t step = 1 ; step <= strlen ( t ) ; step++ )
+  {
+    memset ( values, 0, sizeof(values) ) ;
+    CHECK ( body_change ( t, step, 100, &bp ) ) ;
+    CHECK ( ( values[8 * 2] == 80 ) && ( values[17 * 2] == 80 ) ) ;
+    CHECK ( ( values[8 * 2 + 1] == 40 ) && ( values[9 * 2 + 1] == 0 ) ) ;
+  }
+  CHECK ( body_change ( "A8=1,\r\n", 3, 100, &bp ) ) ;
+  CHECK ( ! body_change ( "\n", 1, 100, &bp ) ) ;
+  CHECK_EQ ( bp.err.pos, 0 ) ;
+  CHECK_STR ( bp.err.msg, "nothing to change" ) ;
+  CHECK ( ! body_change ( "A9-8=1", 2, 100, &bp ) ) ;         // Same as parse_patch()
+  CHECK_EQ ( bp.err.pos, 3 ) ;
+  CHECK_STR ( bp.err.msg, "hour out of range" ) ;
+  CHECK ( ! body_change ( "A8=101", 4, 100, &bp ) ) ;
+  CHECK_EQ ( bp.err.pos, 3 ) ;
+  CHECK_STR ( bp.err.msg, "value out of range" ) ;
+  CHECK ( ! body_change ( "A8\n", 1, 100, &bp ) ) ;
+  CHECK_EQ ( bp.err.pos, 2 ) ;
+  CHECK_STR ( bp.err.msg, "'=' expected" ) ;
+  CHECK ( ! body_change ( "A8=5;", 1, 100, &bp ) ) ;
+  CHECK_EQ ( bp.err.pos, 4 ) ;
+  CHECK_STR ( bp.err.msg, "comma expected" ) ;
+}
+
+
+void test_parse()
+{
+  test_intlist() ;
+  test_patch() ;
+  test_batch() ;
+  test_body() ;
+}
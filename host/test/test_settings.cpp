@@ -0,0 +1,159 @@
+//******************************************************************************************
+// test_settings.cpp - Tests of the settings at boot: journal, EEPROM or defaults.        *
+//******************************************************************************************
+// 17-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "test.h"
+#include "../firmware.h"
+#include "native/hal_native.h"
+#include "journal.h"
+#include "parse.h"
+#include "crc.h"
+#include <stdio.h>
+
+#define SETMAGIC    0x53514141                                // As in main.cpp
+
+struct rec_t                                                  // Layout of setrec_t
+{
+  uint32_t magic ;
+  uint16_t layout ;
+  uint16_t len ;
+  uint32_t crc ;
+  uint8_t  values[48] ;
+} ;
+
+static uint8_t values[48] ;                                   // Settings to save
+static uint8_t result[48] ;                                   // Settings after the boot
+
+
+//******************************************************************************************
+// Write the EEPROM of an older firmware, nullptr for erased flash.                        *
+//******************************************************************************************
+static void eeprom ( const uint8_t* data )
+{
+  char  path[300] ;
+  FILE* f ;
+
+  snprintf ( path, sizeof(path), "%s/eeprom.bin", hal_host_dir() ) ;
+  remove ( path ) ;
+  if ( data && ( f = fopen ( path, "wb" ) ) )
+  {
+    fwrite ( data, 1, 48, f ) ;
+    fclose ( f ) ;
+  }
+}
+
+
+//******************************************************************************************
+// Write a journal with one record of values in the given layout.                          *
+//******************************************************************************************
+static void journal ( uint16_t layout, uint32_t crcxor )
+{
+  rec_t rec ;
+
+  hal_fs_remove ( JOURNAL_FILE ) ;
+  journal_load ( &rec, 0, nullptr ) ;                         // Forget the last record
+  rec.magic = SETMAGIC ;
+  rec.layout = layout ;
+  rec.len = sizeof(rec.values) ;
+  memcpy ( rec.values, values, sizeof(rec.values) ) ;
+  rec.crc = crc32 ( rec.values, sizeof(rec.values) ) ^ crcxor ;
+  journal_save ( &rec, sizeof(rec) ) ;
+}
+
+
+//******************************************************************************************
+// Boot: load the settings and get them back with /getconf.                                *
+//******************************************************************************************
+static const char* boot()
+{
+  AsyncWebServerRequest request ( "/getconf" ) ;
+  char                  text[300] ;
+  size_t                n = 0 ;
+  const char*           from ;
+  parse_err_t           err ;
+
+  savedue = false ;
+  from = load_settings() ;
+  memset ( result, 0xFF, sizeof(result) ) ;
+  handle_getconf ( &request ) ;
+  if ( request.response() )
+  {
+    n = request.response()->fill ( (uint8_t*)text, sizeof(text) ) ;
+  }
+  request.clearResponse() ;
+  CHECK ( parse_intlist ( text, n, result, 48, 0, 100, &err ) ) ;
+  return from ;
+}
+
+
+static void test_eeprom()
+{
+  static const uint8_t magic[48] = { 65, 65, 81, 83, 1, 2 } ;  // Starts like SETMAGIC
+
+  hal_fs_remove ( JOURNAL_FILE ) ;                            // Older firmware
+  eeprom ( values ) ;
+  CHECK_STR ( boot(), "EEPROM" ) ;
+  CHECK ( memcmp ( result, values, 48 ) == 0 ) ;
+  CHECK ( savedue ) ;                                         // Goes to the journal
+  eeprom ( magic ) ;
+  CHECK_STR ( boot(), "EEPROM" ) ;
+  CHECK ( memcmp ( result, magic, 48 ) == 0 ) ;
+  eeprom ( nullptr ) ;                                        // Erased flash
+  CHECK_STR ( boot(), "defaults" ) ;
+  CHECK ( ( result[0] == 0 ) && ( result[8 * 2] == 20 ) && ( result[12 * 2] == 80 ) ) ;
+  CHECK ( savedue ) ;
+}
+
+
+static void test_journal_layouts()
+{
+  uint8_t bad[48] ;
+
+  eeprom ( nullptr ) ;
+  journal ( 1, 0 ) ;                                          // Current layout
+  CHECK_STR ( boot(), "journal" ) ;
+  CHECK ( memcmp ( result, values, 48 ) == 0 ) ;
+  CHECK ( ! savedue ) ;                                       // Nothing to convert
+  hal_fs_remove ( JOURNAL_FILE ) ;                            // Bare set_t, layout 0
+  journal_load ( bad, 0, nullptr ) ;
+  journal_save ( values, 48 ) ;
+  CHECK_STR ( boot(), "journal" ) ;
+  CHECK ( memcmp ( result, values, 48 ) == 0 ) ;
+  CHECK ( savedue ) ;                                         // Saved in layout 1
+  journal ( 2, 0 ) ;                                          // Newer firmware was here
+  CHECK_STR ( boot(), "defaults" ) ;
+  journal ( 1, 0x00010000 ) ;                                 // Bad CRC
+  CHECK_STR ( boot(), "defaults" ) ;
+  eeprom ( values ) ;                                         // Older than the journal
+  CHECK_STR ( boot(), "defaults" ) ;
+  journal ( 0, 0 ) ;                                          // Header with layout 0
+  CHECK_STR ( boot(), "defaults" ) ;
+  hal_fs_remove ( JOURNAL_FILE ) ;                            // EEPROM only without journal
+  CHECK_STR ( boot(), "EEPROM" ) ;
+  CHECK ( memcmp ( result, values, 48 ) == 0 ) ;
+  memcpy ( bad, values, sizeof(bad) ) ;                       // Value out of range
+  bad[47] = 101 ;
+  eeprom ( bad ) ;
+  hal_fs_remove ( JOURNAL_FILE ) ;
+  CHECK_STR ( boot(), "defaults" ) ;
+  memset ( bad, 0xFF, sizeof(bad) ) ;                         // Erased, as bare journal
+  hal_fs_remove ( JOURNAL_FILE ) ;
+  journal_load ( bad, 0, nullptr ) ;
+  journal_save ( bad, 48 ) ;
+  eeprom ( nullptr ) ;
+  CHECK_STR ( boot(), "defaults" ) ;
+}
+
+
+void test_settings()
+{
+  for ( int i = 0 ; i < 48 ; i++ )
+  {
+    values[i] = ( i * 37 ) % 101 ;
+  }
+  test_eeprom() ;
+  test_journal_layouts() ;
+  eeprom ( nullptr ) ;
+  hal_fs_remove ( JOURNAL_FILE ) ;
+}
@@ -0,0 +1,144 @@
+//******************************************************************************************
+// test_template.cpp - Tests of the templates that are sent part by part.                 *
+//******************************************************************************************
+// 17-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "test.h"
+#include "template.h"
+#include "hal.h"
+#include <string>
+
+static const char page[] = "<p>%A% and %B%, %C% is not a field, 100%% %B%</p>%A%" ;
+static const char full[] = "<p>first and second, %C% is not a field, 100%% second</p>first" ;
+static const char* const names[] = { "A", "B" } ;
+static size_t      bytesread ;                                // Bytes read from page
+static size_t      readlimit ;                                // Reads beyond are short
+
+
+static size_t read_page ( const void* src, size_t offset, uint8_t* buf, size_t len )
+{
+  const char* p = (const char*)src ;
+
+  if ( offset + len > readlimit )                             // Page "changed"?
+  {
+    len = offset < readlimit ? readlimit - offset : 0 ;
+  }
+  memcpy ( buf, p + offset, len ) ;
+  bytesread += len ;
+  return len ;
+}
+
+
+static size_t read_file ( const void* src, size_t offset, uint8_t* buf, size_t len )
+{
+  return hal_fs_pread ( *(const int*)src, offset, buf, len ) ;
+}
+
+
+static void fill ( uint8_t field, TemplateWriter& out, const void* ctx )
+{
+  out.puts ( field == 0 ? "first" : "second" ) ;
+}
+
+
+//******************************************************************************************
+// Render the whole page in chunks of at most maxLen bytes.                                *
+//******************************************************************************************
+static std::string render ( const tpl_t* tpl, tplcur_t* cur, size_t maxLen )
+{
+  uint8_t     buf[64] ;
+  std::string s ;
+  size_t      n ;
+
+  while ( ( n = tpl_render ( tpl, cur, fill, nullptr, buf, maxLen, s.size() ) ) > 0 )
+  {
+    if ( n == TPL_ERROR )
+    {
+      return "error" ;
+    }
+    s.append ( (const char*)buf, n ) ;
+  }
+  return s ;
+}
+
+
+static void test_chunks()
+{
+  tpl_t       tpl ;
+  tplcur_t    cur ;
+  uint8_t     buf[64] ;
+  size_t      text ;                                          // Bytes of page not a field
+  size_t      n ;
+
+  readlimit = sizeof(page) ;
+  CHECK ( tpl_compile ( &tpl, read_page, page, strlen ( page ), names, 2 ) ) ;
+  CHECK_EQ ( tpl.nfields, 4 ) ;
+  text = strlen ( page ) - 3 * 3 - 3 ;                        // %A% %B% %B% %A%
+  for ( size_t len = 1 ; len <= sizeof(buf) ; len++ )
+  {
+    bytesread = 0 ;
+    tpl_begin ( &cur, page ) ;
+    CHECK_STR ( render ( &tpl, &cur, len ).c_str(), full ) ;
+    CHECK_EQ ( bytesread, text ) ;                            // Every byte read once
+  }
+  tpl_begin ( &cur, page ) ;                                  // Chunk not in order
+  n = tpl_render ( &tpl, &cur, fill, nullptr, buf, 10, 0 ) ;
+  CHECK_EQ ( n, 10u ) ;
+  n = tpl_render ( &tpl, &cur, fill, nullptr, buf, 10, 20 ) ;
+  CHECK_EQ ( n, 10u ) ;
+  CHECK ( memcmp ( buf, full + 20, 10 ) == 0 ) ;
+  n = tpl_render ( &tpl, &cur, fill, nullptr, buf, 10, 5 ) ;
+  CHECK_EQ ( n, 10u ) ;
+  CHECK ( memcmp ( buf, full + 5, 10 ) == 0 ) ;
+  readlimit = 20 ;                                            // Short read
+  tpl_begin ( &cur, page ) ;
+  CHECK_STR ( render ( &tpl, &cur, 8 ).c_str(), "error" ) ;
+  tpl_begin ( &cur, page ) ;
+  n = tpl_render ( &tpl, &cur, fill, nullptr, buf, 8, 0 ) ;   // Before the end is fine
+  CHECK_EQ ( n, 8u ) ;
+  CHECK ( ! tpl_compile ( &tpl, read_page, page, strlen ( page ), names, 2 ) ) ;
+}
+
+
+static void test_file()
+{
+  tpl_t    tpl ;
+  tplcur_t cur ;
+  int      file ;
+  int      files[HAL_FS_FILES] ;
+  int      i ;
+
+  CHECK ( hal_fs_write ( "/page.tpl", page, strlen ( page ), false ) ) ;
+  file = hal_fs_open ( "/page.tpl" ) ;
+  CHECK ( file >= 0 ) ;
+  CHECK ( tpl_compile ( &tpl, read_file, &file, strlen ( page ), names, 2 ) ) ;
+  tpl_begin ( &cur, &file ) ;
+  CHECK_STR ( render ( &tpl, &cur, 7 ).c_str(), full ) ;
+  hal_fs_close ( file ) ;
+  CHECK ( hal_fs_open ( "/nothere.tpl" ) < 0 ) ;
+  for ( i = 0 ; i < HAL_FS_FILES ; i++ )                      // Table of open files full
+  {
+    files[i] = hal_fs_open ( "/page.tpl" ) ;
+    CHECK ( files[i] >= 0 ) ;
+  }
+  CHECK ( hal_fs_open ( "/page.tpl" ) < 0 ) ;
+  hal_fs_close ( files[0] ) ;
+  CHECK_EQ ( hal_fs_open ( "/page.tpl" ), files[0] ) ;         // Free again
+  for ( i = 0 ; i < HAL_FS_FILES ; i++ )
+  {
+    hal_fs_close ( files[i] ) ;
+  }
+  CHECK ( hal_fs_write ( "/page.tpl", page, 20, false ) ) ;   // Shorter than compiled
+  file = hal_fs_open ( "/page.tpl" ) ;
+  tpl_begin ( &cur, &file ) ;
+  CHECK_STR ( render ( &tpl, &cur, 7 ).c_str(), "error" ) ;
+  hal_fs_close ( file ) ;
+  hal_fs_remove ( "/page.tpl" ) ;
+}
+
+
+void test_template()
+{
+  test_chunks() ;
+  test_file() ;
+}
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+#******************************************************************************************
+# confbin.py - Read or write the configuration of a device through /conf.bin.             *
+#******************************************************************************************
+# Usage: confbin.py get HOST [FILE]                                                        *
+#        confbin.py put HOST FILE|v1,v2,...,v48                                            *
+# get prints the 48 settings, or saves the raw confbin_t in FILE.  put sends a saved file  *
+# or a list of 48 values.  HOST may include a port, like "localhost:8080".                 *
+# The layout is confbin_t in main.cpp: magic, version, count, maximum, 48 values, CRC-32.  *
+#******************************************************************************************
+# 16-10-2026, AG - First setup                                                             *
+#******************************************************************************************
+import struct
+import sys
+import urllib.request
+import zlib
+
+CONFMAGIC   = 0x434C5141
+CONFVERSION = 1
+HEAD        = struct.Struct ( "<IBBH48B" )                  # Everything before the CRC
+
+
+def pack ( values ) :
+    data = HEAD.pack ( CONFMAGIC, CONFVERSION, 48, 100, *values )
+    return data + struct.pack ( "<I", zlib.crc32 ( data ) )
+
+
+def unpack ( data ) :
+    if len ( data ) != HEAD.size + 4 :
+        sys.exit ( "Wrong size %d" % len ( data ) )
+    fields = HEAD.unpack ( data[:HEAD.size] )
+    crc, = struct.unpack ( "<I", data[HEAD.size:] )
+    if fields[0] != CONFMAGIC or fields[1] != CONFVERSION or crc != zlib.crc32 ( data[:HEAD.size] ) :
+        sys.exit ( "Not a valid confbin_t" )
+    return list ( fields[4:] )
+
+
+def main() :
+    if len ( sys.argv ) < 3 or sys.argv[1] not in ( "get", "put" ) :
+        sys.exit ( __doc__ or "Usage: confbin.py get|put HOST [FILE|VALUES]" )
+    url = "http://%s/conf.bin" % sys.argv[2]
+    if sys.argv[1] == "get" :
+        data = urllib.request.urlopen ( url ).read()
+        values = unpack ( data )
+        if len ( sys.argv ) > 3 :
+            with open ( sys.argv[3], "wb" ) as f :
+                f.write ( data )
+        else :
+            print ( ",".join ( str ( v ) for v in values ) )
+        return
+    arg = sys.argv[3]
+    if "," in arg :
+        data = pack ( [ int ( v ) for v in arg.split ( "," ) if v != "" ] )
+    else :
+        with open ( arg, "rb" ) as f :
+            data = f.read()
+        unpack ( data )                                     # Check before sending
+    req = urllib.request.Request ( url, data = data, method = "POST",
+                                   headers = { "Content-Type" : "application/octet-stream" } )
+    try :
+        print ( urllib.request.urlopen ( req ).read().decode() )
+    except urllib.error.HTTPError as e :
+        sys.exit ( e.read().decode() )
+
+
+if __name__ == "__main__" :
+    main()
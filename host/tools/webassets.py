@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+#******************************************************************************************
+# webassets.py - Prepare the files of data/ for the LittleFS image.                       *
+#******************************************************************************************
+# Usage: webassets.py [SRCDIR [DSTDIR [HEADER]]]   (default data and .pio/webdata)         *
+# Text files are stored gzipped as NAME.gz if that is smaller; the firmware sends them     *
+# with "Content-Encoding: gzip".  Stylesheets, scripts and images get the CRC-32 of their  *
+# contents in the name (style.css -> style.1a2b3c4d.css) and the references in the HTML    *
+# pages are changed to match.  The firmware lets browsers cache such files forever, a new  *
+# version simply has a new name.  HTML pages and favicon.ico keep their names.             *
+# Templates, pages with fields the firmware fills in (see src/template.h), are never       *
+# gzipped.                                                                                 *
+# Used by PlatformIO as extra script for the esp12e environment: the LittleFS image is     *
+# then made from DSTDIR.  For the host build point AQ_DATA_DIR to DSTDIR.                  *
+# With HEADER, or in an environment with AQ_EMBED_ASSETS, the web files are also written   *
+# as PROGMEM arrays with a table sorted on path, for src/embassets.h.                      *
+# Nothing is done if no file of SRCDIR (nor this script) is newer than DSTDIR.stamp, and   *
+# the header is only written if it changes, so a build without changes in data/ does not   *
+# compile main.cpp again.                                                                  *
+#******************************************************************************************
+# 16-10-2026, AG - First setup                                                             *
+# 17-10-2026, AG - Only done when data/ changed, header only written if it changed         *
+#******************************************************************************************
+import gzip
+import os
+import re
+import shutil
+import sys
+import zlib
+
+GZIP_TYPES   = ( ".html", ".css", ".js", ".txt", ".ico", ".svg", ".json" )
+HASHED_TYPES = ( ".css", ".js", ".gif", ".png", ".jpg" )
+SECRET_TYPES = ( ".pw", ".jnl" )                            # Copied as is, never embedded
+TEMPLATES    = ( "index.html", )                            # Filled by the firmware
+CONTENT_TYPES = { ".html" : "text/html", ".png" : "image/png", ".gif" : "image/gif",
+                  ".jpg" : "image/jpeg", ".ico" : "image/x-icon", ".css" : "text/css",
+                  ".zip" : "application/x-zip", ".js" : "application/javascript",
+                  ".json" : "application/json", ".svg" : "image/svg+xml" }   # As mimetype.cpp
+
+
+def hashed_name ( name, data ) :
+    base, ext = os.path.splitext ( name )
+    return "%s.%08x%s" % ( base, zlib.crc32 ( data ), ext )
+
+
+def store ( dst, name, data ) :
+    if name.endswith ( GZIP_TYPES ) and name not in TEMPLATES :
+        gz = gzip.compress ( data, 9, mtime=0 )              # Same input, same output
+        if len ( gz ) < len ( data ) * 9 // 10 :             # Worth it?
+            name, data = name + ".gz", gz
+    with open ( os.path.join ( dst, name ), "wb" ) as f :
+        f.write ( data )
+    return name, data
+
+
+def write_header ( path, stored ) :
+    lines = [ "// Generated by host/tools/webassets.py, do not edit.", "" ]
+    table = []
+    for i, ( name, data ) in enumerate ( stored ) :
+        gz = name.endswith ( ".gz" )
+        url = "/" + ( name[:-3] if gz else name )
+        ct = CONTENT_TYPES.get ( os.path.splitext ( url )[1], "text/plain" )
+        lines.append ( "static const uint8_t asset_%d[] PROGMEM =                // %s" % ( i, name ) )
+        lines.append ( "{" )
+        for j in range ( 0, len ( data ), 16 ) :
+            lines.append ( "  " + "".join ( "0x%02x," % b for b in data[j:j+16] ) )
+        lines.append ( "} ;" )
+        table.append ( ( url, '  { "%s", "%s", asset_%d, %d, "\\"%08x\\"", %s, %s },' %
+                       ( url, ct, i, len ( data ), zlib.crc32 ( data ),
+                         "true" if gz else "false",
+                         "true" if re.search ( r"\.[0-9a-f]{8}\.[^.]+$", url ) else "false" ) ) )
+    lines.append ( "" )
+    lines.append ( "static constexpr embasset_t embassets[] =                  // Sorted on path" )
+    lines.append ( "{" )
+    lines.extend ( line for url, line in sorted ( table ) )
+    lines.append ( "} ;" )
+    text = "\n".join ( lines ) + "\n"
+    if os.path.isfile ( path ) :
+        with open ( path ) as f :
+            if f.read() == text :                           # Same, keep the time stamp
+                print ( "%d files embedded in %s, not changed" % ( len ( stored ), path ) )
+                return
+    os.makedirs ( os.path.dirname ( os.path.abspath ( path ) ), exist_ok=True )
+    with open ( path, "w" ) as f :
+        f.write ( text )
+    print ( "%d files embedded in %s" % ( len ( stored ), path ) )
+
+
+def up_to_date ( src, dst, header, script ) :
+    stamp = dst + ".stamp"
+    if not ( os.path.isfile ( stamp ) and os.path.isdir ( dst ) ) or \
+       ( header and not os.path.isfile ( header ) ) :
+        return False
+    inputs = [ src, script ] + [ os.path.join ( src, name ) for name in os.listdir ( src ) ]
+    newest = max ( os.path.getmtime ( path ) for path in inputs )   # src: added or removed
+    return newest < os.path.getmtime ( stamp )
+
+
+def build ( src, dst, header=None, script=__file__ if "__file__" in globals() else "" ) :
+    files = {}
+    renames = {}
+    stamp = dst + ".stamp"
+    if script and up_to_date ( src, dst, header, script ) :
+        print ( "Web files in %s up to date" % dst )
+        return
+    if os.path.isdir ( dst ) :
+        shutil.rmtree ( dst )
+    os.makedirs ( dst )
+    for name in sorted ( os.listdir ( src ) ) :
+        path = os.path.join ( src, name )
+        if os.path.isfile ( path ) and not name.startswith ( "." ) :
+            with open ( path, "rb" ) as f :
+                files[name] = f.read()
+    for name, data in files.items() :
+        if name.endswith ( HASHED_TYPES ) :
+            renames[name] = hashed_name ( name, data )
+    total = 0
+    stored = []
+    for name, data in files.items() :
+        if name.endswith ( ".html" ) :                      # Use the new names
+            for old, new in renames.items() :
+                data = re.sub ( rb"""(href|src)=(['"])%s\2""" % re.escape ( old.encode() ),
+                                rb"\1=\2" + new.encode() + rb"\2", data )
+        if name.endswith ( SECRET_TYPES ) :
+            out, size = name, len ( data )
+            shutil.copyfile ( os.path.join ( src, name ), os.path.join ( dst, name ) )
+        else :
+            out, outdata = store ( dst, renames.get ( name, name ), data )
+            size = len ( outdata )
+            stored.append ( ( out, outdata ) )
+        total += size
+        print ( "%-32s %6d -> %-32s %6d" % ( name, len ( files[name] ), out, size ) )
+    print ( "%d files, %d bytes" % ( len ( files ), total ) )
+    if header :
+        write_header ( header, stored )
+    with open ( stamp, "w" ) as f :                         # Done with these inputs
+        f.write ( "%s\n" % src )
+
+
+try :                                                       # Called by PlatformIO?
+    Import ( "env" )                                        # noqa: F821
+except NameError :
+    if __name__ == "__main__" :
+        build ( sys.argv[1] if len ( sys.argv ) > 1 else "data",
+                sys.argv[2] if len ( sys.argv ) > 2 else ".pio/webdata",
+                sys.argv[3] if len ( sys.argv ) > 3 else None )
+else :
+    header = None
+    if "AQ_EMBED_ASSETS" in str ( env.get ( "CPPDEFINES", [] ) ) :   # noqa: F821
+        header = env.subst ( "$BUILD_DIR/gen/webassets_gen.h" )     # noqa: F821
+        env.Append ( CPPPATH=[ env.subst ( "$BUILD_DIR/gen" ) ] )   # noqa: F821
+    build ( env.subst ( "$PROJECT_DATA_DIR" ),             # noqa: F821
+            env.subst ( "$BUILD_DIR/webdata" ), header,    # noqa: F821
+            env.subst ( "$PROJECT_DIR/host/tools/webassets.py" ) )   # noqa: F821
+    env.Replace ( PROJECT_DATA_DIR=env.subst ( "$BUILD_DIR/webdata" ) )   # noqa: F821
@@ -0,0 +1,127 @@
+//******************************************************************************************
+// admit.cpp - Admission control for the webserver.                                       *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Commands counted as commands                                           *
+//******************************************************************************************
+#include "admit.h"
+
+#define TOKEN          1000                                   // A token in 1/1000 tokens, so
+                                                              // a bucket fills every msec
+
+struct bucket_t                                               // Token bucket of a client
+{
+  uint32_t        ip ;                                        // Address of the client
+  uint32_t        last ;                                      // Time of last request
+  uint32_t        tokens ;                                    // Tokens * TOKEN
+} ;
+
+static bucket_t       buckets[ADMIT_CLIENTS] ;                // Not sorted
+static uint8_t        nbuckets ;                              // Buckets in use
+static admit_stats_t  stats ;
+
+
+//******************************************************************************************
+// Find the bucket of a client, or take a new or the least recently used one.              *
+//******************************************************************************************
+static bucket_t* get_bucket ( uint32_t ip, uint32_t now )
+{
+  bucket_t* b ;
+  bucket_t* oldest = &buckets[0] ;
+  uint8_t   i ;
+
+  for ( i = 0 ; i < nbuckets ; i++ )
+  {
+    b = &buckets[i] ;
+    if ( b->ip == ip )
+    {
+      return b ;
+    }
+    if ( ( now - b->last ) > ( now - oldest->last ) )
+    {
+      oldest = b ;
+    }
+  }
+  b = ( nbuckets < ADMIT_CLIENTS ) ? &buckets[nbuckets++] : oldest ;
+  b->ip = ip ;
+  b->last = now ;
+  b->tokens = ADMIT_BURST * TOKEN ;                           // New client, full bucket
+  return b ;
+}
+
+
+//******************************************************************************************
+//                             A D M I T _ R E Q U E S T                                   *
+//******************************************************************************************
+// Check a new request.  If the result is ADMIT_OK, admit_release() must be called when    *
+// the request has ended.                                                                  *
+//******************************************************************************************
+uint8_t admit_request ( uint32_t ip, uint32_t now, uint32_t freeheap )
+{
+  bucket_t* b = get_bucket ( ip, now ) ;                      // Bucket of this client
+  uint32_t  elapsed = now - b->last ;                         // Time since last request
+
+  if ( elapsed > ADMIT_BURST * TOKEN / ADMIT_RATE )           // Long enough to fill it?
+  {
+    b->tokens = ADMIT_BURST * TOKEN ;                         // Yes, avoids an overflow
+  }
+  else
+  {
+    b->tokens += elapsed * ADMIT_RATE ;                       // TOKEN per sec is 1 per msec
+    if ( b->tokens > ADMIT_BURST * TOKEN )
+    {
+      b->tokens = ADMIT_BURST * TOKEN ;
+    }
+  }
+  b->last = now ;
+  if ( stats.active >= ADMIT_ACTIVE )
+  {
+    stats.busy++ ;
+    return ADMIT_BUSY ;
+  }
+  if ( b->tokens < TOKEN )
+  {
+    stats.limited++ ;
+    return ADMIT_LIMITED ;
+  }
+  if ( freeheap < ADMIT_MINHEAP )
+  {
+    stats.lowheap++ ;
+    return ADMIT_LOWHEAP ;
+  }
+  b->tokens -= TOKEN ;
+  stats.accepted++ ;
+  if ( ++stats.active > stats.peak )
+  {
+    stats.peak = stats.active ;
+  }
+  return ADMIT_OK ;
+}
+
+
+void admit_release()
+{
+  if ( stats.active )
+  {
+    stats.active-- ;
+  }
+}
+
+
+void admit_command ( bool ok )
+{
+  if ( ok )
+  {
+    stats.commands++ ;
+  }
+  else
+  {
+    stats.queuefull++ ;
+  }
+}
+
+
+const admit_stats_t& admit_stats()
+{
+  return stats ;
+}
@@ -0,0 +1,64 @@
+//******************************************************************************************
+// admit.h - Admission control for the webserver.                                         *
+//******************************************************************************************
+// Every request is checked when its head is complete, before the body and before any      *
+// handler allocates a response.  A request is refused if                                  *
+//  - ADMIT_ACTIVE requests are already being handled (the budget of the server),          *
+//  - the client has no token left: every client (IP address) has a bucket of              *
+//    ADMIT_BURST tokens that fills with ADMIT_RATE tokens per second, one per request,    *
+//  - the free heap is below ADMIT_MINHEAP.                                                *
+// A refused request gets a 503 with Retry-After.  The counters tell how often that        *
+// happens, so the limits can be set from measurements (see /api/state).                   *
+// Only the last ADMIT_CLIENTS clients have a bucket; a new client takes the bucket that   *
+// was used longest ago, and starts with a full bucket.                                    *
+// Requests are limited, not connections: the check needs the head, so a connection that   *
+// is still sending it does not count yet.  The library gives no earlier place to check.   *
+// Those connections are limited by the TCP stack: lwIP on the ESP8266 has a few TCP       *
+// connections (MEMP_NUM_TCP_PCB, 5 in the core) and refuses more.  The host server closes *
+// a connection that sends nothing for RXTIMEOUT.                                          *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Commands counted as commands, only parsed requests are limited         *
+//******************************************************************************************
+#ifndef ADMIT_H
+#define ADMIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ADMIT_ACTIVE        6                                 // Requests at the same time
+#define ADMIT_CLIENTS       8                                 // Clients with a token bucket
+#ifndef ADMIT_RATE                                            // The load test sets these
+#define ADMIT_RATE         10                                 // Tokens per second per client
+#define ADMIT_BURST        20                                 // Size of a bucket
+#endif
+#define ADMIT_MINHEAP    8192                                 // Free heap for a new request
+
+enum admit_result_t                                           // Result of admit_request()
+{
+  ADMIT_OK,                                                   // Go ahead
+  ADMIT_BUSY,                                                 // Too many active requests
+  ADMIT_LIMITED,                                              // Client has no tokens
+  ADMIT_LOWHEAP                                               // Not enough free memory
+} ;
+
+struct admit_stats_t                                          // Counters since boot
+{
+  uint32_t  accepted ;                                        // Requests admitted
+  uint32_t  commands ;                                        // Commands passed to loop()
+  uint32_t  busy ;                                            // Refused, see admit_result_t
+  uint32_t  limited ;
+  uint32_t  lowheap ;
+  uint32_t  queuefull ;                                       // Command queue was full
+  uint8_t   active ;                                          // Requests being handled
+  uint8_t   peak ;                                            // Highest value of active
+} ;
+
+uint8_t              admit_request ( uint32_t ip, uint32_t now,     // Check a new request,
+                                     uint32_t freeheap ) ;          // now in msec
+void                 admit_release() ;                        // Admitted request has ended
+void                 admit_command ( bool ok ) ;              // Command passed to loop() or
+                                                              // command queue full
+const admit_stats_t& admit_stats() ;
+
+#endif
@@ -0,0 +1,79 @@
+//******************************************************************************************
+// alloccount.cpp - Count heap allocations per subsystem.                                 *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "alloccount.h"
+
+#ifdef AQ_NATIVE
+thread_local uint8_t alloc_sub = ALLOC_SYS ;                  // Active subsystem per thread
+#else
+uint8_t              alloc_sub = ALLOC_SYS ;                  // Active subsystem
+#endif
+static uint32_t      counts[ALLOC_NSUB] ;                     // Allocations per subsystem
+
+
+void alloc_note()
+{
+#ifdef AQ_NATIVE
+  __atomic_fetch_add ( &counts[alloc_sub], 1, __ATOMIC_RELAXED ) ;   // Host has threads
+#else
+  counts[alloc_sub]++ ;
+#endif
+}
+
+
+void alloc_reset()
+{
+  for ( int i = 0 ; i < ALLOC_NSUB ; i++ )
+  {
+    counts[i] = 0 ;
+  }
+}
+
+
+uint32_t alloc_count ( uint8_t sub )
+{
+  return sub < ALLOC_NSUB ? counts[sub] : 0 ;
+}
+
+
+const char* alloc_name ( uint8_t sub )
+{
+  static const char* names[ALLOC_NSUB] = { "sys", "app", "web" } ;
+
+  return sub < ALLOC_NSUB ? names[sub] : "?" ;
+}
+
+
+//******************************************************************************************
+// Wrappers for the ESP8266 heap functions, the linker sends all calls here.               *
+//******************************************************************************************
+#ifdef ARDUINO_ARCH_ESP8266
+#include <Arduino.h>
+
+extern "C"
+{
+  void* __real_malloc ( size_t size ) ;
+  void* __real_calloc ( size_t n, size_t size ) ;
+  void* __real_realloc ( void* ptr, size_t size ) ;
+
+  void* IRAM_ATTR __wrap_malloc ( size_t size )
+  {
+    counts[alloc_sub]++ ;
+    return __real_malloc ( size ) ;
+  }
+
+  void* IRAM_ATTR __wrap_calloc ( size_t n, size_t size )
+  {
+    counts[alloc_sub]++ ;
+    return __real_calloc ( n, size ) ;
+  }
+
+  void* IRAM_ATTR __wrap_realloc ( void* ptr, size_t size )
+  {
+    counts[alloc_sub]++ ;
+    return __real_realloc ( ptr, size ) ;
+  }
+}
+#endif
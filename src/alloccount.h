@@ -0,0 +1,46 @@
+//******************************************************************************************
+// alloccount.h - Count heap allocations per subsystem.                                   *
+//******************************************************************************************
+// Every malloc(), calloc() and realloc() is counted for the subsystem that is active at   *
+// that moment.  The firmware marks its own code with an AllocScope; allocations outside   *
+// of any scope belong to the system (core, WiFi, lwIP).  After setup() the counters are   *
+// reset, so they show what the steady state allocates.  For the firmware itself this     *
+// should be zero.                                                                         *
+// On the ESP8266 the allocation functions are wrapped by the linker (--wrap=malloc etc.   *
+// in platformio.ini), on the host by native/alloc_native.cpp.                             *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef ALLOCCOUNT_H
+#define ALLOCCOUNT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum alloc_sub_t                                              // Subsystems
+{
+  ALLOC_SYS,                                                  // Core, WiFi, TCP/IP
+  ALLOC_APP,                                                  // The firmware
+  ALLOC_WEB,                                                  // Webserver and file serving
+  ALLOC_NSUB
+} ;
+
+#ifdef AQ_NATIVE
+extern thread_local uint8_t alloc_sub ;                       // Active subsystem per thread
+#else
+extern uint8_t              alloc_sub ;                       // Active subsystem
+#endif
+
+void        alloc_note() ;                                    // Called for every allocation
+void        alloc_reset() ;                                   // Clear the counters
+uint32_t    alloc_count ( uint8_t sub ) ;                     // Allocations since reset
+const char* alloc_name ( uint8_t sub ) ;                      // Name of a subsystem
+
+struct AllocScope                                             // Set subsystem for a scope
+{
+  uint8_t prev ;
+  AllocScope ( uint8_t sub )                    { prev = alloc_sub ; alloc_sub = sub ; }
+  ~AllocScope()                                 { alloc_sub = prev ; }
+} ;
+
+#endif
@@ -0,0 +1,34 @@
+//******************************************************************************************
+// crc.cpp - CRC-32 of a block of data.                                                   *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "crc.h"
+
+
+//******************************************************************************************
+//                                    C R C 3 2                                            *
+//******************************************************************************************
+// Compute the CRC-32 of data, 4 bits at a time.  To continue with the next part of the    *
+// data, pass the result of the previous part as crc.                                      *
+//******************************************************************************************
+uint32_t crc32 ( const void* data, size_t len, uint32_t crc )
+{
+  static const uint32_t table[16] =                           // CRC of every nibble
+  {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  } ;
+  const uint8_t* p = (const uint8_t*)data ;
+
+  crc = ~crc ;
+  while ( len-- )
+  {
+    crc ^= *p++ ;
+    crc = ( crc >> 4 ) ^ table[crc & 0x0F] ;                  // Low nibble
+    crc = ( crc >> 4 ) ^ table[crc & 0x0F] ;                  // High nibble
+  }
+  return ~crc ;
+}
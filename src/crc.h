@@ -0,0 +1,18 @@
+//******************************************************************************************
+// crc.h - CRC-32 of a block of data.                                                     *
+//******************************************************************************************
+// The common CRC-32 (as used by zlib and Ethernet), so the result can be checked with     *
+// any tool on the PC.  A table of 16 entries keeps it small in flash.                     *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+uint32_t crc32 ( const void* data, size_t len,                // CRC of data, crc is the
+                 uint32_t crc = 0 ) ;                         // result of the previous part
+
+#endif
@@ -0,0 +1,82 @@
+//******************************************************************************************
+// embassets.h - Web files compiled into the firmware.                                    *
+//******************************************************************************************
+// Built with -DAQ_EMBED_ASSETS (environments esp12e_embed and native_embed).  Then        *
+// host/tools/webassets.py writes the files of data/ into webassets_gen.h: the contents as *
+// PROGMEM arrays and a table embassets[], sorted on path, with content type, length and   *
+// ETag of every file.  A request for such a file needs no filesystem access: the table is *
+// searched with a binary search and the contents are sent straight from flash.            *
+// Without AQ_EMBED_ASSETS the table is empty and all files come from LittleFS.            *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef EMBASSETS_H
+#define EMBASSETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "mimetype.h"
+
+struct embasset_t                                             // A compiled-in file
+{
+  const char*        path ;                                   // URL, like "/index.html"
+  const char*        contenttype ;                            // As getContentType()
+  const uint8_t*     data ;                                   // Contents, in PROGMEM
+  uint32_t           len ;                                    // Length of data
+  const char*        etag ;                                   // Quoted CRC-32 of data
+  bool               gzip ;                                   // data is gzipped
+  bool               immutable ;                              // Hash in name, never changes
+} ;
+
+#ifdef AQ_EMBED_ASSETS
+#include "webassets_gen.h"
+
+#define NEMBASSETS   ( sizeof(embassets) / sizeof(embassets[0]) )
+
+constexpr bool embassets_sorted ( size_t i = 1 )
+{
+  return ( i >= NEMBASSETS ) ||
+         ( ( const_strcmp ( embassets[i-1].path, embassets[i].path ) < 0 ) &&
+           embassets_sorted ( i + 1 ) ) ;
+}
+
+static_assert ( embassets_sorted(), "embassets[] must be sorted on path" ) ;
+
+//******************************************************************************************
+// Find a compiled-in file.  Returns nullptr if the path is not in the table.              *
+//******************************************************************************************
+static inline const embasset_t* find_embasset ( const char* path )
+{
+  size_t lo = 0 ;                                             // First candidate
+  size_t hi = NEMBASSETS ;                                    // Behind last candidate
+  size_t mid ;
+  int    c ;
+
+  while ( lo < hi )
+  {
+    mid = ( lo + hi ) / 2 ;
+    c = strcmp ( path, embassets[mid].path ) ;
+    if ( c == 0 )
+    {
+      return &embassets[mid] ;
+    }
+    if ( c < 0 )
+    {
+      hi = mid ;
+    }
+    else
+    {
+      lo = mid + 1 ;
+    }
+  }
+  return nullptr ;
+}
+#else
+static inline const embasset_t* find_embasset ( const char* )
+{
+  return nullptr ;                                            // Nothing compiled in
+}
+#endif
+
+#endif
@@ -0,0 +1,130 @@
+//******************************************************************************************
+// fixstring.h - String with a fixed capacity, never uses the heap.                       *
+//******************************************************************************************
+// FixedString<N> holds at most N-1 characters plus the terminating '\0'.  The methods     *
+// follow the Arduino String class, so code can switch between the two easily.  Text that  *
+// does not fit is cut off and the string is marked as truncated.                          *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef FIXSTRING_H
+#define FIXSTRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+template <size_t N>
+class FixedString
+{
+  public:
+    FixedString()                                   { clear() ; }
+    FixedString ( const char* cstr )                { clear() ; concat ( cstr ) ; }
+
+    FixedString& operator = ( const char* cstr )    { clear() ; concat ( cstr ) ; return *this ; }
+    FixedString& operator += ( const char* cstr )   { concat ( cstr ) ; return *this ; }
+    FixedString& operator += ( char c )             { concat ( &c, 1 ) ; return *this ; }
+    bool         operator == ( const char* cstr ) const { return strcmp ( buf, cstr ) == 0 ; }
+    bool         operator != ( const char* cstr ) const { return strcmp ( buf, cstr ) != 0 ; }
+    char         operator [] ( size_t index ) const { return index < len ? buf[index] : '\0' ; }
+
+    void         clear()                            { len = 0 ; buf[0] = '\0' ; truncated = false ; }
+    const char*  c_str() const                      { return buf ; }
+    size_t       length() const                     { return len ; }
+    size_t       capacity() const                   { return N - 1 ; }
+    bool         isTruncated() const                { return truncated ; }
+
+    //**************************************************************************************
+    // Add characters, as far as they fit.  Returns false if something was cut off.       *
+    //**************************************************************************************
+    bool concat ( const char* cstr, size_t n )
+    {
+      if ( n > N - 1 - len )                                  // Fits?
+      {
+        n = N - 1 - len ;                                     // No, cut off
+        truncated = true ;
+      }
+      memcpy ( buf + len, cstr, n ) ;
+      len += n ;
+      buf[len] = '\0' ;
+      return ! truncated ;
+    }
+
+    bool concat ( const char* cstr )                { return concat ( cstr, strlen ( cstr ) ) ; }
+
+    bool concat ( long value )                      // Decimal number, like String(value)
+    {
+      char  tmp[24] ;
+      char* p = tmp + sizeof(tmp) ;
+      bool  neg = value < 0 ;
+      unsigned long v = neg ? 0UL - (unsigned long)value : value ;
+
+      do
+      {
+        *--p = '0' + v % 10 ;
+        v /= 10 ;
+      } while ( v ) ;
+      if ( neg )
+      {
+        *--p = '-' ;
+      }
+      return concat ( p, tmp + sizeof(tmp) - p ) ;
+    }
+
+    bool concat ( int value )                       { return concat ( (long)value ) ; }
+    bool concat ( unsigned int value )              { return concat ( (long)value ) ; }
+
+    //**************************************************************************************
+    // Add formatted text like sprintf().                                                  *
+    //**************************************************************************************
+    bool vprintf ( const char* format, va_list args )
+    {
+      int n = vsnprintf ( buf + len, N - len, format, args ) ;
+
+      if ( n < 0 )
+      {
+        buf[len] = '\0' ;
+        return false ;
+      }
+      if ( (size_t)n > N - 1 - len )                          // Cut off?
+      {
+        n = N - 1 - len ;
+        truncated = true ;
+      }
+      len += n ;
+      return ! truncated ;
+    }
+
+    __attribute__ ( ( format ( printf, 2, 3 ) ) )
+    bool printf ( const char* format, ... )
+    {
+      va_list args ;
+      bool    res ;
+
+      va_start ( args, format ) ;
+      res = vprintf ( format, args ) ;
+      va_end ( args ) ;
+      return res ;
+    }
+
+    bool startsWith ( const char* prefix ) const
+    {
+      return strncmp ( buf, prefix, strlen ( prefix ) ) == 0 ;
+    }
+
+    bool endsWith ( const char* suffix ) const
+    {
+      size_t n = strlen ( suffix ) ;
+
+      return ( n <= len ) && ( strcmp ( buf + len - n, suffix ) == 0 ) ;
+    }
+
+  private:
+    char         buf[N] ;                           // The characters
+    size_t       len ;                              // Current length
+    bool         truncated ;                        // Something did not fit
+} ;
+
+#endif
@@ -0,0 +1,154 @@
+//******************************************************************************************
+// fsindex.cpp - Index of the files in LittleFS, kept in RAM.                             *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Only hash and size, shared entry for names with the same hash          *
+//******************************************************************************************
+#include "fsindex.h"
+
+#define SHARED    0xFFFFFFFFU                                 // Size of a shared entry
+
+struct fsentry_t
+{
+  uint32_t        hash ;                                      // fsindex_hash() of the name
+  uint32_t        size ;                                      // Size of the file or SHARED
+} ;
+
+static fsentry_t  entries[FSINDEX_SLOTS] ;                    // The index, not sorted
+static uint8_t    count ;                                     // Number of entries in use
+static bool       overflow ;                                  // A file did not fit
+
+
+//******************************************************************************************
+// The name in the index.  Leading slashes are skipped, so "/a.pw" and "a.pw" are equal.   *
+//******************************************************************************************
+static const char* fsindex_name ( const char* path )
+{
+  while ( *path == '/' )
+  {
+    path++ ;
+  }
+  return path ;
+}
+
+
+//******************************************************************************************
+// FNV-1a hash of a path, without its leading slashes.                                     *
+//******************************************************************************************
+static uint32_t fsindex_hash ( const char* path )
+{
+  const char* name = fsindex_name ( path ) ;
+  uint32_t    h = 2166136261U ;
+
+  while ( *name )
+  {
+    h = ( h ^ (uint8_t)*name++ ) * 16777619U ;
+  }
+  return h ;
+}
+
+
+static fsentry_t* lookup ( const char* path )
+{
+  uint32_t hash = fsindex_hash ( path ) ;
+
+  for ( uint8_t i = 0 ; i < count ; i++ )
+  {
+    if ( entries[i].hash == hash )
+    {
+      return &entries[i] ;
+    }
+  }
+  return nullptr ;
+}
+
+
+void fsindex_clear()
+{
+  count = 0 ;
+  overflow = false ;
+}
+
+
+//******************************************************************************************
+// Add a file that did not exist.  If another file has the same hash, the entry is shared. *
+//******************************************************************************************
+void fsindex_add ( const char* path, uint32_t size )
+{
+  fsentry_t* e = lookup ( path ) ;
+
+  if ( e )                                                    // Hash already in use?
+  {
+    e->size = SHARED ;                                        // Yes, LittleFS must tell
+    return ;
+  }
+  if ( count == FSINDEX_SLOTS )                               // New entry, but no room
+  {
+    overflow = true ;
+    return ;
+  }
+  e = &entries[count++] ;
+  e->hash = fsindex_hash ( path ) ;
+  e->size = size ;
+}
+
+
+//******************************************************************************************
+// New size of a file that has an entry of its own, or a new entry.                        *
+//******************************************************************************************
+void fsindex_set ( const char* path, uint32_t size )
+{
+  fsentry_t* e = lookup ( path ) ;
+
+  if ( e == nullptr )
+  {
+    fsindex_add ( path, size ) ;
+  }
+  else if ( e->size != SHARED )
+  {
+    e->size = size ;
+  }
+}
+
+
+void fsindex_remove ( const char* path )
+{
+  fsentry_t* e = lookup ( path ) ;
+
+  if ( e && ( e->size != SHARED ) )                           // A shared entry stays, the
+  {                                                           // other file may still exist
+    *e = entries[--count] ;                                   // Last one fills the gap
+  }
+}
+
+
+fsfind_t fsindex_find ( const char* path, uint32_t* size )
+{
+  fsentry_t* e = lookup ( path ) ;
+
+  if ( e == nullptr )
+  {
+    return FSINDEX_NO ;
+  }
+  if ( e->size == SHARED )
+  {
+    return FSINDEX_MAYBE ;
+  }
+  if ( size )
+  {
+    *size = e->size ;
+  }
+  return FSINDEX_YES ;
+}
+
+
+bool fsindex_complete()
+{
+  return ! overflow ;
+}
+
+
+uint8_t fsindex_count()
+{
+  return count ;
+}
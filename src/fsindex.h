@@ -0,0 +1,38 @@
+//******************************************************************************************
+// fsindex.h - Index of the files in LittleFS, kept in RAM.                               *
+//******************************************************************************************
+// For every file the index holds a hash of its name and its size, 8 bytes per file.  It   *
+// is filled once by hal_fs_begin() and kept current by the HAL functions that write,      *
+// rename or remove files, so "does this file exist" and "how big is it" are answered      *
+// without touching the flash.                                                             *
+// A hash that is not in the index means that the file does not exist.  Two names can      *
+// have the same hash: the HAL adds a file with fsindex_add() when it did not exist, and   *
+// if its hash is already in the index that entry becomes shared.  For a shared entry      *
+// fsindex_find() answers FSINDEX_MAYBE and the HAL looks in LittleFS.  A shared entry     *
+// stays until the next fsindex_clear(), that is rare and costs only a slot.               *
+// If there are more files than FSINDEX_SLOTS the index is incomplete and a file that is   *
+// not found must be looked up in LittleFS as well.                                        *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Only hash and size, shared entry for names with the same hash          *
+//******************************************************************************************
+#ifndef FSINDEX_H
+#define FSINDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FSINDEX_SLOTS   32                                    // Maximum number of files
+
+enum fsfind_t { FSINDEX_NO, FSINDEX_YES, FSINDEX_MAYBE } ;    // Result of fsindex_find()
+
+void     fsindex_clear() ;                                    // Empty and complete
+void     fsindex_add ( const char* path, uint32_t size ) ;    // Add a file that was not there
+void     fsindex_set ( const char* path, uint32_t size ) ;    // New size of a file
+void     fsindex_remove ( const char* path ) ;                // Forget a file, not shared
+fsfind_t fsindex_find ( const char* path, uint32_t* size ) ;  // Size only for FSINDEX_YES,
+                                                              // may be nullptr
+bool     fsindex_complete() ;                                 // False if a file did not fit
+uint8_t  fsindex_count() ;                                    // Number of entries in index
+
+#endif
@@ -0,0 +1,90 @@
+//******************************************************************************************
+// hal.h - Hardware abstraction layer for AqLedVerl.                                      *
+//******************************************************************************************
+// The application (main.cpp) only talks to the hardware through the functions below.      *
+// There are 2 implementations:                                                            *
+//  - hal_esp8266.cpp   The real thing: Wemos D1 with WiFi, LittleFS, EEPROM, PWM.         *
+//  - native/*.cpp      Linux host build: PWM becomes a trace, EEPROM and LittleFS map to  *
+//                      files in a temporary directory, HTTP is served on localhost.       *
+// The webserver API (AsyncWebServer, AsyncWebServerRequest) is the same on both           *
+// platforms.  For the host build a compatible subset is in native/webserver.h.            *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Files that stay open, for a page that is sent part by part             *
+//******************************************************************************************
+#ifndef HAL_H
+#define HAL_H
+
+#ifdef AQ_NATIVE
+#include "native/compat.h"                                    // String, time functions
+#include "native/webserver.h"                                 // AsyncWebServer subset
+#else
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <TimeLib.h>
+#endif
+
+#define LAMP_A               0                                // Index of lamp A in hal_pwm_write
+#define LAMP_B               1                                // Index of lamp B in hal_pwm_write
+#define HAL_FS_FILES         4                                // Files open at the same time
+
+// Provided by the application, may be used by the HAL for logging
+void        dbgprint ( const char* format, ... ) ;
+
+// Console, timing and system
+void        hal_begin() ;                                     // Start console output
+void        hal_console ( const char* line ) ;               // Print a line on the console
+uint32_t    hal_millis() ;                                    // Milliseconds since start
+void        hal_delay ( uint32_t ms ) ;                       // Wait some time
+void        hal_timer_1sec ( void (*cb)() ) ;                 // Call cb every second
+uint32_t    hal_free_heap() ;                                 // Free memory in bytes
+void        hal_reset() ;                                     // Restart the system
+
+// Outputs
+void        hal_pwm_begin ( uint16_t range ) ;                // Configure lamp outputs
+void        hal_pwm_write ( uint8_t lamp, uint8_t value ) ;   // Set intensity of a lamp
+void        hal_led ( bool on ) ;                             // Onboard LED on/off
+
+// EEPROM (RAM shadow), only read to import settings of older versions
+void        hal_eeprom_begin ( size_t size ) ;
+void        hal_eeprom_read ( size_t addr, void* data, size_t len ) ;
+void        hal_eeprom_end() ;                                // Free the RAM shadow
+
+// Filesystem
+bool        hal_fs_begin() ;                                  // Mount filesystem
+void        hal_fs_info ( size_t* total, size_t* used ) ;     // Get size info
+void        hal_fs_list ( void (*cb)( const char* name,       // Call cb for every file
+                                      size_t size ) ) ;
+void        hal_fs_send ( AsyncWebServerRequest* request,     // Send a file to a client
+                          const char* path,
+                          const char* contenttype ) ;
+AsyncWebServerResponse* hal_fs_response (                     // Response with a file, to
+              AsyncWebServerRequest* request,         // add headers.  nullptr if
+              const char* path,                       // not existing
+              const char* contenttype ) ;
+bool        hal_fs_exists ( const char* path ) ;              // From index, see fsindex.h
+long        hal_fs_size ( const char* path ) ;                // Size of file, -1 if missing
+size_t      hal_fs_read ( const char* path, size_t offset,    // Read part of a file, returns
+                          void* data, size_t len ) ;          // number of bytes read
+int         hal_fs_open ( const char* path ) ;                // Open to read, returns a file
+                                                              // number, -1 if not possible
+size_t      hal_fs_pread ( int file, size_t offset,           // Read part of an open file,
+                           void* data, size_t len ) ;         // returns number of bytes read
+void        hal_fs_close ( int file ) ;                       // Close an open file
+bool        hal_fs_write ( const char* path, const void* data,  // Write or append to a file
+                           size_t len, bool append ) ;
+bool        hal_fs_rename ( const char* from,                 // Rename, replaces "to"
+                            const char* to ) ;
+bool        hal_fs_remove ( const char* path ) ;              // Delete a file
+
+// Network and time
+void        hal_wifi_begin ( const char* hostname ) ;         // Select network and connect
+int         hal_wifi_rssi() ;                                 // Signal strength in dBm
+void        hal_ota_begin ( const char* hostname,             // Allow update over the air
+                            void (*onstart)() ) ;
+void        hal_ntp_begin() ;                                 // Start NTP service
+bool        hal_ntp_update() ;                                // True if time is known
+time_t      hal_ntp_localtime() ;                             // Local time from NTP
+void        hal_net_loop() ;                                  // Handle mDNS and OTA
+
+#endif
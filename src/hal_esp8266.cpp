@@ -0,0 +1,568 @@
+//******************************************************************************************
+// hal_esp8266.cpp - Hardware abstraction layer, implementation for the Wemos D1.         *
+//******************************************************************************************
+// 16-10-2026, AG - First setup, code moved from main.cpp                                  *
+// 17-10-2026, AG - Index changed only after LittleFS did remove or rename                 *
+// 17-10-2026, AG - LittleFS asked for a hash that is shared in the index                  *
+// 17-10-2026, AG - Files that stay open, in a table of HAL_FS_FILES                       *
+//                                                                                         *
+// Wiring:                                                                                 *
+// GPIO    Wemos D1  Wired to                                                              *
+// ------  --------  ----------------------------------------------------------------------*
+// GPIO14    D5      PWM output Lamp A                                                     *
+// GPIO12    D6      PWM output Lamp B                                                     *
+//******************************************************************************************
+#ifdef ARDUINO_ARCH_ESP8266
+
+#include "hal.h"
+#include "fixstring.h"
+#include "alloccount.h"
+#include "fsindex.h"
+#include <ESP8266WiFi.h>
+#include <ArduinoOTA.h>
+#include <LittleFS.h>
+#include <ESPAsyncTCP.h>
+#include <mdns.h>
+#include <Ticker.h>
+#include <NTPClient.h>
+#include <EEPROM.h>
+#include <Timezone.h>    // https://github.com/JChristensen/Timezone
+
+#define LAMPA               D5                                // GPIO used for lamp A
+#define LAMPB               D6                                // GPIO used for lamp B
+
+ADC_MODE(ADC_VCC) ;                                           // Allow ADC to read VCC
+
+// Central European Time (Amsterdam, Frankfurt, Paris)
+TimeChangeRule CEST = { "CEST", Last, Sun, Mar, 2, 120 } ;    // Central European Summer Time
+TimeChangeRule CET  = { "CET ", Last, Sun, Oct, 3,  60 } ;    // Central European Standard Time
+Timezone       myTZ ( CEST, CET ) ;                           // Timezone to be used
+
+WiFiUDP              ntpUDP ;                                 // For NTP service
+NTPClient            timeClient ( ntpUDP ) ;                  // For NTP service
+mdns::MDns           my_mdns ( NULL, NULL, NULL ) ;           // mDNS without callbacks
+Ticker               tckr ;                                   // For timing 1000 msec
+FixedString<33>      ssid ;                                   // Network in use
+
+
+//******************************************************************************************
+//                                 H A L _ B E G I N                                       *
+//******************************************************************************************
+// Start the serial output for debugging.                                                  *
+//******************************************************************************************
+void hal_begin()
+{
+  Serial.begin ( 115200 ) ;                          // For debugging
+  Serial.println ( ) ;
+}
+
+
+//******************************************************************************************
+//                      C O N S O L E ,   T I M I N G   A N D   S Y S T E M                *
+//******************************************************************************************
+void hal_console ( const char* line )
+{
+  Serial.println ( line ) ;
+}
+
+
+uint32_t hal_millis()
+{
+  return millis() ;
+}
+
+
+void hal_delay ( uint32_t ms )
+{
+  delay ( ms ) ;
+}
+
+
+void hal_timer_1sec ( void (*cb)() )
+{
+  tckr.attach ( 1.0, cb ) ;                          // Every 1000 msec
+}
+
+
+uint32_t hal_free_heap()
+{
+  return ESP.getFreeHeap() ;
+}
+
+
+void hal_reset()
+{
+  ESP.reset() ;
+}
+
+
+//******************************************************************************************
+//                                   O U T P U T S                                         *
+//******************************************************************************************
+void hal_pwm_begin ( uint16_t range )
+{
+  pinMode ( LED_BUILTIN, OUTPUT ) ;                  // Configure onboard LED pin
+  pinMode ( LAMPA, OUTPUT ) ;                        // Configure LED lamp A
+  pinMode ( LAMPB, OUTPUT ) ;                        // Configure LED lamp B
+  analogWriteRange ( range ) ;                       // PWM range, 100 is percent
+}
+
+
+void hal_pwm_write ( uint8_t lamp, uint8_t value )
+{
+  analogWrite ( lamp == LAMP_A ? LAMPA : LAMPB,      // Set intensity of lamp
+                value ) ;
+}
+
+
+void hal_led ( bool on )
+{
+  digitalWrite ( LED_BUILTIN, on ? LOW : HIGH ) ;    // Onboard LED is active low
+}
+
+
+//******************************************************************************************
+//                                    E E P R O M                                          *
+//******************************************************************************************
+void hal_eeprom_begin ( size_t size )
+{
+  EEPROM.begin ( size ) ;                            // Enable EEPROM
+}
+
+
+void hal_eeprom_read ( size_t addr, void* data, size_t len )
+{
+  memcpy ( data, EEPROM.getConstDataPtr() + addr,    // Copy from RAM shadow
+           len ) ;
+}
+
+
+void hal_eeprom_end()
+{
+  EEPROM.end() ;                                     // Free RAM shadow, no commit
+}
+
+
+//******************************************************************************************
+//                                F I L E S Y S T E M                                      *
+//******************************************************************************************
+bool hal_fs_begin()
+{
+  Dir dir ;
+
+  if ( ! LittleFS.begin() )                          // Enable file system
+  {
+    return false ;
+  }
+  fsindex_clear() ;                                  // Fill the index, once
+  dir = LittleFS.openDir ( "/" ) ;
+  while ( dir.next() )
+  {
+    if ( dir.isFile() )
+    {
+      fsindex_add ( dir.fileName().c_str(), dir.fileSize() ) ;
+    }
+  }
+  return true ;
+}
+
+
+void hal_fs_info ( size_t* total, size_t* used )
+{
+  FSInfo      fs_info ;                              // LittleFS info
+
+  LittleFS.info ( fs_info ) ;
+  *total = fs_info.totalBytes ;
+  *used  = fs_info.usedBytes ;
+}
+
+
+void hal_fs_list ( void (*cb)( const char* name, size_t size ) )
+{
+  Dir         dir ;
+
+  dir = LittleFS.openDir ( "/" ) ;                   // Show files in FS
+  while ( dir.next() )                               // All files
+  {
+    if ( dir.isFile() )                              // Size from the directory,
+    {                                                // no need to open the file
+      cb ( dir.fileName().c_str(), dir.fileSize() ) ;
+    }
+  }
+}
+
+
+void hal_fs_send ( AsyncWebServerRequest* request, const char* path,
+                   const char* contenttype )
+{
+  AllocScope scope ( ALLOC_WEB ) ;                   // Count as webserver
+
+  request->send ( LittleFS, path, contenttype ) ;    // 404 if not existing
+}
+
+
+AsyncWebServerResponse* hal_fs_response ( AsyncWebServerRequest* request, const char* path,
+                                          const char* contenttype )
+{
+  AllocScope scope ( ALLOC_WEB ) ;                   // Count as webserver
+
+  if ( ! hal_fs_exists ( path ) )
+  {
+    return nullptr ;
+  }
+  return request->beginResponse ( LittleFS, path, contenttype ) ;
+}
+
+
+//******************************************************************************************
+// True if the hash of path is in the index for another file, so path gets a shared entry  *
+// when it is created.  To be called before the write or rename that creates it.           *
+//******************************************************************************************
+static bool other_hash ( const char* path )
+{
+  return ( fsindex_find ( path, nullptr ) == FSINDEX_YES ) && ! LittleFS.exists ( path ) ;
+}
+
+
+bool hal_fs_exists ( const char* path )
+{
+  AllocScope scope ( ALLOC_SYS ) ;
+  fsfind_t   found = fsindex_find ( path, nullptr ) ;
+
+  if ( found == FSINDEX_YES )
+  {
+    return true ;
+  }
+  if ( ( found == FSINDEX_NO ) && fsindex_complete() )
+  {
+    return false ;
+  }
+  return LittleFS.exists ( path ) ;                  // Shared hash, or index incomplete
+}
+
+
+long hal_fs_size ( const char* path )
+{
+  AllocScope scope ( ALLOC_SYS ) ;                   // LittleFS allocates buffers
+  File       f ;
+  uint32_t   size ;
+
+  fsfind_t   found = fsindex_find ( path, &size ) ;
+
+  if ( found == FSINDEX_YES )
+  {
+    return size ;
+  }
+  if ( ( ( found == FSINDEX_NO ) && fsindex_complete() ) ||
+       ! ( f = LittleFS.open ( path, "r" ) ) )
+  {
+    return -1L ;
+  }
+  return f.size() ;
+}
+
+
+size_t hal_fs_read ( const char* path, size_t offset, void* data, size_t len )
+{
+  AllocScope scope ( ALLOC_SYS ) ;
+  File       f ;
+
+  if ( ! hal_fs_exists ( path ) ||                   // No need to try a missing file
+       ! ( f = LittleFS.open ( path, "r" ) ) || ! f.seek ( offset ) )
+  {
+    return 0 ;
+  }
+  return f.read ( (uint8_t*)data, len ) ;
+}
+
+
+//******************************************************************************************
+// Files that stay open.  The file number is the index in files[], a closed File is free.  *
+//******************************************************************************************
+static File files[HAL_FS_FILES] ;                             // Open files
+
+
+int hal_fs_open ( const char* path )
+{
+  AllocScope scope ( ALLOC_SYS ) ;
+  int        i ;
+
+  for ( i = 0 ; ( i < HAL_FS_FILES ) && files[i] ; i++ ) ;   // Find a free one
+  if ( ( i == HAL_FS_FILES ) || ! hal_fs_exists ( path ) ||
+       ! ( files[i] = LittleFS.open ( path, "r" ) ) )
+  {
+    return -1 ;
+  }
+  return i ;
+}
+
+
+size_t hal_fs_pread ( int file, size_t offset, void* data, size_t len )
+{
+  AllocScope scope ( ALLOC_SYS ) ;
+
+  if ( ( file < 0 ) || ( file >= HAL_FS_FILES ) || ! files[file] ||
+       ! files[file].seek ( offset ) )
+  {
+    return 0 ;
+  }
+  return files[file].read ( (uint8_t*)data, len ) ;
+}
+
+
+void hal_fs_close ( int file )
+{
+  AllocScope scope ( ALLOC_SYS ) ;
+
+  if ( ( file >= 0 ) && ( file < HAL_FS_FILES ) )
+  {
+    files[file].close() ;
+  }
+}
+
+
+bool hal_fs_write ( const char* path, const void* data, size_t len, bool append )
+{
+  AllocScope scope ( ALLOC_SYS ) ;
+  bool       other = other_hash ( path ) ;           // Before open() creates it
+  File       f = LittleFS.open ( path, append ? "a" : "w" ) ;
+  size_t     n ;
+
+  if ( ! f )
+  {
+    return false ;
+  }
+  n = f.write ( (const uint8_t*)data, len ) ;
+  if ( other )                                       // Keep index current
+  {
+    fsindex_add ( path, f.size() ) ;
+  }
+  else
+  {
+    fsindex_set ( path, f.size() ) ;
+  }
+  return n == len ;                                  // Closed by destructor
+}
+
+
+bool hal_fs_rename ( const char* from, const char* to )
+{
+  AllocScope scope ( ALLOC_SYS ) ;
+  uint32_t   size = 0 ;
+  fsfind_t   found = fsindex_find ( from, &size ) ;
+  bool       other = other_hash ( to ) ;             // Before "to" is replaced
+  File       f ;
+
+  if ( ! LittleFS.rename ( from, to ) )              // Atomic, replaces "to"
+  {
+    return false ;
+  }
+  if ( found == FSINDEX_YES )                        // Keep index current
+  {
+    fsindex_remove ( from ) ;
+  }
+  else if ( ( f = LittleFS.open ( to, "r" ) ) )      // Shared or not indexed, size
+  {                                                  // from LittleFS
+    size = f.size() ;
+  }
+  if ( other )
+  {
+    fsindex_add ( to, size ) ;
+  }
+  else
+  {
+    fsindex_set ( to, size ) ;
+  }
+  return true ;
+}
+
+
+bool hal_fs_remove ( const char* path )
+{
+  AllocScope scope ( ALLOC_SYS ) ;
+
+  if ( ! LittleFS.remove ( path ) )
+  {
+    return false ;                                   // File is still there
+  }
+  fsindex_remove ( path ) ;                          // Keep index current
+  return true ;
+}
+
+
+//******************************************************************************************
+//                             G E T E N C R Y P T I O N T Y P E                           *
+//******************************************************************************************
+// Read the encryption type of the network and return as a 4 byte name                     *
+//******************************************************************************************
+static const char* getEncryptionType ( int thisType )
+{
+  switch (thisType)
+  {
+    case ENC_TYPE_WEP:
+      return "WEP " ;
+    case ENC_TYPE_TKIP:
+      return "WPA " ;
+    case ENC_TYPE_CCMP:
+      return "WPA2" ;
+    case ENC_TYPE_NONE:
+      return "None" ;
+    case ENC_TYPE_AUTO:
+      return "Auto" ;
+  }
+  return "????" ;
+}
+
+
+//******************************************************************************************
+//                                L I S T N E T W O R K S                                  *
+//******************************************************************************************
+// List the available networks and select the strongest.                                   *
+// Acceptable networks are those who have a "SSID.pw" file in the LittleFS.                *
+//******************************************************************************************
+static void listNetworks()
+{
+  int         maxsig = -1000 ;   // Used for searching strongest WiFi signal
+  int         newstrength ;
+  byte        encryption ;       // TKIP(WPA)=2, WEP=5, CCMP(WPA)=4, NONE=7, AUTO=8
+  const char* acceptable ;       // Netwerk is acceptable for connection
+  int         i ;
+  FixedString<40> path ;         // Full filespec to see if SSID is an acceptable one
+
+  // scan for nearby networks:
+  dbgprint ( "Scan Networks" ) ;
+  int numSsid = WiFi.scanNetworks() ;
+  if ( numSsid == -1 )
+  {
+    dbgprint ( "Couldn't get a wifi connection" ) ;
+    return ;
+  }
+  // print the list of networks seen:
+  dbgprint ( "Number of available networks: %d",
+             numSsid ) ;
+  // Print the network number and name for each network found and
+  // find the strongest acceptable network
+  for ( i = 0 ; i < numSsid ; i++ )
+  {
+    acceptable = "" ;                                    // Assume not acceptable
+    path = "/" ;
+    path += WiFi.SSID ( i ).c_str() ;
+    path += ".pw" ;
+    newstrength = WiFi.RSSI ( i ) ;
+    if ( hal_fs_exists ( path.c_str() ) )                // Is this SSID acceptable?
+    {
+      acceptable = "Acceptable" ;
+      if ( newstrength > maxsig )                        // This is a better Wifi
+      {
+        maxsig = newstrength ;
+        ssid = WiFi.SSID ( i ).c_str() ;                 // Remember SSID name
+      }
+    }
+    encryption = WiFi.encryptionType ( i ) ;
+    dbgprint ( "%2d - %-25s Signal: %3d dBm Encryption %4s  %s",
+               i + 1, WiFi.SSID ( i ).c_str(), WiFi.RSSI ( i ),
+               getEncryptionType ( encryption ),
+               acceptable ) ;
+  }
+  dbgprint ( "--------------------------------------" ) ;
+  dbgprint ( "Selected network: %-25s", ssid.c_str() ) ;
+}
+
+
+//******************************************************************************************
+//                               C O N N E C T W I F I                                     *
+//******************************************************************************************
+// Connect to WiFi using passwords available in the LittleFS.                              *
+//******************************************************************************************
+static void connectwifi()
+{
+  FixedString<40> path ;                               // Full file spec
+  String          pw ;                                 // Password from file
+  File            pwfile ;                             // File containing password for WiFi
+
+  path = "/" ;                                         // Form full path
+  path += ssid.c_str() ;
+  path += ".pw" ;
+  pwfile = LittleFS.open ( path.c_str(), "r" ) ;       // File name equal to SSID
+  pw = pwfile.readStringUntil ( '\n' ) ;               // Read password as a string
+  pw.trim() ;                                          // Remove CR
+  WiFi.begin ( ssid.c_str(), pw.c_str() ) ;            // Connect to selected SSID
+  dbgprint ( "Try WiFi %s",
+             ssid.c_str() ) ;                          // Message to show during WiFi connect
+  if (  WiFi.waitForConnectResult() != WL_CONNECTED )  // Try to connect
+  {
+    dbgprint ( "WiFi Failed!" ) ;
+    return ;
+  }
+  dbgprint ( "IP = %d.%d.%d.%d",
+              WiFi.localIP()[0], WiFi.localIP()[1],
+              WiFi.localIP()[2], WiFi.localIP()[3] ) ;
+}
+
+
+//******************************************************************************************
+//                             H A L _ W I F I _ B E G I N                                 *
+//******************************************************************************************
+// Select the best acceptable network and connect to it.                                   *
+//******************************************************************************************
+void hal_wifi_begin ( const char* hostname )
+{
+  WiFi.mode ( WIFI_STA ) ;                           // This ESP is a station
+  wifi_station_set_hostname ( hostname ) ;           // Set hostname
+  listNetworks() ;
+  connectwifi() ;
+  Serial.println ( ) ;
+  Serial.println ( "WiFi connected" ) ;
+  Serial.print   ( "Local   IP address: " ) ;
+  Serial.println ( WiFi.localIP() ) ;
+  Serial.print   ( "Gateway IP address: " ) ;
+  Serial.println ( WiFi.gatewayIP() ) ;
+}
+
+
+int hal_wifi_rssi()
+{
+  return WiFi.RSSI() ;                               // 31 if not connected
+}
+
+
+//******************************************************************************************
+//                          O T A ,   N T P   A N D   M D N S                              *
+//******************************************************************************************
+void hal_ota_begin ( const char* hostname, void (*onstart)() )
+{
+  ArduinoOTA.setHostname ( hostname ) ;              // Set the hostname
+  ArduinoOTA.onStart ( onstart ) ;
+  ArduinoOTA.begin() ;                               // Allow update over the air
+}
+
+
+void hal_ntp_begin()
+{
+  timeClient.begin() ;                               // Enable NTP service
+}
+
+
+bool hal_ntp_update()
+{
+  AllocScope scope ( ALLOC_SYS ) ;                   // Count as system
+
+  return timeClient.update() ;                       // Update time
+}
+
+
+time_t hal_ntp_localtime()
+{
+  return myTZ.toLocal ( timeClient.getEpochTime() ) ;  // Convert to local
+}
+
+
+void hal_net_loop()
+{
+  AllocScope scope ( ALLOC_SYS ) ;                   // Count as system
+
+  my_mdns.loop() ;                                   // Handle mDNS
+  ArduinoOTA.handle() ;                              // Check for OTA
+}
+
+#endif
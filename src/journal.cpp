@@ -0,0 +1,193 @@
+//******************************************************************************************
+// journal.cpp - Append-only journal of configuration records in a LittleFS file.         *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Missing journal checked, leftover new journal removed                  *
+// 17-10-2026, AG - Failed append marks the journal damaged, same data compared bytewise   *
+//******************************************************************************************
+#include "journal.h"
+#include "hal.h"
+#include "crc.h"
+#include <string.h>
+
+#define JOURNAL_MAGIC   0x4A514141                            // "AAQJ"
+
+struct jhead_t                                                // Head of a record, followed
+{                                                             // by data and CRC-32 of both
+  uint32_t magic ;                                            // JOURNAL_MAGIC
+  uint32_t seq ;                                              // Sequence number
+  uint16_t len ;                                              // Length of data
+  uint16_t spare ;                                            // Zero
+} ;
+
+static uint32_t lastseq ;                                     // Sequence nr of last record
+static uint32_t lastdcrc ;                                    // CRC of data of last record
+static size_t   lastlen ;                                     // Length of data last record
+static size_t   lastpos ;                                     // Position of its data
+static bool     haslast ;                                     // lastdcrc is valid
+static bool     damaged ;                                     // Bad data at end of journal
+
+
+//******************************************************************************************
+//                              J O U R N A L _ L O A D                                    *
+//******************************************************************************************
+// Find the newest valid record and copy its data.  Called once at boot.  If the journal   *
+// is missing but a compacted one was written, the power failed before the rename, so the  *
+// rename is done now.  If both are there, the power failed while the compacted journal    *
+// was written; it is removed, the save is lost like a record that was cut off.            *
+//******************************************************************************************
+bool journal_load ( void* data, size_t maxlen, size_t* len )
+{
+  jhead_t  head ;                                             // Head of current record
+  uint8_t  buf[JOURNAL_MAXDATA] ;                             // Data of current record
+  uint32_t crc ;                                              // CRC in the record
+  long     size ;                                             // Size of the journal
+  size_t   pos = 0 ;                                          // Position in the journal
+  bool     found = false ;
+
+  lastseq = 0 ;                                               // Nothing known yet
+  lastdcrc = 0 ;
+  lastlen = 0 ;
+  lastpos = 0 ;
+  haslast = false ;
+  damaged = false ;
+  if ( hal_fs_size ( JOURNAL_NEW ) >= 0 )                     // Compaction not finished?
+  {
+    if ( hal_fs_size ( JOURNAL_FILE ) < 0 )
+    {
+      hal_fs_rename ( JOURNAL_NEW, JOURNAL_FILE ) ;           // Only the rename was left
+    }
+    else
+    {
+      hal_fs_remove ( JOURNAL_NEW ) ;                         // Old journal is complete
+    }
+  }
+  size = hal_fs_size ( JOURNAL_FILE ) ;
+  if ( size < 0 )
+  {
+    dbgprint ( "Journal %s not found", JOURNAL_FILE ) ;
+    return false ;
+  }
+  while ( pos + sizeof(head) + sizeof(crc) <= (size_t)size )  // Room for another record?
+  {
+    if ( ( hal_fs_read ( JOURNAL_FILE, pos, &head, sizeof(head) ) != sizeof(head) ) ||
+         ( head.magic != JOURNAL_MAGIC ) || ( head.len > sizeof(buf) ) ||
+         ( pos + sizeof(head) + head.len + sizeof(crc) > (size_t)size ) )
+    {
+      break ;                                                 // Bad or cut off, stop here
+    }
+    if ( hal_fs_read ( JOURNAL_FILE, pos + sizeof(head), buf,
+                       head.len ) != head.len ||
+         hal_fs_read ( JOURNAL_FILE, pos + sizeof(head) + head.len, &crc,
+                       sizeof(crc) ) != sizeof(crc) ||
+         crc != crc32 ( buf, head.len, crc32 ( &head, sizeof(head) ) ) )
+    {
+      break ;
+    }
+    if ( head.len <= maxlen )                                 // Fits for the caller?
+    {
+      memcpy ( data, buf, head.len ) ;                        // Yes, newest so far
+      *len = head.len ;
+      found = true ;
+    }
+    lastseq = head.seq ;                                      // Newest record
+    lastdcrc = crc32 ( buf, head.len ) ;
+    lastlen = head.len ;
+    lastpos = pos + sizeof(head) ;
+    haslast = true ;
+    pos += sizeof(head) + head.len + sizeof(crc) ;
+  }
+  damaged = ( pos < (size_t)size ) ;                          // Records after this are lost
+  dbgprint ( "Journal %s, %d bytes, record %u %s", JOURNAL_FILE, (int)size,
+             (unsigned)lastseq, found ? "loaded" : "not found" ) ;
+  return found ;
+}
+
+
+//******************************************************************************************
+//                              J O U R N A L _ S A V E                                    *
+//******************************************************************************************
+// Add a record.  Nothing is written if the data is the same as in the last record; the    *
+// CRC only tells that it may be, so then the last record is read back and compared.       *
+// A journal with a damaged end is replaced, a record appended after it would be lost.     *
+// That is also the case after an append that failed, it may have written a part of the    *
+// record.  The record is written with one call, so it costs one update of the file.       *
+// Returns false if the record could not be written.                                       *
+//******************************************************************************************
+static bool same_as_last ( const void* data, size_t len, uint32_t dcrc )
+{
+  uint8_t buf[JOURNAL_MAXDATA] ;                              // Data of the last record
+
+  if ( ( ! haslast ) || ( dcrc != lastdcrc ) || ( len != lastlen ) )
+  {
+    return false ;                                            // Surely not the same
+  }
+  return ( hal_fs_read ( JOURNAL_FILE, lastpos, buf, len ) == len ) &&
+         ( memcmp ( buf, data, len ) == 0 ) ;
+}
+
+
+bool journal_save ( const void* data, size_t len )
+{
+  uint8_t  rec[sizeof(jhead_t) + JOURNAL_MAXDATA + 4] ;       // The new record
+  jhead_t* head = (jhead_t*)rec ;                             // Head of the new record
+  uint32_t dcrc ;                                             // CRC of the data only
+  uint32_t crc ;                                              // CRC of the new record
+  size_t   reclen = sizeof(jhead_t) + len + sizeof(crc) ;     // Length of the new record
+  long     size ;                                             // Size of the journal
+  bool     ok ;
+
+  dcrc = crc32 ( data, len ) ;
+  if ( same_as_last ( data, len, dcrc ) )                     // Same as last record?
+  {
+    return true ;                                             // Yes, nothing to do
+  }
+  if ( len > JOURNAL_MAXDATA )
+  {
+    return false ;
+  }
+  head->magic = JOURNAL_MAGIC ;
+  head->seq = lastseq + 1 ;
+  head->len = len ;
+  head->spare = 0 ;
+  memcpy ( rec + sizeof(jhead_t), data, len ) ;
+  crc = crc32 ( rec, sizeof(jhead_t) + len ) ;
+  memcpy ( rec + sizeof(jhead_t) + len, &crc, sizeof(crc) ) ;
+  size = hal_fs_size ( JOURNAL_FILE ) ;
+  if ( damaged ||                                             // Journal damaged or full?
+       ( ( size >= 0 ) && ( size + reclen > JOURNAL_SIZE ) ) )
+  {
+    ok = hal_fs_write ( JOURNAL_NEW, rec, reclen, false ) &&  // Yes, start a new one
+         hal_fs_rename ( JOURNAL_NEW, JOURNAL_FILE ) ;        // and replace the old one
+    dbgprint ( "Journal compacted" ) ;
+    size = 0 ;                                                // Record is the first one
+  }
+  else
+  {
+    ok = hal_fs_write ( JOURNAL_FILE, rec, reclen, true ) ;   // Append
+    if ( ! ok )
+    {
+      damaged = true ;                                        // Maybe a part is written
+    }
+    if ( size < 0 )
+    {
+      size = 0 ;                                              // Journal was created
+    }
+  }
+  if ( ok )
+  {
+    damaged = false ;
+    lastseq = head->seq ;
+    lastdcrc = dcrc ;
+    lastlen = len ;
+    lastpos = size + sizeof(jhead_t) ;
+    haslast = true ;
+  }
+  return ok ;
+}
+
+
+uint32_t journal_seq()
+{
+  return lastseq ;
+}
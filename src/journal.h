@@ -0,0 +1,31 @@
+//******************************************************************************************
+// journal.h - Append-only journal of configuration records in a LittleFS file.           *
+//******************************************************************************************
+// Every save adds a record to the end of the file, nothing is overwritten.  A record has  *
+// a magic number, a sequence number, the length of the data and a CRC-32.  At boot the    *
+// last valid record is used; a record that was cut off by a power failure is ignored.     *
+// When the file is full, the newest record is written to a new file, which then replaces  *
+// the journal (a rename is atomic in LittleFS).  LittleFS spreads the writes over the     *
+// whole filesystem, so the flash wears much slower than with EEPROM.commit(), which       *
+// erases the same sector for every save.                                                  *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JOURNAL_FILE    "/settings.jnl"                       // The journal
+#define JOURNAL_NEW     "/settings.jnl.new"                   // New journal while compacting
+#define JOURNAL_SIZE    4096                                  // Compact at this size
+#define JOURNAL_MAXDATA  128                                  // Longest data of a record
+
+bool     journal_load ( void* data, size_t maxlen,            // Get newest valid record,
+                        size_t* len ) ;                       // false if there is none
+bool     journal_save ( const void* data, size_t len ) ;      // Add a record, unless the
+                                                              // data is the same as the last
+uint32_t journal_seq() ;                                      // Sequence nr of last record
+
+#endif
@@ -0,0 +1,152 @@
+//******************************************************************************************
+// jsonwriter.cpp - Write JSON into a fixed buffer, part by part.                         *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "jsonwriter.h"
+
+
+JsonWriter::JsonWriter ( uint8_t* buf, size_t maxLen, size_t skip )
+  : buf ( buf ), maxlen ( maxLen ), skip ( skip )
+{
+}
+
+
+//******************************************************************************************
+// Add one character of the document.  Only the part after skip that fits is stored.       *
+//******************************************************************************************
+void JsonWriter::put ( char c )
+{
+  if ( ( pos >= skip ) && ( out < maxlen ) )
+  {
+    buf[out++] = c ;
+  }
+  pos++ ;
+}
+
+
+void JsonWriter::puts ( const char* s )
+{
+  while ( *s )
+  {
+    put ( *s++ ) ;
+  }
+}
+
+
+//******************************************************************************************
+// Start a new member or element: a comma if it is not the first one, then the key.        *
+//******************************************************************************************
+void JsonWriter::member ( const char* key )
+{
+  if ( first & 1 )                                            // First at this level?
+  {
+    first &= ~1UL ;                                           // Yes, next one is not
+  }
+  else
+  {
+    put ( ',' ) ;
+  }
+  if ( key )
+  {
+    string ( key ) ;
+    put ( ':' ) ;
+  }
+}
+
+
+void JsonWriter::beginObject ( const char* key )
+{
+  member ( key ) ;
+  put ( '{' ) ;
+  first = ( first << 1 ) | 1 ;                                // New level, no member yet
+}
+
+
+void JsonWriter::endObject()
+{
+  put ( '}' ) ;
+  first >>= 1 ;                                               // Back to previous level
+}
+
+
+void JsonWriter::beginArray ( const char* key )
+{
+  member ( key ) ;
+  put ( '[' ) ;
+  first = ( first << 1 ) | 1 ;
+}
+
+
+void JsonWriter::endArray()
+{
+  put ( ']' ) ;
+  first >>= 1 ;
+}
+
+
+//******************************************************************************************
+// Add a string in quotes, with escapes where needed.                                      *
+//******************************************************************************************
+void JsonWriter::string ( const char* value )
+{
+  static const char hex[] = "0123456789abcdef" ;
+  uint8_t           c ;
+
+  put ( '"' ) ;
+  while ( ( c = *value++ ) )
+  {
+    if ( ( c == '"' ) || ( c == '\\' ) )
+    {
+      put ( '\\' ) ;
+      put ( c ) ;
+    }
+    else if ( c < 0x20 )                                      // Control character
+    {
+      puts ( "\\u00" ) ;
+      put ( hex[c >> 4] ) ;
+      put ( hex[c & 0x0F] ) ;
+    }
+    else
+    {
+      put ( c ) ;
+    }
+  }
+  put ( '"' ) ;
+}
+
+
+void JsonWriter::add ( const char* key, const char* value )
+{
+  member ( key ) ;
+  string ( value ) ;
+}
+
+
+void JsonWriter::add ( const char* key, long value )
+{
+  char  tmp[24] ;
+  char* p = tmp + sizeof(tmp) ;
+  bool  neg = value < 0 ;
+  unsigned long v = neg ? 0UL - (unsigned long)value : value ;
+
+  member ( key ) ;
+  *--p = '\0' ;
+  do
+  {
+    *--p = '0' + v % 10 ;
+    v /= 10 ;
+  } while ( v ) ;
+  if ( neg )
+  {
+    *--p = '-' ;
+  }
+  puts ( p ) ;
+}
+
+
+void JsonWriter::add ( const char* key, bool value )
+{
+  member ( key ) ;
+  puts ( value ? "true" : "false" ) ;
+}
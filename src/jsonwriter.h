@@ -0,0 +1,49 @@
+//******************************************************************************************
+// jsonwriter.h - Write JSON into a fixed buffer, part by part.                           *
+//******************************************************************************************
+// A JsonWriter is made for one buffer of a chunked response.  The document is produced    *
+// from the start every time, the first "skip" bytes (sent in earlier chunks) are counted  *
+// but not stored, and writing stops when the buffer is full.  So a document of any size   *
+// is sent without the heap and without keeping it in memory, as long as producing it      *
+// gives the same text every time.                                                         *
+// Commas between members and elements are added automatically.                           *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class JsonWriter
+{
+  public:
+    JsonWriter ( uint8_t* buf, size_t maxLen, size_t skip ) ;
+
+    void         beginObject ( const char* key = nullptr ) ;  // Key only inside an object
+    void         endObject() ;
+    void         beginArray ( const char* key = nullptr ) ;
+    void         endArray() ;
+    void         add ( const char* key, const char* value ) ; // String, escaped
+    void         add ( const char* key, long value ) ;
+    void         add ( const char* key, int value )      { add ( key, (long)value ) ; }
+    void         add ( const char* key, bool value ) ;
+    void         add ( long value )                      { add ( nullptr, value ) ; }
+
+    size_t       length() const          { return out ; }     // Bytes stored in buf
+
+  private:
+    void         put ( char c ) ;
+    void         puts ( const char* s ) ;
+    void         string ( const char* value ) ;
+    void         member ( const char* key ) ;                 // Comma and key
+    uint8_t*     buf ;                                        // Output buffer
+    size_t       maxlen ;                                     // Size of buf
+    size_t       skip ;                                       // Bytes already sent
+    size_t       pos = 0 ;                                    // Position in document
+    size_t       out = 0 ;                                    // Bytes stored in buf
+    uint32_t     first = 1 ;                                  // Bit per level: no member yet
+} ;
+
+#endif
@@ -1,580 +1,2500 @@
-//******************************************************************************************
-// AquariumLedVerlichting for Wemos D1 (ESp8266).                                          *
-// Powers 2 aquarium LED lights independantly.                                             *
-// A webserver is available to set intensity and timer.                                    *
-//******************************************************************************************
-// 08-08-2021, ES - First setup                                                            *
-//                                                                                         *
-// Wiring:                                                                                 *
-// GPIO    Wemos D1  Wired to                                                              *
-// ------  --------  ----------------------------------------------------------------------*
-// GPIO14    D5      PWM output Lamp A                                                     *
-// GPIO12    D6      PWM output Lamp B                                                     *
-//******************************************************************************************
-
-#include <Arduino.h>
-#include <ESP8266WiFi.h>
-#include <ArduinoOTA.h>
-#include <stdio.h>
-#include <string.h>
-#include <LittleFS.h>
-#include <ESPAsyncTCP.h>
-#include <ESPAsyncWebServer.h>
-#include <mdns.h>
-#include <Ticker.h>
-#include <NTPClient.h>
-#include <EEPROM.h>
-#include <Timezone.h>    // https://github.com/JChristensen/Timezone
-
-#define VERSION            "Wed, 28 Jul 2021 07:12:00 GMT"
-#define DEBUG_BUFFER_SIZE  150                                // Line length for debugging
-#define HTTPPORT            80                                // Port for HTTP communication
-#define HOSTNAME    "AqLedVerl"                               // Hostname
-#define LAMPA               D5                                // GPIO used for lamp A
-#define LAMPB               D6                                // GPIO used for lamp B
-
-ADC_MODE(ADC_VCC) ;                                           // Allow ADC to read VCC
-
-// Forward declarations
-const char* getEncryptionType ( int thisType ) ;
-
-const int       DEBUG =   1 ;                                 // Output debug messages if ! 0
-
-// Central European Time (Amsterdam, Frankfurt, Paris)
-TimeChangeRule CEST = { "CEST", Last, Sun, Mar, 2, 120 } ;    // Central European Summer Time
-TimeChangeRule CET  = { "CET ", Last, Sun, Oct, 3,  60 } ;    // Central European Standard Time
-Timezone       myTZ ( CEST, CET ) ;                           // Timezone to be used
-
-WiFiUDP              ntpUDP ;                                 // For NTP service
-NTPClient            timeClient ( ntpUDP ) ;                  // For NTP service
-mdns::MDns           my_mdns ( NULL, NULL, NULL ) ;           // mDNS without callbacks
-Ticker               tckr ;                                   // For timing 1000 msec
-String               ssid ;                                   // Network in use
-AsyncWebServer*      httpserver;                              // Embedded webserver
-
-std::vector<String>  dbglines ;                               // Container for last debug lines
-
-struct set_t
-{
-  uint8_t            values[48] ;                             // Settings for 24 hours, 2 lamps
-} ;
-uint8_t              intensityA = 0 ;                         // Intensity lamp A 0..100
-uint8_t              intensityB = 0 ;                         // Intensity lamp B 0..100
-time_t               ltime ;                                  // Local time
-set_t                settings ;                               // Settings for 2 x 24 hours
-bool                 overrule = false ;                       // True for overrule normal intensity
-uint8_t              ovA, ovB ;                               // Overrule intensities
-
-//**************************************************************************************************
-//                                          D B G P R I N T                                        *
-//**************************************************************************************************
-// Send a line of info to serial output.  Works like vsprintf(), but checks the DEBUG flag.        *
-// Debug lines will be added to dbglines, a buffer holding the last debuglines.                    *
-// Print only if DEBUG flag is true.                                                               *
-//**************************************************************************************************
-void dbgprint ( const char* format, ... )
-{
-  static char sbuf[DEBUG_BUFFER_SIZE] ;                // For debug lines
-  char        tbuf[16] ;                               // Buffer for time of day
-  va_list     varArgs ;                                // For variable number of params
-  String      dbgline ;                                // Resulting line
-
-  va_start ( varArgs, format ) ;                       // Prepare parameters
-  vsnprintf ( sbuf, sizeof(sbuf), format, varArgs ) ;  // Format the message
-  va_end ( varArgs ) ;                                 // End of using parameters
-  if ( DEBUG )                                         // DEBUG on?
-  {
-    sprintf ( tbuf, "%02d:%02d:%02d - ",               // Convert time
-              hour(ltime),
-              minute(ltime),
-              second(ltime) ) ;
-    dbgline = String ( tbuf ) +                        // Format debugline
-              String ( sbuf ) ;
-    Serial.println ( dbgline ) ;                       // Yes, print info
-    if ( ESP.getFreeHeap() > 8000 )                    // Memory shortage due to debug lines?
-    {
-      dbglines.push_back ( dbgline ) ;                 // No, add to buffer with debug lines
-    }
-  }
-}
-
-
-//******************************************************************************************
-//                                  T I M E R 1 S E C                                      *
-//******************************************************************************************
-// Will be called every second.                                                            *
-//******************************************************************************************
-void timer1sec()
-{
-  ltime++ ;                               // Update local time
-}
-
-
-//******************************************************************************************
-//                                L I S T N E T W O R K S                                  *
-//******************************************************************************************
-// List the available networks and select the strongest.                                   *
-// Acceptable networks are those who have a "SSID.pw" file in the LittleFS.                *
-//******************************************************************************************
-void listNetworks()
-{
-  int         maxsig = -1000 ;   // Used for searching strongest WiFi signal
-  int         newstrength ;
-  byte        encryption ;       // TKIP(WPA)=2, WEP=5, CCMP(WPA)=4, NONE=7, AUTO=8 
-  const char* acceptable ;       // Netwerk is acceptable for connection
-  int         i ;
-  String      path ;             // Full filespec to see if SSID is an acceptable one
-  
-  // scan for nearby networks:
-  dbgprint ( "Scan Networks" ) ;
-  int numSsid = WiFi.scanNetworks() ;
-  if ( numSsid == -1 )
-  {
-    dbgprint ( "Couldn't get a wifi connection" ) ;
-    return ;
-  }
-  // print the list of networks seen:
-  dbgprint ( "Number of available networks: %d",
-             numSsid ) ;
-  // Print the network number and name for each network found and
-  // find the strongest acceptable network
-  for ( i = 0 ; i < numSsid ; i++ )
-  {
-    acceptable = "" ;                                    // Assume not acceptable
-    path = String ( "/" ) + WiFi.SSID ( i ) + String ( ".pw" ) ;
-    newstrength = WiFi.RSSI ( i ) ;
-    if ( LittleFS.exists ( path ) )                      // Is this SSID acceptable?
-    {
-      acceptable = "Acceptable" ;
-      if ( newstrength > maxsig )                        // This is a better Wifi
-      {
-        maxsig = newstrength ;
-        ssid = WiFi.SSID ( i ) ;                         // Remember SSID name
-      }
-    }
-    encryption = WiFi.encryptionType ( i ) ;
-    dbgprint ( "%2d - %-25s Signal: %3d dBm Encryption %4s  %s",
-               i + 1, WiFi.SSID ( i ).c_str(), WiFi.RSSI ( i ),
-               getEncryptionType ( encryption ),
-               acceptable ) ;
-  }
-  dbgprint ( "--------------------------------------" ) ;
-  dbgprint ( "Selected network: %-25s", ssid.c_str() ) ;
-}
-
-
-//******************************************************************************************
-//                             G E T E N C R Y P T I O N T Y P E                           *
-//******************************************************************************************
-// Read the encryption type of the network and return as a 4 byte name                     *
-//******************************************************************************************
-const char* getEncryptionType ( int thisType )
-{
-  switch (thisType) 
-  {
-    case ENC_TYPE_WEP:
-      return "WEP " ;
-    case ENC_TYPE_TKIP:
-      return "WPA " ;
-    case ENC_TYPE_CCMP:
-      return "WPA2" ;
-    case ENC_TYPE_NONE:
-      return "None" ;
-    case ENC_TYPE_AUTO:
-      return "Auto" ;
-  }
-  return "????" ;
-}
-
-
-//******************************************************************************************
-//                               C O N N E C T W I F I                                     *
-//******************************************************************************************
-// Connect to WiFi using passwords available in the LittleFS.                              *
-//******************************************************************************************
-void connectwifi()
-{
-  String path ;                                        // Full file spec
-  String pw ;                                          // Password from file
-  File   pwfile ;                                      // File containing password for WiFi
-  
-  path = String ( "/" )  + ssid + String ( ".pw" ) ;   // Form full path
-  pwfile = LittleFS.open ( path, "r" ) ;                 // File name equal to SSID
-  pw = pwfile.readStringUntil ( '\n' ) ;               // Read password as a string
-  pw.trim() ;                                          // Remove CR                              
-  WiFi.begin ( ssid.c_str(), pw.c_str() ) ;            // Connect to selected SSID
-  dbgprint ( "Try WiFi %s",
-             ssid.c_str() ) ;                          // Message to show during WiFi connect
-  if (  WiFi.waitForConnectResult() != WL_CONNECTED )  // Try to connect
-  {
-    dbgprint ( "WiFi Failed!" ) ;
-    return ;
-  }
-  dbgprint ( "IP = %d.%d.%d.%d",
-              WiFi.localIP()[0], WiFi.localIP()[1],
-              WiFi.localIP()[2], WiFi.localIP()[3] ) ;
-}
-
-
-//******************************************************************************************
-//                             G E T C O N T E N T T Y P E                                 *
-//******************************************************************************************
-// Returns the contenttype of a file to send.                                              *
-//******************************************************************************************
-String getContentType ( String filename )
-{
-  if      ( filename.endsWith ( ".html" ) ) return "text/html" ;
-  else if ( filename.endsWith ( ".png"  ) ) return "image/png" ;
-  else if ( filename.endsWith ( ".gif"  ) ) return "image/gif" ;
-  else if ( filename.endsWith ( ".jpg"  ) ) return "image/jpeg" ;
-  else if ( filename.endsWith ( ".ico"  ) ) return "image/x-icon" ;
-  else if ( filename.endsWith ( ".css"  ) ) return "text/css" ;
-  else if ( filename.endsWith ( ".zip"  ) ) return "application/x-zip" ;
-  else if ( filename.endsWith ( ".gz"   ) ) return "application/x-gzip" ;
-  else if ( filename.endsWith ( ".pw"   ) ) return "" ;              // Passwords are secret
-  return "text/plain" ;
-}
-
-
-//**************************************************************************************************
-//                                        C B  _ L O G G I N G                                     *
-//**************************************************************************************************
-// Callback function for handle_logging, will be called for every chunk to send to client.         *
-// If no more data is availble, this function will return 0.                                       *
-//**************************************************************************************************
-size_t cb_logging ( uint8_t *buffer, size_t maxLen, size_t index )
-{
-  static int   i ;                                   // Index in dbglines
-  static int   nrl ;                                 // Mumber of lines in dbglines
-  static char  linebuf[DEBUG_BUFFER_SIZE + 20] ;     // Holds one debug line
-  static char* p_in ;                                // Pointer in linebuf
-  char*        p_out = (char*)buffer ;               // Fill pointer for output buffer
-  String       s ;                                   // Single line from dbglines
-  size_t       len = 0 ;                             // Number of bytes filled in buffer
-  
-  if ( index == 0 )                                 // First call for this page?
-  {
-    i = 0 ;                                         // Yes, set index
-    nrl = dbglines.size() ;                         // Number of lines in dbglines
-    p_in = linebuf ;                                // Set linebuf to empty
-    *p_in = '\0' ;
-  }
-  while ( maxLen-- > 0 )                            // Space for another character?
-  {
-    if ( *p_in == '\0' )                            // Input buffer end?
-    {
-      if ( i == nrl )                               // Yes, is there another line?
-      {
-        break ;                                     // No, end of text
-      }
-      s = dbglines[i++] ;                           // Yes, get next line from container
-      strcpy ( linebuf, s.c_str() ) ;               // Fill linebuf
-      strcat ( linebuf, "\n" ) ;                    // Add a break
-      p_in = linebuf ;                              // Pointer to start of line
-    }
-    *p_out++ = *p_in++ ;                            // Copy next character
-    len++ ;                                         // Increase result length
-  }
-  // We come here if output buffer is completely full or if end of dbglines is reached
-  return len ;                                      // Return filled length of buffer
-}
-
-
-//**************************************************************************************************
-//                                    H A N D L E _ L O G G I N G                                  *
-//**************************************************************************************************
-// Called from logging page to list the logging in dbglines.                                       *
-// It will handle the chunks for the client.  The buffer is filled by the callback routine.        *
-//**************************************************************************************************
-void handle_logging ( AsyncWebServerRequest *request )
-{
-  AsyncWebServerResponse *response ;
-
-  dbgprint ( "HTTP logging request" ) ;
-  response = request->beginChunkedResponse ( "text/plain", cb_logging ) ;
-  response->addHeader ( "Server", HOSTNAME ) ;
-  request->send ( response ) ;
-}
-
-
-//******************************************************************************************
-//                                   H A N D L E _ T E S T                                 *
-//******************************************************************************************
-// Handle Test button.                                                                     *
-//******************************************************************************************
-void handle_test ( AsyncWebServerRequest *request )
-{
-  static char        reply[32] ;                        // Reply to client
-
-  sprintf ( reply, "Free memory is %d",                 // Testing
-            ESP.getFreeHeap() ) ;
-  dbgprint ( reply ) ;
-  request->send ( 200, "text/plain", reply ) ;
-}
-
-
-//******************************************************************************************
-//                                H A N D L E _ R O O T                                    *
-//******************************************************************************************
-// Handle homepage.                                                                        *
-//******************************************************************************************
-void handle_root ( AsyncWebServerRequest *request )
-{
-  request->send ( LittleFS, "/index.html" ) ;
-}
-
-
-//******************************************************************************************
-//                                H A N D L E _ R E S E T                                  *
-//******************************************************************************************
-// Handle reset request.                                                                   *
-//******************************************************************************************
-void handle_reset ( AsyncWebServerRequest *request )
-{
-  ESP.reset() ;
-}
-
-
-//******************************************************************************************
-//                             H A N D L E _ G E T C O N F                                 *
-//******************************************************************************************
-// Handle get configuration request.                                                       *
-// Return a string with 48 settings.                                                       *
-//******************************************************************************************
-void handle_getconf ( AsyncWebServerRequest *request )
-{
-  String    reply = "" ;                                // Reply to client
-  int       i ;                                         // Loop control
-
-  dbgprint ( "HTTP getconf request" ) ;
-  for ( i = 0 ; i < 48 ; i++ )                          // Settings for 24 hours, 2 lamps
-  {
-    reply += String ( settings.values[i] ) ;            // Add setting
-    reply += String ( ',' ) ;                           // Separator
-  }
-  request->send ( 200, "text/plain", reply ) ;
-}
-
-
-//******************************************************************************************
-//                             H A N D L E _ S E T C O N F                                 *
-//******************************************************************************************
-// Handle set configuration request.                                                       *
-// parameter is a string with 48 settings, separated by a comma                            *
-//******************************************************************************************
-void handle_setconf ( AsyncWebServerRequest *request )
-{
-  AsyncWebParameter* p ;                                // Points to parameter structure
-  String             value ;                            // Parameter value
-  int                i ;                                // Loop control
-  int                inx ;                              // Position of next comma
-
-  dbgprint ( "HTTP setconf request" ) ;
-  p = request->getParam ( 0 ) ;                         // Get pointer to parameter structure
-  value = p->value() ;                                  // Get value
-  for ( i = 0 ; i < 48 ; i++ )                          // Settings for 24 hours, 2 lamps
-  {
-    settings.values[i] = value.toInt() ;                // Get next setting
-    inx = value.indexOf ( "," ) ;                       // Find comma in string
-    if ( inx > 0 )
-    {
-      value = value.substring ( inx + 1 ) ;             // Skip to next integer value
-    }
-  }
-  overrule = false ;                                    // No more overrule
-  EEPROM.put ( 0, settings ) ;                          // Save in EEPROM
-  EEPROM.commit() ;                                     // And commint
-  request->send ( 200, "text/plain",                    // Reply
-                       "SET command accepted" ) ;
-}
-
-
-//******************************************************************************************
-//                           H A N D L E _ O V E R R U L E                                 *
-//******************************************************************************************
-// Handle overlue normal intensity settings.                                               *
-// Parameter is a string with 2 settings, separated by a comma                             *
-//******************************************************************************************
-void handle_overrule ( AsyncWebServerRequest *request )
-{
-  AsyncWebParameter* p ;                                // Points to parameter structure
-  String             value ;                            // Parameter value
-  int                inx ;                              // Position of next comma
-
-  dbgprint ( "HTTP overrule request" ) ;
-  p = request->getParam ( 0 ) ;                         // Get pointer to parameter structure
-  value = p->value() ;                                  // Get value
-  overrule = true ;                                     // Set overrule flag
-  ovA = value.toInt() ;                                 // Set overule lamp A value
-  inx = value.indexOf ( "," ) ;                         // Find comma in string
-  if ( inx > 0 )
-  {
-    value = value.substring ( inx + 1 ) ;               // Skip to next integer value
-    ovB = value.toInt() ;                               // Set overul lamp B value
-  }
-  request->send ( 200, "text/plain",                    // Reply
-                       "Overrule command accepted" ) ;
-}
-
-
-//******************************************************************************************
-//                              O N F I L E R E Q U E S T                                  *
-//******************************************************************************************
-// Handle requests for file/html-pages.                                                    *
-// The requested filename is in url.                                                       *
-//******************************************************************************************
-void onFileRequest ( AsyncWebServerRequest *request )
-{
-  String fnam ;
-  String ct ;                                           // Content type
-
-  fnam = request->url() ;
-  dbgprint ( "onFileRequest received %s",
-             fnam.c_str() ) ;
-  ct = getContentType ( fnam ) ;                        // Get content type
-  if ( ct == "" )                                       // Empty is illegal
-  {
-    request->send ( 404, "text/plain", "File not found" ) ;  
-  }
-  else
-  {
-    request->send ( LittleFS, fnam, ct ) ;                // Okay, send the file
-  }
-}
-
-
-//******************************************************************************************
-//                                   O T A S T A R T                                       *
-//******************************************************************************************
-// Update via WiFi has been started by Arduino IDE.                                        *
-//******************************************************************************************
-void otastart()
-{
-  dbgprint ( "OTA Started" ) ;
-}
-
-
-//******************************************************************************************
-//                                   S E T U P                                             *
-//******************************************************************************************
-// Setup for the program.                                                                  *
-//******************************************************************************************
-void setup()
-{
-  FSInfo      fs_info ;                              // LittleFS info
-  Dir         dir ;
-
-  Serial.begin ( 115200 ) ;                          // For debugging
-  Serial.println ( ) ;
-  EEPROM.begin ( 512 ) ;                             // Enable EEPROM
-  EEPROM.get ( 0, settings ) ;                       // Get settings from EEPROM
-  dbgprint ( "Starting " HOSTNAME "..." ) ;          // Show activity
-  dbgprint ( "Version " VERSION ) ;
-  pinMode ( LED_BUILTIN, OUTPUT ) ;                  // Configure onboard LED pin
-  pinMode ( LAMPA, OUTPUT ) ;                        // Configure LED lamp A
-  pinMode ( LAMPB, OUTPUT ) ;                        // Configure LED lamp B
-  analogWriteRange ( 100 ) ;                         // PWM range 0..100 percent
-  digitalWrite ( LED_BUILTIN, LOW ) ;                // Show LED for test
-  delay ( 500 ) ;                                    // For at least 500 msec
-  // Show some info about the LittleFS
-  LittleFS.begin() ;                                 // Enable file system
-  LittleFS.info ( fs_info ) ;
-  dbgprint ( "FS Total %d, used %d",                 // Show FS overview
-             fs_info.totalBytes,
-             fs_info.usedBytes ) ;
-  dir = LittleFS.openDir ( "/" ) ;                   // Show files in FS
-  while ( dir.next() )                               // All files
-  {
-    String filename = dir.fileName() ;
-    if ( dir.fileSize() )
-    {
-      File f = dir.openFile ( "r" ) ;
-      dbgprint ( "%-32s - %6d",                      // Show name and size
-                 filename.c_str(), f.size() ) ;
-    }
-  }
-  WiFi.mode ( WIFI_STA ) ;                           // This ESP is a station
-  wifi_station_set_hostname ( HOSTNAME ) ;           // Set hostname
-  listNetworks() ;
-  connectwifi() ;
-  if ( DEBUG )
-  {
-    Serial.println ( ) ;
-    Serial.println ( "WiFi connected" ) ;
-    Serial.print   ( "Local   IP address: " ) ;
-    Serial.println ( WiFi.localIP() ) ;
-    Serial.print   ( "Gateway IP address: " ) ;
-    Serial.println ( WiFi.gatewayIP() ) ;
-  }
-  httpserver = new AsyncWebServer ( HTTPPORT ) ;     // Create HTTP server
-  httpserver->on ( "/",         handle_root ) ;      // Homepage request
-  httpserver->on ( "/logging",  handle_logging ) ;   // Handle logging by a callback
-  httpserver->on ( "/getconf",  handle_getconf ) ;   // Handle get configuration
-  httpserver->on ( "/setconf",  handle_setconf ) ;   // Handle get configuration
-  httpserver->on ( "/overrule", handle_overrule ) ;  // Handle get configuration
-  httpserver->on ( "/reset",    handle_reset ) ;     // Handle reset request
-  httpserver->on ( "/test",     handle_test ) ;      // Handle test request
-  httpserver->onNotFound ( onFileRequest ) ;         // Handling of other requests
-  httpserver->begin() ;                              // Start http server
-  dbgprint ( "HTTP-server started on port %d",       // Show event
-             HTTPPORT ) ;
-  ArduinoOTA.setHostname ( HOSTNAME ) ;              // Set the hostname
-  ArduinoOTA.onStart ( otastart ) ;
-  ArduinoOTA.begin() ;                               // Allow update over the air
-  timeClient.begin() ;                               // Enable NTP service
-  tckr.attach ( 1.0, timer1sec ) ;                   // Every 1000 msec
-  digitalWrite ( LED_BUILTIN, HIGH ) ;               // Turn LED off
-}
-
-
-//******************************************************************************************
-//                                   L O O P                                               *
-//******************************************************************************************
-// Main loop of the program.                                                               *
-//******************************************************************************************
-void loop()
-{
-  String          ftm ;                                     // Formatted time
-  time_t          utc ;                                     // Epochtime (utc)
-  static bool     time_ok = false ;                         // Time is okay
-  static uint32_t rfrltm = 0 ;                              // Timer for refresh local time
-  uint32_t        millisnow ;                               // Current value of 
-  uint8_t         inx ;                                     // Index in settings
-  uint8_t         newA ;                                    // New intensity for lamp A
-  uint8_t         newB ;                                    // New intensity for lamp B
-
-  millisnow = millis() ;                                    // Get runtime
-  time_ok = timeClient.update() ;                           // Update time
-  if ( time_ok )                                            // Do we know the time?
-  {
-    if ( millisnow > rfrltm )                               // Yes, need for refresh?
-    {
-      rfrltm = millisnow * 1000 * 600 ;                     // Yes, set new refreshmoment
-      utc = timeClient.getEpochTime() ;
-      ltime = myTZ.toLocal ( utc ) ;                        // Convert to local
-    }
-  }
-  if ( overrule )                                           // Overrule timed setting?
-  {
-    newA = ovA ;                                            // Yes, get new setting
-    newB = ovB ;
-  }
-  else
-  {
-    inx = hour ( ltime ) ;                                  // Index in settings (0..47)
-    newA = settings.values[inx*2] ;                         // Get intensity lamp A
-    newB = settings.values[inx*2+1] ;                       // Get intensity lamp B
-  }
-  if ( newA != intensityA )                                 // Lamp A change needed?
-  {
-    intensityA = newA ;                                     // Yes, remember new value
-    analogWrite ( LAMPA, intensityA ) ;                     // Set intensity lamp A
-  }
-  if ( newB != intensityB )                                 // Lamp B change needed?
-  {
-    intensityB = newB ;                                     // Yes, remember new value
-    analogWrite ( LAMPB, intensityB ) ;                     // Set intensity lamp B
-  }
-  my_mdns.loop() ;                                          // Handle mDNS
-  ArduinoOTA.handle() ;                                     // Check for OTA
-}
+//******************************************************************************************
+// AquariumLedVerlichting for Wemos D1 (ESp8266).                                          *
+// Powers 2 aquarium LED lights independantly.                                             *
+// A webserver is available to set intensity and timer.                                    *
+//******************************************************************************************
+// 08-08-2021, ES - First setup                                                            *
+// 16-10-2026, AG - Hardware access through hal.h, allows a build for a Linux host         *
+// 16-10-2026, AG - No heap allocations after setup(), debug lines in a ring buffer        *
+// 16-10-2026, AG - Checked parsing of setconf and overrule parameters                     *
+// 16-10-2026, AG - Partial configuration updates with /patchconf                          *
+// 16-10-2026, AG - Cached getconf reply with ETag                                         *
+// 16-10-2026, AG - Binary configuration at /conf.bin                                      *
+// 16-10-2026, AG - State as JSON at /api/state                                            *
+// 16-10-2026, AG - Live preview of intensities                                            *
+// 16-10-2026, AG - Handlers pass their changes to loop() through a queue                  *
+// 16-10-2026, AG - Double buffered settings                                               *
+// 16-10-2026, AG - Settings saved in a journal on LittleFS instead of EEPROM              *
+// 16-10-2026, AG - Saved settings with layout version and CRC, defaults in flash          *
+// 16-10-2026, AG - Static files gzipped, with ETag and Cache-Control                      *
+// 16-10-2026, AG - Optionally web files compiled in                                       *
+// 16-10-2026, AG - Content type from a sorted table                                       *
+// 16-10-2026, AG - Missing files found with the file index in RAM                         *
+// 16-10-2026, AG - Home page filled with the settings, no getconf request needed          *
+// 16-10-2026, AG - Configuration and files in a POST body, handled while it arrives       *
+// 16-10-2026, AG - Admission control, 503 with Retry-After when overloaded                *
+// 16-10-2026, AG - Several operations in one request with /batch, overrule with an end    *
+// 16-10-2026, AG - Changes pushed to the browser as Server-Sent Events on /events         *
+// 16-10-2026, AG - Long poll for a change with /wait                                      *
+// 17-10-2026, AG - Buffers of a request released when it disconnects                      *
+// 17-10-2026, AG - Snapshot of the state kept until its request disconnects               *
+// 17-10-2026, AG - Bare settings never taken for a record with a header                   *
+// 17-10-2026, AG - Record with layout 0 refused, EEPROM only read if there is no journal  *
+// 17-10-2026, AG - If-None-Match compared tag by tag, "*" also for static files           *
+// 17-10-2026, AG - Content type copied from PROGMEM                                       *
+// 17-10-2026, AG - Home page that cannot be filled is an error, not a broken page         *
+// 17-10-2026, AG - Upload of index.html refused while the home page is being sent         *
+// 17-10-2026, AG - Snapshot of a batch taken before its command is queued                 *
+// 17-10-2026, AG - Only parked /wait requests count, woken at once by a change            *
+// 17-10-2026, AG - /wait not woken from loop(), active unless it is parked                *
+// 17-10-2026, AG - Home page read from one open file, an unreadable page aborted          *
+// 17-10-2026, AG - Admission counter of the command queue named "commands"                *
+//                                                                                         *
+// Wiring:                                                                                 *
+// GPIO    Wemos D1  Wired to                                                              *
+// ------  --------  ----------------------------------------------------------------------*
+// GPIO14    D5      PWM output Lamp A                                                     *
+// GPIO12    D6      PWM output Lamp B                                                     *
+//******************************************************************************************
+
+#include "hal.h"
+#include "fixstring.h"
+#include "alloccount.h"
+#include "parse.h"
+#include "crc.h"
+#include "jsonwriter.h"
+#include "spscqueue.h"
+#include "journal.h"
+#include "embassets.h"
+#include "mimetype.h"
+#include "template.h"
+#include "admit.h"
+#include "push.h"
+#include <ctype.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define VERSION            "Wed, 28 Jul 2021 07:12:00 GMT"
+#define DEBUG_BUFFER_SIZE  150                                // Line length for debugging
+#define DEBUG_LINES         32                                // Number of debug lines kept
+#define HTTPPORT            80                                // Port for HTTP communication
+#define MAXINTENSITY       100                                // Intensity is 0..100 percent
+#define CONFMAGIC   0x434C5141                                // "AQLC", binary configuration
+#define CONFVERSION          1                                // Layout of confbin_t
+#define SETMAGIC    0x53514141                                // "AAQS", saved settings
+#define SETLAYOUT            1                                // Layout of setrec_t
+#define STATE_SLOTS ( ADMIT_ACTIVE + WAIT_CLIENTS )          // Snapshots for /api/state,
+                                                              // the home page and /wait
+#define STATE_NONE        0xFF                                // No snapshot
+#define PREVIEW_TIME     60000                                // Preview ends after 60 s idle
+#define CMD_SLOTS           16                                // Size of command queue
+#define SAVE_DELAY        5000                                // Save settings 5 s after change
+#define MAX_ASSETS          16                                // Static files with an ETag
+#define UPLOAD_FILE "/upload.tmp"                             // Upload being written
+#define WAIT_TIME           20                                // Default time of /wait, sec
+#define WAIT_MAXTIME        60                                // Longest time of /wait, sec
+#define WAIT_CLIENTS         4                                // /wait requests at one time
+#define HOSTNAME    "AqLedVerl"                               // Hostname
+
+const int       DEBUG =   1 ;                                 // Output debug messages if ! 0
+
+AsyncWebServer*      httpserver;                              // Embedded webserver
+
+typedef FixedString<DEBUG_BUFFER_SIZE> dbgline_t ;            // One debug line
+dbgline_t            dbglines[DEBUG_LINES] ;                  // Ring buffer with last debug lines
+uint16_t             dbghead = 0 ;                            // Oldest line in dbglines
+uint16_t             dbgcount = 0 ;                           // Number of lines in dbglines
+
+struct set_t
+{
+  uint8_t            values[48] ;                             // Settings for 24 hours, 2 lamps
+} ;
+struct confbin_t                                              // Binary configuration for
+{                                                             // /conf.bin, little endian
+  uint32_t           magic ;                                  // CONFMAGIC
+  uint8_t            version ;                                // CONFVERSION
+  uint8_t            nvalues ;                                // Number of values, 48
+  uint16_t           maxval ;                                 // Highest intensity allowed
+  set_t              set ;                                    // The settings
+  uint32_t           crc ;                                    // CRC-32 of the fields above
+} ;
+static_assert ( sizeof(confbin_t) == 60, "confbin_t has no padding" ) ;
+struct setrec_t                                               // Settings as saved in the
+{                                                             // journal
+  uint32_t           magic ;                                  // SETMAGIC
+  uint16_t           layout ;                                 // SETLAYOUT
+  uint16_t           len ;                                    // Size of set
+  uint32_t           crc ;                                    // CRC-32 of set
+  set_t              set ;                                    // The settings
+} ;
+static_assert ( sizeof(setrec_t) <= JOURNAL_MAXDATA, "setrec_t fits in a journal record" ) ;
+
+// Settings for a fresh chip or if the saved settings are unusable.  Lamp A, lamp B.
+static constexpr set_t defset PROGMEM =
+{
+  {
+     0,  0,    0,  0,    0,  0,    0,  0,    0,  0,    0,  0,   //  0.. 5 hours, night
+     0,  0,    0,  0,   20, 10,   50, 30,   80, 60,   80, 60,   //  6..11 hours, sunrise
+    80, 60,   80, 60,   80, 60,   80, 60,   80, 60,   80, 60,   // 12..17 hours, day
+    80, 60,   80, 60,   40, 20,   10,  5,    0,  0,    0,  0    // 18..23 hours, sunset
+  }
+} ;
+
+struct asset_t                                                // Static file in LittleFS
+{
+  FixedString<32>    name ;                                   // Path, like "/style.css.gz"
+  FixedString<11>    etag ;                                   // Quoted CRC-32 of contents
+  bool               immutable ;                              // Hash in name, never changes
+} ;
+
+struct state_t                                                // Snapshot for a response
+{
+  set_t              set ;                                    // Settings
+  uint32_t           setversion ;                             // Version of set
+  uint32_t           statever ;                               // See stateversion
+  uint8_t            intensityA, intensityB ;                 // Current intensities
+  bool               overrule ;                               // Overrule active
+  bool               preview ;                                // Preview active
+  uint8_t            ovA, ovB ;                               // Overrule intensities
+  uint32_t           ovleft ;                                 // Seconds of overrule, 0 if
+                                                              // no end
+  bool               time_ok ;                                // Time is known
+  time_t             ltime ;                                  // Local time
+  int                rssi ;                                   // WiFi signal in dBm
+  uint32_t           heap ;                                   // Free memory
+  admit_stats_t      admit ;                                  // Admission counters
+  bool               page ;                                   // Used for the home page
+  int                file ;                                   // index.html for the page,
+                                                              // -1 if not open
+  tplcur_t           cur ;                                    // Where the page is
+  AsyncWebServerRequest* owner ;                              // Request that uses it,
+} ;                                                           // nullptr if free
+
+enum cmd_code_t                                               // Commands for loop()
+{
+  CMD_SETCONF,                                                // Accept and save set
+  CMD_OVERRULE,                                               // Overrule with a and b
+  CMD_PREVIEW,                                                // Preview a and b
+  CMD_BATCH,                                                  // Operations of a batch
+  CMD_RESET                                                   // Restart
+} ;
+
+struct cmd_t                                                  // Command from a handler
+{
+  uint8_t            code ;                                   // One of cmd_code_t
+  uint8_t            a, b ;                                   // Intensities lamp A and B
+  uint8_t            flags ;                                  // Batch, see batch_t
+  uint32_t           ovtime ;                                 // Batch, length of overrule
+  set_t              set ;                                    // New settings
+} ;
+
+uint8_t              intensityA = 0 ;                         // Intensity lamp A 0..100
+uint8_t              intensityB = 0 ;                         // Intensity lamp B 0..100
+time_t               ltime ;                                  // Local time
+bool                 time_ok = false ;                        // Time is known from NTP
+set_t                setcopy[2] ;                             // Settings for 2 x 24 hours,
+                                                              // active and staging copy
+uint8_t              setactive = 0 ;                          // Index of active copy
+uint32_t             setversion = 0 ;                         // Number of publishes
+uint32_t             stateversion = 0 ;                       // Changes of outputs, overrule
+                                                              // or settings, for /wait
+bool                 savedue = false ;                        // Settings not yet in journal
+uint32_t             savetime ;                               // Time of first unsaved change
+bool                 overrule = false ;                       // True for overrule normal intensity
+uint8_t              ovA, ovB ;                               // Overrule intensities
+uint32_t             ovtime ;                                 // Length of overrule, 0 if
+                                                              // no end
+uint32_t             ovstart ;                                // Start of overrule
+bool                 preview = false ;                        // Preview intensities shown
+uint8_t              pvA, pvB ;                               // Latest preview intensities
+uint32_t             pvtime ;                                 // Time of latest preview
+SpscQueue<cmd_t, CMD_SLOTS> cmdqueue ;                        // Handlers to loop()
+set_t                reqset ;                                 // Settings as requested, may
+                                                              // still be in cmdqueue
+FixedString<48*4+1>  confbody ;                               // Cached reply of getconf
+FixedString<11>      confetag ;                               // ETag of confbody
+uint32_t             confversion = ~0U ;                      // Settings in confbody
+const String         hdr_inm ( "If-None-Match" ) ;            // Too long for SSO, so once
+const String         ct_binary ( "application/octet-stream" ) ; // Content type of conf.bin
+const String         ct_json ( "application/json" ) ;         // Content type of /api/state
+const String         hdr_cc ( "Cache-Control" ) ;             // Headers for static files
+const String         hdr_ce ( "Content-Encoding" ) ;
+const String         hdr_ae ( "Accept-Encoding" ) ;
+const String         cc_immutable ( "public, max-age=31536000, immutable" ) ;
+const String         cc_nocache ( "no-cache" ) ;
+const String         hdr_retry ( "Retry-After" ) ;            // Header of a 503
+const String         ct_events ( "text/event-stream" ) ;      // Content type of /events
+asset_t              assets[MAX_ASSETS] ;                     // Static files, found at boot
+uint8_t              nassets = 0 ;                            // Number of entries in assets
+state_t              states[STATE_SLOTS] ;                    // Snapshots for responses
+tpl_t                indextpl ;                               // Home page with its fields
+bool                 indexok = false ;                        // indextpl can be used
+const void*          indexdata = nullptr ;                    // Compiled-in page, nullptr
+                                                              // if in LittleFS
+
+//**************************************************************************************************
+//                                          D B G P R I N T                                        *
+//**************************************************************************************************
+// Send a line of info to serial output.  Works like vsprintf(), but checks the DEBUG flag.        *
+// Debug lines will be added to dbglines, a ring buffer holding the last debuglines.  When the     *
+// buffer is full, the oldest line is overwritten.                                                 *
+// Print only if DEBUG flag is true.                                                               *
+//**************************************************************************************************
+void dbgprint ( const char* format, ... )
+{
+  va_list     varArgs ;                                // For variable number of params
+  dbgline_t*  dbgline ;                                // Resulting line
+
+  if ( DEBUG )                                         // DEBUG on?
+  {
+    if ( dbgcount < DEBUG_LINES )                      // Yes, ring buffer full?
+    {
+      dbgline = &dbglines[( dbghead + dbgcount++ ) %   // No, use next free line
+                          DEBUG_LINES] ;
+    }
+    else
+    {
+      dbgline = &dbglines[dbghead] ;                   // Yes, overwrite oldest line
+      dbghead = ( dbghead + 1 ) % DEBUG_LINES ;
+    }
+    dbgline->clear() ;
+    dbgline->printf ( "%02d:%02d:%02d - ",             // Time of day
+                      hour(ltime),
+                      minute(ltime),
+                      second(ltime) ) ;
+    va_start ( varArgs, format ) ;                     // Prepare parameters
+    dbgline->vprintf ( format, varArgs ) ;             // Format the message
+    va_end ( varArgs ) ;                               // End of using parameters
+    hal_console ( dbgline->c_str() ) ;                 // Print info
+  }
+}
+
+
+//******************************************************************************************
+//                                  T I M E R 1 S E C                                      *
+//******************************************************************************************
+// Will be called every second.                                                            *
+//******************************************************************************************
+void timer1sec()
+{
+  ltime++ ;                               // Update local time
+}
+
+
+//******************************************************************************************
+//                                 S E T T I N G S                                         *
+//******************************************************************************************
+// The settings are kept twice.  loop() is the only writer: it fills the staging copy and  *
+// then makes it the active one, so a reader never sees a half updated schedule.           *
+// loop() itself uses active_settings() directly.  The handlers run in another context     *
+// and use get_settings(): if a publish happened while copying, the copy is made again.    *
+//******************************************************************************************
+static inline const set_t* active_settings()
+{
+  return &setcopy[__atomic_load_n ( &setactive, __ATOMIC_ACQUIRE )] ;
+}
+
+
+static uint32_t get_settings ( set_t* copy )                // Copy for other contexts
+{
+  uint32_t v ;                                              // Version before the copy
+
+  do
+  {
+    v = __atomic_load_n ( &setversion, __ATOMIC_ACQUIRE ) ;
+    *copy = *active_settings() ;
+    __atomic_thread_fence ( __ATOMIC_ACQUIRE ) ;
+  } while ( v != __atomic_load_n ( &setversion, __ATOMIC_RELAXED ) ) ;
+  return v ;                                                // Version of the copy
+}
+
+
+static void publish_settings ( const set_t& newset )        // Called by loop() only
+{
+  uint8_t staging = setactive ^ 1 ;
+
+  setcopy[staging] = newset ;                               // Fill staging copy
+  __atomic_store_n ( &setactive, staging, __ATOMIC_RELEASE ) ;  // Swap
+  __atomic_fetch_add ( &setversion, 1, __ATOMIC_RELEASE ) ;
+}
+
+
+//******************************************************************************************
+//                             G E T C O N T E N T T Y P E                                 *
+//******************************************************************************************
+// Returns the contenttype of a file to send, or "" for a file that may not be sent.  The  *
+// type is copied to ct, that has room for MIME_TYPELEN characters.                        *
+//******************************************************************************************
+const char* getContentType ( const char* filename, char* ct )
+{
+  return mime_type ( filename, ct ) ;                   // Checks the deny list first
+}
+
+
+//******************************************************************************************
+//                                  A D D _ A S S E T                                      *
+//******************************************************************************************
+// Called for every file in LittleFS at boot.  The ETag is the CRC-32 of the contents, so  *
+// it stays the same over reboots and changes with every upload.  A name with 8 hex digits *
+// before the extension, as made by host/tools/webassets.py, is never changed.             *
+// set_asset() and remove_asset() keep the table current when a file is uploaded.          *
+//******************************************************************************************
+static bool is_hashed ( const char* name )
+{
+  const char* ext = strrchr ( name, '.' ) ;                 // Extension
+  const char* p ;
+  int         n = 0 ;                                       // Number of hex digits
+
+  if ( ext == nullptr )
+  {
+    return false ;
+  }
+  if ( strcmp ( ext, ".gz" ) == 0 )                         // Skip ".gz"
+  {
+    while ( --ext > name && *ext != '.' ) ;
+  }
+  for ( p = ext ; ( --p > name ) && isxdigit ( *p ) ; n++ ) ;
+  return ( n == 8 ) && ( *p == '.' ) ;
+}
+
+
+static asset_t* find_asset ( const char* path )
+{
+  for ( uint8_t i = 0 ; i < nassets ; i++ )
+  {
+    if ( assets[i].name == path )
+    {
+      return &assets[i] ;
+    }
+  }
+  return nullptr ;
+}
+
+
+static void set_asset ( const char* path, uint32_t crc )
+{
+  asset_t* a = find_asset ( path ) ;                        // Entry of this file
+
+  if ( a == nullptr )
+  {
+    if ( nassets == MAX_ASSETS )
+    {
+      return ;                                              // Table full, sent without ETag
+    }
+    a = &assets[nassets] ;                                  // New entry
+    a->name = path ;
+    if ( a->name.isTruncated() )
+    {
+      return ;                                              // Too long
+    }
+    nassets++ ;
+  }
+  a->etag.clear() ;
+  a->etag.printf ( "\"%08x\"", (unsigned)crc ) ;
+  a->immutable = is_hashed ( path ) ;
+}
+
+
+static void remove_asset ( const char* path )
+{
+  asset_t* a = find_asset ( path ) ;
+
+  if ( a )
+  {
+    *a = assets[--nassets] ;                                // Last one fills the gap
+  }
+}
+
+
+void add_asset ( const char* name, size_t size )
+{
+  uint8_t         buf[256] ;                                // Part of the file
+  FixedString<32> path ( "/" ) ;                            // Path of the file
+  uint32_t        crc = 0 ;                                 // CRC of contents
+  size_t          pos = 0 ;                                 // Position in file
+  size_t          n ;                                       // Bytes read
+
+  if ( nassets == MAX_ASSETS )
+  {
+    return ;                                                // Table full, sent without ETag
+  }
+  path += name ;
+  if ( path.isTruncated() || mime_denied ( path.c_str() ) )
+  {
+    return ;                                                // Too long or secret
+  }
+  while ( ( pos < size ) &&
+          ( ( n = hal_fs_read ( path.c_str(), pos, buf, sizeof(buf) ) ) > 0 ) )
+  {
+    crc = crc32 ( buf, n, crc ) ;
+    pos += n ;
+  }
+  set_asset ( path.c_str(), crc ) ;
+}
+
+
+//******************************************************************************************
+//                                 E T A G _ M A T C H                                     *
+//******************************************************************************************
+// Check If-None-Match of a request against the ETag of the current version.  The header   *
+// is "*" or a list of tags separated by commas, a tag may have "W/" in front.  Only a     *
+// whole tag counts: one ETag may be a part of another one.                                *
+//******************************************************************************************
+static bool etag_match ( AsyncWebServerRequest* request, const char* etag )
+{
+  AsyncWebHeader* h = request->getHeader ( hdr_inm ) ;  // If-None-Match header
+  size_t          n = strlen ( etag ) ;                 // Length of etag
+  const char*     p ;                                   // Start of a tag
+  const char*     q ;                                   // End of a tag
+
+  if ( h == nullptr )
+  {
+    return false ;
+  }
+  p = h->value().c_str() ;
+  while ( *p )
+  {
+    while ( ( *p == ' ' ) || ( *p == ',' ) )            // Skip separators
+    {
+      p++ ;
+    }
+    if ( strncmp ( p, "W/", 2 ) == 0 )                  // Weak tag, same for a 304
+    {
+      p += 2 ;
+    }
+    q = p ;
+    if ( *p == '"' )                                    // Quoted tag, may have a comma
+    {
+      q = strchr ( p + 1, '"' ) ;
+      q = q ? q + 1 : p + strlen ( p ) ;
+    }
+    for ( ; *q && ( *q != ',' ) && ( *q != ' ' ) ; q++ ) ;  // Up to the separator
+    if ( ( ( q - p == 1 ) && ( *p == '*' ) ) ||         // Any version, or this one?
+         ( ( (size_t)( q - p ) == n ) && ( strncmp ( p, etag, n ) == 0 ) ) )
+    {
+      return true ;
+    }
+    for ( p = q ; *p && ( *p != ',' ) ; p++ ) ;         // To the next tag
+  }
+  return false ;
+}
+
+
+//******************************************************************************************
+//                                 S E N D _ A S S E T                                     *
+//******************************************************************************************
+// Send a static file.  A file compiled into the firmware (see embassets.h) is sent from   *
+// flash.  Otherwise the gzipped version from LittleFS is sent if the client accepts it,   *
+// or if there is no other one.  A client that has the file in its cache gets a 304        *
+// without a body.  Files with a hash in the name may be cached forever, the others must   *
+// be checked with the ETag every time.  Files written after boot are not in the table and *
+// are sent as is.                                                                         *
+//******************************************************************************************
+static void send_asset ( AsyncWebServerRequest* request, const char* path, const char* ct )
+{
+  FixedString<36>         gzpath ( path ) ;             // Path of gzipped version
+  const embasset_t*       e ;                           // Compiled-in file
+  const asset_t*          a = nullptr ;                 // The file in LittleFS to send
+  const asset_t*          plain = nullptr ;             // Not gzipped version
+  const char*             etag ;                        // ETag of the file to send
+  bool                    immutable ;                   // File never changes
+  AsyncWebHeader*         h ;                           // Request header
+  AsyncWebServerResponse* response ;                    // Response to client
+  bool                    gzip = false ;                // Send gzipped
+
+  if ( ( e = find_embasset ( path ) ) )                 // Compiled in?
+  {
+    etag = e->etag ;                                    // Yes, take that one
+    immutable = e->immutable ;
+    gzip = e->gzip ;
+  }
+  else
+  {
+    gzpath += ".gz" ;
+    plain = find_asset ( path ) ;
+    h = request->getHeader ( hdr_ae ) ;
+    if ( ( h && strstr ( h->value().c_str(), "gzip" ) ) || ! plain )
+    {
+      a = find_asset ( gzpath.c_str() ) ;               // Gzip accepted or needed
+      gzip = ( a != nullptr ) ;
+    }
+    if ( ! a )
+    {
+      a = plain ;
+    }
+    if ( ! a )                                          // Not known at boot
+    {
+      if ( hal_fs_exists ( path ) || hal_fs_exists ( gzpath.c_str() ) )
+      {
+        hal_fs_send ( request, path, ct ) ;             // Written later, send as is
+      }
+      else
+      {
+        request->send_P ( 404, "text/plain", "File not found" ) ;  // No flash access
+      }
+      return ;
+    }
+    etag = a->etag.c_str() ;
+    immutable = a->immutable ;
+  }
+  if ( etag_match ( request, etag ) )                   // Client has this version?
+  {
+    response = request->beginResponse ( 304 ) ;         // Yes, not modified
+    gzip = false ;
+  }
+  else if ( e )
+  {
+    AllocScope scope ( ALLOC_WEB ) ;                    // Content type String is made
+                                                        // by the webserver
+    response = request->beginResponse_P ( 200, e->contenttype, e->data, e->len ) ;
+  }
+  else if ( ( response = hal_fs_response ( request, a->name.c_str(), ct ) ) == nullptr )
+  {
+    request->send_P ( 404, "text/plain", "File not found" ) ;  // Removed after boot
+    return ;
+  }
+  if ( gzip )
+  {
+    response->addHeader ( hdr_ce, "gzip" ) ;
+  }
+  response->addHeader ( "ETag", etag ) ;
+  response->addHeader ( hdr_cc, immutable ? cc_immutable : cc_nocache ) ;
+  if ( gzip && plain )
+  {
+    response->addHeader ( "Vary", hdr_ae ) ;            // Depends on Accept-Encoding
+  }
+  request->send ( response ) ;
+}
+
+
+//**************************************************************************************************
+//                                        C B  _ L O G G I N G                                     *
+//**************************************************************************************************
+// Callback function for handle_logging, will be called for every chunk to send to client.         *
+// If no more data is availble, this function will return 0.                                       *
+//**************************************************************************************************
+size_t cb_logging ( uint8_t *buffer, size_t maxLen, size_t index )
+{
+  static int   i ;                                   // Index in dbglines
+  static int   nrl ;                                 // Mumber of lines in dbglines
+  static char  linebuf[DEBUG_BUFFER_SIZE + 1] ;      // Holds one debug line
+  static char* p_in ;                                // Pointer in linebuf
+  char*        p_out = (char*)buffer ;               // Fill pointer for output buffer
+  size_t       len = 0 ;                             // Number of bytes filled in buffer
+  
+  if ( index == 0 )                                 // First call for this page?
+  {
+    i = 0 ;                                         // Yes, set index
+    nrl = dbgcount ;                                // Number of lines in dbglines
+    p_in = linebuf ;                                // Set linebuf to empty
+    *p_in = '\0' ;
+  }
+  while ( maxLen-- > 0 )                            // Space for another character?
+  {
+    if ( *p_in == '\0' )                            // Input buffer end?
+    {
+      if ( i == nrl )                               // Yes, is there another line?
+      {
+        break ;                                     // No, end of text
+      }
+      strcpy ( linebuf,                             // Yes, fill linebuf with next line
+               dbglines[( dbghead + i++ ) % DEBUG_LINES].c_str() ) ;
+      strcat ( linebuf, "\n" ) ;                    // Add a break
+      p_in = linebuf ;                              // Pointer to start of line
+    }
+    *p_out++ = *p_in++ ;                            // Copy next character
+    len++ ;                                         // Increase result length
+  }
+  // We come here if output buffer is completely full or if end of dbglines is reached
+  return len ;                                      // Return filled length of buffer
+}
+
+
+//**************************************************************************************************
+//                                    H A N D L E _ L O G G I N G                                  *
+//**************************************************************************************************
+// Called from logging page to list the logging in dbglines.                                       *
+// It will handle the chunks for the client.  The buffer is filled by the callback routine.        *
+//**************************************************************************************************
+void handle_logging ( AsyncWebServerRequest *request )
+{
+  AllocScope              scope ( ALLOC_APP ) ;      // Count allocations as firmware
+  AsyncWebServerResponse *response ;
+
+  dbgprint ( "HTTP logging request" ) ;
+  response = request->beginChunkedResponse ( "text/plain", cb_logging ) ;
+  response->addHeader ( "Server", HOSTNAME ) ;
+  request->send ( response ) ;
+}
+
+
+//******************************************************************************************
+//                                   H A N D L E _ T E S T                                 *
+//******************************************************************************************
+// Handle Test button.                                                                     *
+//******************************************************************************************
+void handle_test ( AsyncWebServerRequest *request )
+{
+  AllocScope         scope ( ALLOC_APP ) ;              // Count allocations as firmware
+  static FixedString<100> reply ;                       // Reply to client
+
+  reply.clear() ;
+  reply.printf ( "Free memory is %d",                   // Testing
+                 (int)hal_free_heap() ) ;
+  dbgprint ( "%s", reply.c_str() ) ;
+  for ( uint8_t i = 0 ; i < ALLOC_NSUB ; i++ )          // Allocations since boot
+  {
+    reply.printf ( ", %s allocs %u", alloc_name ( i ),
+                   (unsigned)alloc_count ( i ) ) ;
+  }
+  request->send_P ( 200, "text/plain", reply.c_str() ) ;   // Copied by send
+}
+
+
+//******************************************************************************************
+//                              W R I T E _ S T A T E                                      *
+//******************************************************************************************
+// Produce the JSON document of /api/state for one chunk, see jsonwriter.h.  The document  *
+// comes from a snapshot, so every chunk sees the same values.  state_members() writes the *
+// members, /batch puts them in an object of its reply.                                    *
+//******************************************************************************************
+static void state_members ( JsonWriter& json, const state_t* st )
+{
+  char       tm[12] ;                                         // Time of day
+  int        lamp, h ;                                        // Loop control
+
+  snprintf ( tm, sizeof(tm), "%02d:%02d:%02d",
+             hour ( st->ltime ), minute ( st->ltime ), second ( st->ltime ) ) ;
+  json.add ( "version", VERSION ) ;
+  json.add ( "time", tm ) ;
+  json.add ( "epoch", (long)st->ltime ) ;
+  json.add ( "ntp", st->time_ok ) ;
+  json.add ( "rssi", st->rssi ) ;
+  json.add ( "heap", (long)st->heap ) ;
+  json.beginObject ( "intensity" ) ;                          // Current output
+  json.add ( "A", st->intensityA ) ;
+  json.add ( "B", st->intensityB ) ;
+  json.endObject() ;
+  json.beginObject ( "overrule" ) ;
+  json.add ( "active", st->overrule ) ;
+  json.add ( "A", st->ovA ) ;
+  json.add ( "B", st->ovB ) ;
+  json.add ( "remaining", (long)st->ovleft ) ;                // Seconds, 0 if no end
+  json.endObject() ;
+  json.add ( "preview", st->preview ) ;
+  json.add ( "settings_version", (long)st->setversion ) ;
+  json.add ( "state_version", (long)st->statever ) ;          // For /wait
+  json.beginObject ( "admission" ) ;                          // See admit.h
+  json.add ( "accepted", (long)st->admit.accepted ) ;
+  json.add ( "commands", (long)st->admit.commands ) ;
+  json.add ( "busy", (long)st->admit.busy ) ;
+  json.add ( "limited", (long)st->admit.limited ) ;
+  json.add ( "lowheap", (long)st->admit.lowheap ) ;
+  json.add ( "queuefull", (long)st->admit.queuefull ) ;
+  json.add ( "active", st->admit.active ) ;
+  json.add ( "peak", st->admit.peak ) ;
+  json.endObject() ;
+  json.beginObject ( "schedule" ) ;                           // Intensity per hour
+  for ( lamp = 0 ; lamp < 2 ; lamp++ )
+  {
+    json.beginArray ( lamp ? "B" : "A" ) ;
+    for ( h = 0 ; h < 24 ; h++ )
+    {
+      json.add ( (long)st->set.values[h * 2 + lamp] ) ;
+    }
+    json.endArray() ;
+  }
+  json.endObject() ;
+}
+
+
+static size_t write_state ( const state_t* st, uint8_t* buffer, size_t maxLen,
+                            size_t index )
+{
+  JsonWriter json ( buffer, maxLen, index ) ;                 // Writer for this chunk
+
+  json.beginObject() ;
+  state_members ( json, st ) ;
+  json.endObject() ;
+  return json.length() ;                                      // 0 at the end
+}
+
+
+//******************************************************************************************
+//                                 S E N D _ B U S Y                                       *
+//******************************************************************************************
+// Refuse a request with "503 Service Unavailable".  The text is in flash and the header   *
+// name is made once, so an overloaded server does not need extra heap to say so.          *
+//******************************************************************************************
+static const char busytext[] PROGMEM = "Busy, try again" ;
+
+static void send_busy ( AsyncWebServerRequest *request )
+{
+  AsyncWebServerResponse* response ;
+
+  response = request->beginResponse_P ( 503, "text/plain", (const uint8_t*)busytext,
+                                        sizeof(busytext) - 1 ) ;
+  response->addHeader ( hdr_retry, "1" ) ;              // Tokens are back in a second
+  request->send ( response ) ;
+}
+
+
+//******************************************************************************************
+//                             H A N D L E _ S T A T E                                     *
+//******************************************************************************************
+// Handle /api/state: settings and current state as JSON, for home automation.             *
+// The state is copied by take_state() to one of STATE_SLOTS snapshots, that is used until *
+// the response is complete.  The callback only captures the slot number, so it needs no   *
+// heap.  The home page uses the same snapshots.                                           *
+// A snapshot belongs to its request until the request disconnects (see request_gone()),   *
+// a response that is sent slowly never sees it change.  There is a snapshot for every     *
+// admitted request and every /wait; if all are in use anyway, STATE_NONE is returned and  *
+// the request gets a 503.  fill_state() copies the state again, for a /wait that took     *
+// its snapshot when it started waiting.                                                   *
+//******************************************************************************************
+static void fill_state ( state_t* st )
+{
+  uint32_t                elapsed ;                     // Time since start of overrule
+
+  st->setversion = get_settings ( &st->set ) ;
+  st->statever = __atomic_load_n ( &stateversion, __ATOMIC_ACQUIRE ) ;
+  st->intensityA = intensityA ;
+  st->intensityB = intensityB ;
+  st->overrule = overrule ;
+  st->preview = preview ;
+  st->ovA = ovA ;
+  st->ovB = ovB ;
+  st->ovleft = 0 ;
+  if ( overrule && ovtime )                             // Overrule with an end?
+  {
+    elapsed = hal_millis() - ovstart ;
+    st->ovleft = ( elapsed < ovtime ) ? ( ovtime - elapsed + 999 ) / 1000 : 1 ;
+  }
+  st->time_ok = time_ok ;
+  st->ltime = ltime ;
+  st->rssi = hal_wifi_rssi() ;
+  st->heap = hal_free_heap() ;
+  st->admit = admit_stats() ;
+}
+
+
+static uint8_t take_state ( AsyncWebServerRequest *request )
+{
+  uint8_t                 slot ;                        // Snapshot for this request
+
+  for ( slot = 0 ; states[slot].owner ; slot++ )        // Find a free snapshot
+  {
+    if ( slot == STATE_SLOTS - 1 )
+    {
+      return STATE_NONE ;                               // All in use
+    }
+  }
+  states[slot].owner = request ;
+  states[slot].page = false ;
+  states[slot].file = -1 ;
+  fill_state ( &states[slot] ) ;
+  return slot ;
+}
+
+
+void handle_state ( AsyncWebServerRequest *request )
+{
+  AllocScope              scope ( ALLOC_APP ) ;         // Count allocations as firmware
+  uint8_t                 slot ;                        // Snapshot for this request
+  AsyncWebServerResponse* response ;
+
+  dbgprint ( "HTTP state request" ) ;
+  slot = take_state ( request ) ;
+  if ( slot == STATE_NONE )
+  {
+    send_busy ( request ) ;
+    return ;
+  }
+  response = request->beginChunkedResponse ( ct_json,
+                [slot] ( uint8_t* buffer, size_t maxLen, size_t index ) -> size_t
+                {
+                  return write_state ( &states[slot], buffer, maxLen, index ) ;
+                } ) ;
+  request->send ( response ) ;
+}
+
+
+//******************************************************************************************
+//                                 F I L L _ I N D E X                                     *
+//******************************************************************************************
+// The fields of index.html, see template.h.  The values come from a snapshot.             *
+//******************************************************************************************
+enum index_field_t
+{
+  FLD_SLIDERS,                                                // Sliders with their values
+  FLD_SCHEDULE,                                               // Settings like getconf
+  FLD_INTENSITY_A, FLD_INTENSITY_B,                           // Current intensities
+  FLD_OVERRULE_A, FLD_OVERRULE_B                              // Overrule, -1 if not active
+} ;
+
+static const char* const index_fields[] =                     // In order of index_field_t
+{
+  "SLIDERS", "SCHEDULE", "INTENSITY_A", "INTENSITY_B", "OVERRULE_A", "OVERRULE_B"
+} ;
+
+static void fill_index ( uint8_t field, TemplateWriter& out, const void* ctx )
+{
+  const state_t* st = (const state_t*)ctx ;                   // Snapshot for this page
+  int            h ;                                          // Hour
+
+  switch ( field )
+  {
+    case FLD_SLIDERS :
+      for ( h = 0 ; h < 24 ; h++ )
+      {
+        if ( h )
+        {
+          out.puts ( "<br>\r\n      " ) ;                      // Same layout as typed in
+        }
+        out.put ( '0' + h / 10 ) ;
+        out.put ( '0' + h % 10 ) ;
+        out.puts ( ":00<input type=\"range\" class=\"slider\" id=\"w" ) ;
+        out.putn ( h ) ;
+        out.puts ( "\" value=\"" ) ;
+        out.putn ( st->set.values[h * 2] ) ;
+        out.puts ( "\" oninput=sfunc(this)>&nbsp;\r\n      "
+                   "<input type=\"range\" class=\"slider\" id=\"c" ) ;
+        out.putn ( h ) ;
+        out.puts ( "\" value=\"" ) ;
+        out.putn ( st->set.values[h * 2 + 1] ) ;
+        out.puts ( "\" oninput=sfunc(this)>" ) ;
+      }
+      break ;
+    case FLD_SCHEDULE :
+      for ( h = 0 ; h < 48 ; h++ )
+      {
+        if ( h )
+        {
+          out.put ( ',' ) ;
+        }
+        out.putn ( st->set.values[h] ) ;
+      }
+      break ;
+    case FLD_INTENSITY_A :
+      out.putn ( st->intensityA ) ;
+      break ;
+    case FLD_INTENSITY_B :
+      out.putn ( st->intensityB ) ;
+      break ;
+    case FLD_OVERRULE_A :
+      out.putn ( st->overrule ? st->ovA : -1 ) ;
+      break ;
+    case FLD_OVERRULE_B :
+      out.putn ( st->overrule ? st->ovB : -1 ) ;
+      break ;
+  }
+}
+
+
+//******************************************************************************************
+//                                 L O A D _ I N D E X                                     *
+//******************************************************************************************
+// Find the fields in index.html, compiled in or in LittleFS.  The page is read from flash *
+// for every request, only the positions of the fields are kept in RAM.  A gzipped page    *
+// cannot be filled, see handle_root().  From LittleFS the page is read through an open    *
+// file, src points to its number.                                                         *
+//******************************************************************************************
+static size_t read_progmem ( const void* src, size_t offset, uint8_t* buf, size_t len )
+{
+  memcpy_P ( buf, (const uint8_t*)src + offset, len ) ;
+  return len ;
+}
+
+
+static size_t read_fs ( const void* src, size_t offset, uint8_t* buf, size_t len )
+{
+  return hal_fs_pread ( *(const int*)src, offset, buf, len ) ;
+}
+
+
+void load_index()
+{
+  const embasset_t* e = find_embasset ( "/index.html" ) ;   // Compiled-in page
+  long              size ;                                  // Size of page in LittleFS
+  int               file ;                                  // Page in LittleFS
+
+  indexok = false ;
+  indexdata = nullptr ;
+  if ( e )
+  {
+    indexdata = e->data ;
+    indexok = ! e->gzip &&
+              tpl_compile ( &indextpl, read_progmem, e->data, e->len,
+                            index_fields, sizeof(index_fields) / sizeof(index_fields[0]) ) ;
+  }
+  else if ( ( ( size = hal_fs_size ( "/index.html" ) ) >= 0 ) &&
+            ( ( file = hal_fs_open ( "/index.html" ) ) >= 0 ) )
+  {
+    indexok = tpl_compile ( &indextpl, read_fs, &file, size,
+                            index_fields, sizeof(index_fields) / sizeof(index_fields[0]) ) ;
+    hal_fs_close ( file ) ;
+  }
+  if ( indexok )
+  {
+    dbgprint ( "Home page has %d fields", indextpl.nfields ) ;
+  }
+  else
+  {
+    dbgprint ( "Home page cannot be filled" ) ;
+  }
+}
+
+
+//******************************************************************************************
+//                                H A N D L E _ R O O T                                    *
+//******************************************************************************************
+// Handle homepage.  The fields of index.html are filled from a snapshot of the state, in  *
+// a chunked response.  So the browser gets the page with the settings in one request.     *
+// The page changes with the settings, so it has no ETag.                                  *
+// The template is read from index.html for every chunk, through a file that is open for   *
+// the request, so index.html cannot be replaced while a page is sent, see page_busy().    *
+// A page without its fields filled in does not work (the script would not even parse),    *
+// so if the template could not be loaded the reply is a 500 that says so.  If the page    *
+// cannot be read while it is sent, the connection is closed without the last chunk, so    *
+// the browser sees that the page is not complete.                                         *
+//******************************************************************************************
+void handle_root ( AsyncWebServerRequest *request )
+{
+  AllocScope              scope ( ALLOC_APP ) ;         // Count allocations as firmware
+  uint8_t                 slot ;                        // Snapshot for this request
+  AsyncWebServerResponse* response ;
+
+  if ( ! indexok )
+  {
+    request->send_P ( 500, "text/plain", "Home page template missing or not usable" ) ;
+    return ;
+  }
+  slot = take_state ( request ) ;
+  if ( slot == STATE_NONE )
+  {
+    send_busy ( request ) ;
+    return ;
+  }
+  if ( indexdata == nullptr )                           // Page in LittleFS?
+  {
+    states[slot].file = hal_fs_open ( "/index.html" ) ;
+    if ( states[slot].file < 0 )
+    {
+      states[slot].owner = nullptr ;                    // No, or no file free
+      send_busy ( request ) ;
+      return ;
+    }
+  }
+  states[slot].page = true ;                            // indextpl is in use
+  tpl_begin ( &states[slot].cur, indexdata ? indexdata : &states[slot].file ) ;
+  response = request->beginChunkedResponse ( "text/html",
+                [slot] ( uint8_t* buffer, size_t maxLen, size_t index ) -> size_t
+                {
+                  size_t n = tpl_render ( &indextpl, &states[slot].cur, fill_index,
+                                          &states[slot], buffer, maxLen, index ) ;
+                  if ( n == TPL_ERROR )                 // Page not readable?
+                  {
+                    states[slot].owner->client()->close() ;   // At the next poll, so
+                    return RESPONSE_TRY_AGAIN ;                 // no last chunk
+                  }
+                  return n ;
+                } ) ;
+  response->addHeader ( hdr_cc, cc_nocache ) ;
+  request->send ( response ) ;
+}
+
+
+//******************************************************************************************
+// True while a home page is being sent: its request still has its snapshot.               *
+//******************************************************************************************
+static bool page_busy()
+{
+  for ( int i = 0 ; i < STATE_SLOTS ; i++ )
+  {
+    if ( states[i].owner && states[i].page )
+    {
+      return true ;
+    }
+  }
+  return false ;
+}
+
+
+//******************************************************************************************
+//                               A D M I T H A N D L E R                                   *
+//******************************************************************************************
+// The first handler of the server, it sees every request when the head is complete, see   *
+// admit.h.  An admitted request is not taken (canHandle() returns false), so it goes on   *
+// to the routes; the end of the request is noticed by the disconnect.  A refused request  *
+// is taken: its body is ignored and handleRequest() sends the 503.                        *
+// The stream /events stays open, it would keep its place for a long time.  So it only     *
+// has to pass the check, it has its own limit.  A /wait counts until handle_wait() parks  *
+// it, see there.                                                                          *
+// The library keeps one disconnect handler per request, this one also releases what the   *
+// request still holds, see request_gone().                                                *
+//******************************************************************************************
+void request_gone ( AsyncWebServerRequest *request ) ;
+
+class AdmitHandler : public AsyncWebHandler
+{
+  public:
+    bool canHandle ( AsyncWebServerRequest *request ) override
+    {
+      if ( admit_request ( (uint32_t)request->client()->remoteIP(), hal_millis(),
+                           hal_free_heap() ) != ADMIT_OK )
+      {
+        return true ;                                   // Refused, answer it here
+      }
+      if ( request->url() == "/events" )                // A stream?
+      {
+        admit_release() ;                               // Yes, does not count as active
+      }
+      else
+      {
+        request->onDisconnect ( [request] ()
+                                {
+                                  admit_release() ;
+                                  request_gone ( request ) ;
+                                } ) ;
+      }
+      return false ;
+    }
+
+    void handleRequest ( AsyncWebServerRequest *request ) override
+    {
+      send_busy ( request ) ;
+    }
+} ;
+
+
+//******************************************************************************************
+//                               Q U E U E _ C M D                                         *
+//******************************************************************************************
+// Pass a command from a handler to loop().  The handlers run in the context of the TCP    *
+// stack, so they only check their input; the state is changed by loop() and the slow      *
+// flash writes are done there as well.                                                    *
+// If the queue is full a 503 is sent and false is returned.                               *
+//******************************************************************************************
+static bool queue_cmd ( AsyncWebServerRequest *request, const cmd_t& cmd )
+{
+  bool ok = cmdqueue.push ( cmd ) ;                     // Room in the queue?
+
+  admit_command ( ok ) ;
+  if ( ! ok )
+  {
+    dbgprint ( "Command queue full" ) ;
+    send_busy ( request ) ;
+  }
+  return ok ;
+}
+
+
+//******************************************************************************************
+//                                H A N D L E _ R E S E T                                  *
+//******************************************************************************************
+// Handle reset request.  The reset is done by loop(), after the reply has been sent.      *
+//******************************************************************************************
+void handle_reset ( AsyncWebServerRequest *request )
+{
+  AllocScope         scope ( ALLOC_APP ) ;              // Count allocations as firmware
+  cmd_t              cmd ;                              // Command for loop()
+
+  dbgprint ( "HTTP reset request" ) ;
+  cmd.code = CMD_RESET ;
+  if ( queue_cmd ( request, cmd ) )
+  {
+    request->send_P ( 200, "text/plain", "Reset" ) ;
+  }
+}
+
+
+//******************************************************************************************
+//                              B U I L D _ C O N F                                        *
+//******************************************************************************************
+// Format the reply for getconf: a string with 48 settings.  The ETag is the CRC of the    *
+// settings, so it stays the same over a reboot as long as the settings do.                *
+// Only done after a change of the settings, that is a new version.                        *
+//******************************************************************************************
+static void build_conf()
+{
+  set_t set ;                                           // Snapshot of the settings
+  int   i ;                                             // Loop control
+
+  if ( __atomic_load_n ( &setversion, __ATOMIC_ACQUIRE ) == confversion )  // Up to date?
+  {
+    return ;                                            // Yes, nothing to do
+  }
+  confversion = get_settings ( &set ) ;
+  confbody.clear() ;
+  for ( i = 0 ; i < 48 ; i++ )                          // Settings for 24 hours, 2 lamps
+  {
+    confbody.concat ( set.values[i] ) ;                 // Add setting
+    confbody += ',' ;                                   // Separator
+  }
+  confetag.clear() ;
+  confetag.printf ( "\"%08x\"",                        // Quoted, fits in String SSO
+                    (unsigned)crc32 ( set.values, sizeof(set.values) ) ) ;
+}
+
+
+//******************************************************************************************
+//                             H A N D L E _ G E T C O N F                                 *
+//******************************************************************************************
+// Handle get configuration request.                                                       *
+// Return a string with 48 settings.  The reply is cached until the settings change.  A    *
+// client that sends the ETag of its copy in If-None-Match gets a 304 without a body.      *
+// The reply fits in the first TCP segment, which send() fills before it returns, so a     *
+// static buffer is safe.                                                                  *
+//******************************************************************************************
+void handle_getconf ( AsyncWebServerRequest *request )
+{
+  AllocScope                 scope ( ALLOC_APP ) ;      // Count allocations as firmware
+  AsyncWebServerResponse*    response ;                 // Response to client
+
+  dbgprint ( "HTTP getconf request" ) ;
+  build_conf() ;                                        // Format again if changed
+  if ( etag_match ( request, confetag.c_str() ) )       // Client has this version?
+  {
+    response = request->beginResponse ( 304 ) ;         // Yes, not modified
+  }
+  else
+  {
+    response = request->beginResponse_P ( 200, "text/plain", // Send without a String copy
+                                          (const uint8_t*)confbody.c_str(),
+                                          confbody.length() ) ;
+  }
+  response->addHeader ( "ETag", confetag.c_str() ) ;   // No Last-Modified, so browsers
+                                                        // always check with the ETag
+  request->send ( response ) ;
+}
+
+
+//******************************************************************************************
+//                          S E N D _ P A R S E _ E R R O R                                *
+//******************************************************************************************
+// Reply to a parameter that could not be parsed, with the position of the error.          *
+//******************************************************************************************
+static void send_parse_error ( AsyncWebServerRequest *request, const parse_err_t& err )
+{
+  static FixedString<80> reply ;                        // Error reply, copied by send
+
+  reply.clear() ;
+  reply.printf ( "Error at position %d: %s", err.pos, err.msg ) ;
+  dbgprint ( "%s", reply.c_str() ) ;
+  request->send_P ( 400, "text/plain", reply.c_str() ) ;
+}
+
+
+//******************************************************************************************
+//                             G E T _ I N T E N S I T I E S                               *
+//******************************************************************************************
+// Get n intensities from the parameter "setting", separated by commas.                    *
+// On error a reply with the position of the error is sent and false is returned.          *
+//******************************************************************************************
+static bool get_intensities ( AsyncWebServerRequest *request, uint8_t* values, int n )
+{
+  AsyncWebParameter*     p ;                            // Points to parameter structure
+  parse_err_t            err ;                          // Parse result
+
+  p = request->getParam ( "setting" ) ;                 // Get pointer to parameter structure
+  if ( p == nullptr )
+  {
+    request->send_P ( 400, "text/plain", "Parameter setting missing" ) ;
+    return false ;
+  }
+  if ( ! parse_intlist ( p->value().c_str(), p->value().length(),
+                         values, n, 0, MAXINTENSITY, &err ) )
+  {
+    send_parse_error ( request, err ) ;
+    return false ;
+  }
+  return true ;
+}
+
+
+//******************************************************************************************
+//                             S A V E _ S E T T I N G S                                   *
+//******************************************************************************************
+// Accept new settings.  They are written to the journal by flush_settings() SAVE_DELAY    *
+// msec after the first change, so a burst of changes costs one record in flash.           *
+// Returns the number of changed settings.  Called by loop() only.                         *
+//******************************************************************************************
+static int save_settings ( const set_t& newset )
+{
+  const set_t* cur = active_settings() ;                // Current settings
+  int          n = 0 ;                                  // Number of changes
+  int          i ;                                      // Loop control
+
+  for ( i = 0 ; i < 48 ; i++ )
+  {
+    if ( newset.values[i] != cur->values[i] )           // Changed?
+    {
+      n++ ;                                             // Yes, count
+    }
+  }
+  if ( n )                                              // Anything to save?
+  {
+    publish_settings ( newset ) ;                       // Yes, accept new settings
+    if ( ! savedue )                                    // First unsaved change?
+    {
+      savedue = true ;                                  // Yes, save later
+      savetime = hal_millis() ;
+    }
+  }
+  return n ;
+}
+
+
+//******************************************************************************************
+//                             F L U S H _ S E T T I N G S                                 *
+//******************************************************************************************
+// Write the active settings to the journal if there are unsaved changes.  The journal     *
+// skips the record if the settings are the same as the last saved ones.                   *
+//******************************************************************************************
+static void flush_settings()
+{
+  setrec_t rec ;                                        // Record for the journal
+
+  if ( savedue )
+  {
+    rec.magic = SETMAGIC ;
+    rec.layout = SETLAYOUT ;
+    rec.len = sizeof(rec.set) ;
+    rec.set = *active_settings() ;
+    rec.crc = crc32 ( &rec.set, sizeof(rec.set) ) ;
+    if ( journal_save ( &rec, sizeof(rec) ) )
+    {
+      savedue = false ;
+    }
+    else
+    {
+      savetime = hal_millis() ;                         // Failed, try again later
+      dbgprint ( "Saving settings failed" ) ;
+    }
+  }
+}
+
+
+//******************************************************************************************
+//                             H A N D L E _ C O N F _ B O D Y                             *
+//******************************************************************************************
+// POST body of setconf and patchconf, in the same format as the parameters.  The body is  *
+// parsed while it arrives (see body_feed()), so only one part is in RAM at a time.  One   *
+// body is parsed at a time: a new body takes over the parser, the request of the earlier  *
+// one then gets the reply for a missing parameter.                                        *
+//******************************************************************************************
+static bodyparse_t            bodyparse ;               // Parse of the body
+static set_t                  bodyset ;                 // Settings from the body
+static AsyncWebServerRequest* bodyowner ;               // Request that owns bodyparse
+
+static void conf_body ( AsyncWebServerRequest *request, uint8_t* data, size_t len,
+                        size_t index, bool patch )
+{
+  if ( index == 0 )                                     // First part?
+  {
+    bodyowner = request ;                               // Yes, claim the parser
+    bodyset = reqset ;                                  // Base for a patch
+    if ( patch )
+    {
+      body_patch ( &bodyparse, bodyset.values, MAXINTENSITY ) ;
+    }
+    else
+    {
+      body_intlist ( &bodyparse, bodyset.values, 48, 0, MAXINTENSITY ) ;
+    }
+  }
+  if ( bodyowner == request )
+  {
+    body_feed ( &bodyparse, (const char*)data, len ) ;  // Stops at the first error
+  }
+}
+
+
+void handle_setconf_body ( AsyncWebServerRequest *request, uint8_t* data,
+                           size_t len, size_t index, size_t total )
+{
+  conf_body ( request, data, len, index, false ) ;
+}
+
+
+void handle_patchconf_body ( AsyncWebServerRequest *request, uint8_t* data,
+                             size_t len, size_t index, size_t total )
+{
+  conf_body ( request, data, len, index, true ) ;
+}
+
+
+//******************************************************************************************
+// The body of request is complete.  Get the settings from it and release the parser.  On  *
+// error a reply with the position of the error is sent and false is returned.             *
+//******************************************************************************************
+static bool end_body ( AsyncWebServerRequest *request, set_t* set )
+{
+  bodyowner = nullptr ;
+  if ( ! body_end ( &bodyparse ) )
+  {
+    send_parse_error ( request, bodyparse.err ) ;
+    return false ;
+  }
+  *set = bodyset ;
+  return true ;
+}
+
+
+//******************************************************************************************
+//                             H A N D L E _ S E T C O N F                                 *
+//******************************************************************************************
+// Handle set configuration request.                                                       *
+// parameter is a string with 48 settings, separated by a comma.  The same string may be   *
+// the POST body.                                                                          *
+//******************************************************************************************
+void handle_setconf ( AsyncWebServerRequest *request )
+{
+  AllocScope         scope ( ALLOC_APP ) ;              // Count allocations as firmware
+  cmd_t              cmd ;                              // Command for loop()
+
+  dbgprint ( "HTTP setconf request" ) ;
+  if ( bodyowner == request )                           // Settings in the body?
+  {
+    if ( ! end_body ( request, &cmd.set ) )
+    {
+      return ;                                          // Error, already replied
+    }
+  }
+  else if ( ! get_intensities ( request, cmd.set.values, 48 ) ) // 24 hours, 2 lamps
+  {
+    return ;                                            // Error, already replied
+  }
+  cmd.code = CMD_SETCONF ;                              // Accept and save in EEPROM
+  if ( queue_cmd ( request, cmd ) )
+  {
+    reqset = cmd.set ;                                  // Base for next patch
+    request->send_P ( 200, "text/plain",                // Reply
+                           "SET command accepted" ) ;
+  }
+}
+
+
+//******************************************************************************************
+//                           H A N D L E _ P A T C H C O N F                               *
+//******************************************************************************************
+// Handle a partial change of the configuration.                                           *
+// Parameter "patch" or the POST body holds the changes, like "A8-17=80,B8=40" (see        *
+// parse_patch()).  Nothing is changed if there is an error in the parameter.              *
+// The patch is applied to the last requested settings, so it does not undo a change that  *
+// is still in the queue.  For a body these are the settings when the body started.        *
+//******************************************************************************************
+void handle_patchconf ( AsyncWebServerRequest *request )
+{
+  AllocScope             scope ( ALLOC_APP ) ;          // Count allocations as firmware
+  static FixedString<48> reply ;                        // Reply, copied by send
+  AsyncWebParameter*     p ;                            // Points to parameter structure
+  parse_err_t            err ;                          // Parse result
+  cmd_t                  cmd ;                          // Command for loop()
+  int                    n = 0 ;                        // Number of changed settings
+  int                    i ;                            // Loop control
+
+  dbgprint ( "HTTP patchconf request" ) ;
+  if ( bodyowner == request )                           // Patch in the body?
+  {
+    if ( ! end_body ( request, &cmd.set ) )
+    {
+      return ;                                          // Error, already replied
+    }
+  }
+  else
+  {
+    p = request->getParam ( "patch" ) ;                 // Get pointer to parameter structure
+    if ( p == nullptr )
+    {
+      request->send_P ( 400, "text/plain", "Parameter patch missing" ) ;
+      return ;
+    }
+    cmd.set = reqset ;                                  // Settings to patch
+    if ( ! parse_patch ( p->value().c_str(), p->value().length(),
+                         cmd.set.values, MAXINTENSITY, &err ) )
+    {
+      send_parse_error ( request, err ) ;
+      return ;
+    }
+  }
+  for ( i = 0 ; i < 48 ; i++ )                          // Count the changes
+  {
+    n += ( cmd.set.values[i] != reqset.values[i] ) ;
+  }
+  cmd.code = CMD_SETCONF ;                              // Accept and save changes
+  if ( ! queue_cmd ( request, cmd ) )
+  {
+    return ;
+  }
+  reqset = cmd.set ;
+  reply.clear() ;
+  reply.printf ( "PATCH command accepted, %d changed", n ) ;
+  request->send_P ( 200, "text/plain", reply.c_str() ) ;
+}
+
+
+//******************************************************************************************
+//                         H A N D L E _ G E T C O N F B I N                               *
+//******************************************************************************************
+// Handle GET /conf.bin: the settings as a confbin_t, for automation clients.              *
+// The ETag is the same as for getconf.                                                    *
+//******************************************************************************************
+void handle_getconfbin ( AsyncWebServerRequest *request )
+{
+  AllocScope                 scope ( ALLOC_APP ) ;      // Count allocations as firmware
+  static confbin_t           reply ;                    // Reply, copied by send
+  AsyncWebServerResponse*    response ;                 // Response to client
+
+  dbgprint ( "HTTP getconfbin request" ) ;
+  reply.magic = CONFMAGIC ;
+  reply.version = CONFVERSION ;
+  reply.nvalues = sizeof(reply.set.values) ;
+  reply.maxval = MAXINTENSITY ;
+  get_settings ( &reply.set ) ;
+  reply.crc = crc32 ( &reply, offsetof ( confbin_t, crc ) ) ;
+  build_conf() ;                                        // ETag up to date
+  response = request->beginResponse_P ( 200, ct_binary,
+                                        (const uint8_t*)&reply, sizeof(reply) ) ;
+  response->addHeader ( "ETag", confetag.c_str() ) ;
+  request->send ( response ) ;
+}
+
+
+//******************************************************************************************
+//                       H A N D L E _ P U T C O N F B I N                                 *
+//******************************************************************************************
+// Handle POST /conf.bin with a confbin_t as body.  The body arrives in parts, in          *
+// handle_confbin_body(), and is collected in a static buffer.  A new upload takes over    *
+// the buffer, an upload that was taken over is rejected when it completes.                *
+//******************************************************************************************
+static confbin_t              confin ;                  // Received configuration
+static size_t                 confinlen ;               // Number of bytes received
+static AsyncWebServerRequest* confowner ;               // Request that fills confin
+
+void handle_confbin_body ( AsyncWebServerRequest *request, uint8_t* data,
+                           size_t len, size_t index, size_t total )
+{
+  if ( index == 0 )                                     // First part?
+  {
+    confowner = request ;                               // Yes, claim the buffer
+    confinlen = 0 ;
+  }
+  if ( ( confowner != request ) || ( total != sizeof(confin) ) ||
+       ( index != confinlen ) || ( len > sizeof(confin) - index ) )
+  {
+    return ;                                            // Not ours or wrong size
+  }
+  memcpy ( (uint8_t*)&confin + index, data, len ) ;
+  confinlen += len ;
+}
+
+
+void handle_putconfbin ( AsyncWebServerRequest *request )
+{
+  AllocScope         scope ( ALLOC_APP ) ;              // Count allocations as firmware
+  cmd_t              cmd ;                              // Command for loop()
+  const char*        errmsg = nullptr ;                 // Reason of rejection
+  int                i ;                                // Loop control
+
+  dbgprint ( "HTTP putconfbin request" ) ;
+  if ( ( confowner != request ) || ( confinlen != sizeof(confin) ) )
+  {
+    errmsg = "Body must be one confbin_t of 60 bytes" ;
+  }
+  else if ( ( confin.magic != CONFMAGIC ) || ( confin.version != CONFVERSION ) ||
+            ( confin.nvalues != sizeof(confin.set.values) ) )
+  {
+    errmsg = "Wrong magic, version or number of values" ;
+  }
+  else if ( confin.crc != crc32 ( &confin, offsetof ( confbin_t, crc ) ) )
+  {
+    errmsg = "CRC error" ;
+  }
+  for ( i = 0 ; ( errmsg == nullptr ) && ( i < 48 ) ; i++ )
+  {
+    if ( confin.set.values[i] > MAXINTENSITY )
+    {
+      errmsg = "Value out of range" ;
+    }
+  }
+  if ( confowner == request )
+  {
+    confowner = nullptr ;                               // Release the buffer
+  }
+  if ( errmsg )
+  {
+    dbgprint ( "%s", errmsg ) ;
+    request->send_P ( 400, "text/plain", errmsg ) ;
+    return ;
+  }
+  cmd.code = CMD_SETCONF ;                              // Accept and save in EEPROM
+  cmd.set = confin.set ;
+  if ( queue_cmd ( request, cmd ) )
+  {
+    reqset = cmd.set ;                                  // Base for next patch
+    request->send_P ( 200, "text/plain",                // Reply
+                           "SET command accepted" ) ;
+  }
+}
+
+
+//******************************************************************************************
+//                           H A N D L E _ O V E R R U L E                                 *
+//******************************************************************************************
+// Handle overlue normal intensity settings.                                               *
+// Parameter is a string with 2 settings, separated by a comma                             *
+//******************************************************************************************
+void handle_overrule ( AsyncWebServerRequest *request )
+{
+  AllocScope         scope ( ALLOC_APP ) ;              // Count allocations as firmware
+  uint8_t            ov[2] ;                            // Intensities lamp A and B
+  cmd_t              cmd ;                              // Command for loop()
+
+  dbgprint ( "HTTP overrule request" ) ;
+  if ( ! get_intensities ( request, ov, 2 ) )
+  {
+    return ;                                            // Error, already replied
+  }
+  cmd.code = CMD_OVERRULE ;
+  cmd.a = ov[0] ;                                       // Overrule lamp A value
+  cmd.b = ov[1] ;                                       // Overrule lamp B value
+  if ( queue_cmd ( request, cmd ) )
+  {
+    request->send_P ( 200, "text/plain",                // Reply
+                           "Overrule command accepted" ) ;
+  }
+}
+
+
+//******************************************************************************************
+//                           H A N D L E _ P R E V I E W                                   *
+//******************************************************************************************
+// Handle live preview of intensities while a slider is moved.                             *
+// Parameter is a string with 2 settings, separated by a comma.  loop() runs all queued    *
+// commands before it sets the outputs, so only the latest values are shown and a burst    *
+// of requests gives one update of the outputs.  Nothing is saved.  The preview ends with  *
+// the next SET or overrule, or after PREVIEW_TIME without a new preview.                  *
+// No debug line for every request, a slider sends many of them.                           *
+//******************************************************************************************
+void handle_preview ( AsyncWebServerRequest *request )
+{
+  AllocScope         scope ( ALLOC_APP ) ;              // Count allocations as firmware
+  uint8_t            pv[2] ;                            // Intensities lamp A and B
+  cmd_t              cmd ;                              // Command for loop()
+
+  if ( ! get_intensities ( request, pv, 2 ) )
+  {
+    return ;                                            // Error, already replied
+  }
+  cmd.code = CMD_PREVIEW ;
+  cmd.a = pv[0] ;
+  cmd.b = pv[1] ;
+  if ( queue_cmd ( request, cmd ) )
+  {
+    request->send_P ( 200, "text/plain", "Preview" ) ;
+  }
+}
+
+
+//******************************************************************************************
+//                              H A N D L E _ B A T C H                                    *
+//******************************************************************************************
+// Handle /batch: several operations in one request, see parse_batch().  Parameter "ops"   *
+// in the URL or a form holds them, like "O:80,60,30;P:A8-17=80,B8=40;G".  The operations  *
+// are checked first and passed to loop() as one command, so they are applied together or  *
+// not at all.  Like /patchconf a schedule change ends an overrule, unless the batch sets  *
+// one.  The reply is a JSON object with the number of operations and changed settings,    *
+// and with G also the state as it is after the batch.  Only G needs a snapshot; it is     *
+// taken before the command is queued, so a 503 for a lack of snapshots never follows a    *
+// batch that was applied.                                                                 *
+//******************************************************************************************
+static size_t write_batch ( uint8_t slot, uint8_t ops, uint8_t changed, bool state,
+                            uint8_t* buffer, size_t maxLen, size_t index )
+{
+  JsonWriter json ( buffer, maxLen, index ) ;                 // Writer for this chunk
+
+  json.beginObject() ;
+  json.add ( "ops", ops ) ;
+  json.add ( "changed", changed ) ;
+  if ( state )
+  {
+    json.beginObject ( "state" ) ;
+    state_members ( json, &states[slot] ) ;
+    json.endObject() ;
+  }
+  json.endObject() ;
+  return json.length() ;                                      // 0 at the end
+}
+
+
+void handle_batch ( AsyncWebServerRequest *request )
+{
+  AllocScope              scope ( ALLOC_APP ) ;         // Count allocations as firmware
+  AsyncWebParameter*      p ;                           // Points to parameter structure
+  AsyncWebServerResponse* response ;
+  parse_err_t             err ;                         // Parse result
+  batch_t                 batch ;                       // Parsed operations
+  cmd_t                   cmd ;                         // Command for loop()
+  state_t*                st ;                          // State after the batch
+  uint8_t                 slot ;                        // Snapshot for this request
+  uint8_t                 ops ;                         // Number of operations
+  uint8_t                 changed = 0 ;                 // Number of changed settings
+  bool                    state ;                       // State requested
+  int                     i ;                           // Loop control
+
+  dbgprint ( "HTTP batch request" ) ;
+  p = request->getParam ( "ops" ) ;                     // In the URL
+  if ( p == nullptr )
+  {
+    p = request->getParam ( "ops", true ) ;             // Or in a form
+  }
+  if ( p == nullptr )
+  {
+    request->send_P ( 400, "text/plain", "Parameter ops missing" ) ;
+    return ;
+  }
+  cmd.set = reqset ;                                    // Settings to patch
+  if ( ! parse_batch ( p->value().c_str(), p->value().length(),
+                       cmd.set.values, MAXINTENSITY, &batch, &err ) )
+  {
+    send_parse_error ( request, err ) ;
+    return ;
+  }
+  if ( ( batch.flags & BATCH_SET ) && ! ( batch.flags & BATCH_OVERRULE ) )
+  {
+    batch.flags |= BATCH_CLEAR ;                        // Like patchconf
+  }
+  for ( i = 0 ; i < 48 ; i++ )                          // Count the changes
+  {
+    changed += ( cmd.set.values[i] != reqset.values[i] ) ;
+  }
+  cmd.code = CMD_BATCH ;
+  cmd.flags = batch.flags ;
+  cmd.a = batch.ovA ;
+  cmd.b = batch.ovB ;
+  cmd.ovtime = batch.ovmin * 60000UL ;
+  ops = batch.ops ;
+  state = ( batch.flags & BATCH_STATE ) != 0 ;
+  slot = STATE_NONE ;
+  if ( state && ( ( slot = take_state ( request ) ) == STATE_NONE ) )
+  {
+    send_busy ( request ) ;                             // No snapshot, nothing applied
+    return ;
+  }
+  if ( ! queue_cmd ( request, cmd ) )
+  {
+    return ;                                            // Nothing applied
+  }
+  if ( batch.flags & BATCH_SET )
+  {
+    reqset = cmd.set ;                                  // Base for next patch
+  }
+  if ( state )                                          // Show the result of the batch
+  {
+    st = &states[slot] ;
+    if ( batch.flags & BATCH_SET )
+    {
+      st->set = cmd.set ;
+    }
+    if ( batch.flags & ( BATCH_SET | BATCH_OVERRULE | BATCH_CLEAR ) )
+    {
+      st->preview = false ;                             // A change ends the preview
+      st->overrule = ( batch.flags & BATCH_OVERRULE ) != 0 ;
+    }
+    if ( batch.flags & BATCH_OVERRULE )
+    {
+      st->ovA = cmd.a ;
+      st->ovB = cmd.b ;
+      st->ovleft = batch.ovmin * 60 ;
+    }
+    if ( ! st->preview )                                // Outputs as loop() sets them
+    {
+      st->intensityA = st->overrule ? st->ovA : st->set.values[hour ( st->ltime ) * 2] ;
+      st->intensityB = st->overrule ? st->ovB : st->set.values[hour ( st->ltime ) * 2 + 1] ;
+    }
+  }
+  response = request->beginChunkedResponse ( ct_json,
+                [slot, ops, changed, state] ( uint8_t* buffer, size_t maxLen,
+                                              size_t index ) -> size_t
+                {
+                  return write_batch ( slot, ops, changed, state,
+                                       buffer, maxLen, index ) ;
+                } ) ;
+  request->send ( response ) ;
+}
+
+
+//******************************************************************************************
+//                              H A N D L E _ E V E N T S                                  *
+//******************************************************************************************
+// Handle /events: a stream of Server-Sent Events with the state, see push.h.  The         *
+// response never ends by itself; the filler only keeps the position of this client in the *
+// shared frames, so it needs no heap.                                                     *
+//******************************************************************************************
+void handle_events ( AsyncWebServerRequest *request )
+{
+  AllocScope              scope ( ALLOC_APP ) ;         // Count allocations as firmware
+  AsyncWebServerResponse* response ;
+
+  dbgprint ( "HTTP events request, %d clients", push_clients() ) ;
+  if ( ! push_join() )                                  // Room for another client?
+  {
+    send_busy ( request ) ;                             // No
+    return ;
+  }
+  request->onDisconnect ( [] () { push_leave() ; } ) ;
+  response = request->beginChunkedResponse ( ct_events,
+                [pos = pushpos_t { 0, 0 }] ( uint8_t* buffer, size_t maxLen,
+                                             size_t index ) mutable -> size_t
+                {
+                  return push_fill ( &pos, buffer, maxLen, index ) ;
+                } ) ;
+  response->addHeader ( hdr_cc, cc_nocache ) ;
+  request->send ( response ) ;
+}
+
+
+//******************************************************************************************
+//                               H A N D L E _ W A I T                                     *
+//******************************************************************************************
+// Handle /wait?version=N[&timeout=sec]: a long poll for clients that cannot use /events.  *
+// If state_version (see /api/state) is not N, the state is sent at once.  Else the reply  *
+// is a chunked response whose filler returns RESPONSE_TRY_AGAIN until the version changes *
+// or the time is up; then it refreshes its snapshot and sends the state like /api/state.  *
+// Nothing waits in a handler, loop() and the TCP stack go on.  After the time the         *
+// unchanged state is sent, the client simply asks again.                                  *
+// The snapshot is taken when the request arrives, so a reply never finds all of them in   *
+// use.  A waiting request is parked in waiters[]: it no longer counts as an active        *
+// request (admit.h), only for WAIT_CLIENTS.  A reply at once counts as active until it    *
+// is gone, like any other request.                                                        *
+// loop() only changes stateversion, the filler sees it when the webserver asks again.     *
+// That happens when the TCP stack polls, about every 500 msec, so a change reaches the    *
+// client within that time.  A response is never driven from loop(), it runs in the        *
+// context of the TCP stack.                                                               *
+//******************************************************************************************
+static AsyncWebServerRequest* waiters[WAIT_CLIENTS] ;   // Long polls in progress, nullptr
+                                                        // if free
+
+static bool get_number_param ( AsyncWebServerRequest *request, const char* name, long hi,
+                               long* value )
+{
+  AsyncWebParameter* p = request->getParam ( name ) ;   // Points to parameter structure
+  parse_err_t        err ;                              // Parse result
+
+  if ( p == nullptr )
+  {
+    return true ;                                       // Not given, value unchanged
+  }
+  if ( ! parse_number ( p->value().c_str(), p->value().length(), hi, value, &err ) )
+  {
+    send_parse_error ( request, err ) ;
+    return false ;
+  }
+  return true ;
+}
+
+
+static void unpark ( AsyncWebServerRequest *request )
+{
+  for ( int i = 0 ; i < WAIT_CLIENTS ; i++ )
+  {
+    if ( waiters[i] == request )
+    {
+      waiters[i] = nullptr ;
+    }
+  }
+}
+
+
+void handle_wait ( AsyncWebServerRequest *request )
+{
+  AllocScope              scope ( ALLOC_APP ) ;         // Count allocations as firmware
+  AsyncWebServerResponse* response ;
+  long                    version = -1 ;                // Version known by the client
+  long                    timeout = WAIT_TIME ;         // Seconds to wait
+  int                     park = -1 ;                   // Entry in waiters, -1 if not
+  struct                                                // State of the filler
+  {
+    uint32_t              version ;                     // Wait while it is this one
+    uint32_t              start ;                       // Time of request
+    uint32_t              time ;                        // Time to wait, msec
+    uint8_t               slot ;                        // Snapshot of this request
+    bool                  waiting ;                     // Still parked
+  } w ;
+
+  dbgprint ( "HTTP wait request" ) ;
+  if ( ! get_number_param ( request, "version", 200000000, &version ) ||
+       ! get_number_param ( request, "timeout", WAIT_MAXTIME, &timeout ) )
+  {
+    return ;                                            // Error, already replied
+  }
+  if ( version < 0 )
+  {
+    request->send_P ( 400, "text/plain", "Parameter version missing" ) ;
+    return ;
+  }
+  w.waiting = ( (uint32_t)version == __atomic_load_n ( &stateversion, __ATOMIC_ACQUIRE ) ) ;
+  if ( w.waiting )                                      // Has to wait?
+  {
+    for ( park = 0 ; waiters[park] ; park++ )           // Find a free entry
+    {
+      if ( park == WAIT_CLIENTS - 1 )
+      {
+        send_busy ( request ) ;                         // No room
+        return ;
+      }
+    }
+  }
+  w.slot = take_state ( request ) ;
+  if ( w.slot == STATE_NONE )
+  {
+    send_busy ( request ) ;
+    return ;
+  }
+  request->onDisconnect ( [request, park] ()           // Replaces the one of AdmitHandler
+                          {
+                            unpark ( request ) ;
+                            if ( park < 0 )             // Not parked, so still active
+                            {
+                              admit_release() ;
+                            }
+                            request_gone ( request ) ;  // Release the snapshot
+                          } ) ;
+  w.version = version ;
+  w.start = hal_millis() ;
+  w.time = timeout * 1000 ;
+  response = request->beginChunkedResponse ( ct_json,
+                [w, request] ( uint8_t* buffer, size_t maxLen,
+                               size_t index ) mutable -> size_t
+                {
+                  if ( w.waiting )                      // Still waiting?
+                  {
+                    if ( ( __atomic_load_n ( &stateversion, __ATOMIC_ACQUIRE ) ==
+                           w.version ) && ( hal_millis() - w.start < w.time ) )
+                    {
+                      return RESPONSE_TRY_AGAIN ;       // Yes, ask again later
+                    }
+                    w.waiting = false ;                 // Changed or time is up
+                    unpark ( request ) ;
+                    fill_state ( &states[w.slot] ) ;
+                  }
+                  return write_state ( &states[w.slot], buffer, maxLen, index ) ;
+                } ) ;
+  response->addHeader ( hdr_cc, cc_nocache ) ;
+  if ( park >= 0 )
+  {
+    waiters[park] = request ;
+    admit_release() ;                                   // Parked, not active
+  }
+  request->send ( response ) ;
+}
+
+
+//******************************************************************************************
+//                              O N F I L E R E Q U E S T                                  *
+//******************************************************************************************
+// Handle requests for file/html-pages.                                                    *
+// The requested filename is in url.                                                       *
+//******************************************************************************************
+void onFileRequest ( AsyncWebServerRequest *request )
+{
+  AllocScope  scope ( ALLOC_APP ) ;                     // Count allocations as firmware
+  const char* fnam ;                                    // Requested file
+  char        ct[MIME_TYPELEN] ;                        // Content type
+
+  fnam = request->url().c_str() ;
+  dbgprint ( "onFileRequest received %s",
+             fnam ) ;
+  getContentType ( fnam, ct ) ;                         // Get content type
+  if ( *ct == '\0' )                                    // Secret, refused before any
+                                                        // file access
+  {
+    request->send_P ( 404, "text/plain", "File not found" ) ;  
+  }
+  else
+  {
+    send_asset ( request, fnam, ct ) ;                  // Okay, send the file
+  }
+}
+
+
+//******************************************************************************************
+//                               H A N D L E _ U P L O A D                                 *
+//******************************************************************************************
+// POST /upload?file=/name with the contents as body (not a form), like:                   *
+//   curl --data-binary @style.css -H "Content-Type: application/octet-stream" \           *
+//        "http://aqledverl.local/upload?file=/style.css"                                  *
+// Every part of the body is appended to UPLOAD_FILE when it arrives, so the file is never *
+// in RAM.  When the body is complete, UPLOAD_FILE is renamed to the name, which replaces  *
+// an existing file at once: a browser gets the old or the new file, never a part.  The    *
+// ETag is the CRC-32 computed while writing.  A gzipped version of the same file is       *
+// removed, it would be sent instead of the new one.  One upload is written at a time, a   *
+// new upload takes over UPLOAD_FILE.  Secret files cannot be uploaded.                    *
+// A home page that is being sent reads index.html with the positions of its fields, so a  *
+// new index.html is refused with a 503 until no page is sent.                             *
+//******************************************************************************************
+static AsyncWebServerRequest* upowner ;                 // Request that writes UPLOAD_FILE
+static size_t                 uplen ;                   // Bytes written
+static uint32_t               upcrc ;                   // CRC-32 of bytes written
+static bool                   upok ;                    // All writes succeeded
+
+static const char* upload_name ( AsyncWebServerRequest *request )
+{
+  AsyncWebParameter* p = request->getParam ( "file" ) ; // Name of the file
+  const char*        name ;
+
+  if ( p == nullptr )
+  {
+    return nullptr ;
+  }
+  name = p->value().c_str() ;
+  if ( ( name[0] != '/' ) || strchr ( name + 1, '/' ) ||         // Not in root directory,
+       ( p->value().length() > 31 ) ||                           // too long (see asset_t)
+       mime_denied ( name ) )                                    // or secret
+  {
+    return nullptr ;
+  }
+  return name ;
+}
+
+
+void handle_upload_body ( AsyncWebServerRequest *request, uint8_t* data,
+                          size_t len, size_t index, size_t total )
+{
+  size_t fstotal, fsused ;                              // LittleFS info
+
+  if ( index == 0 )                                     // First part?
+  {
+    upowner = nullptr ;
+    hal_fs_info ( &fstotal, &fsused ) ;
+    if ( ( upload_name ( request ) == nullptr ) || ( total > fstotal - fsused ) )
+    {
+      return ;                                          // Refused, handle_upload replies
+    }
+    upowner = request ;                                 // Claim UPLOAD_FILE
+    uplen = 0 ;
+    upcrc = 0 ;
+    upok = true ;
+  }
+  if ( ( upowner != request ) || ( index != uplen ) || ! upok )
+  {
+    return ;                                            // Not ours or failed before
+  }
+  upok = hal_fs_write ( UPLOAD_FILE, data, len, index != 0 ) ;
+  upcrc = crc32 ( data, len, upcrc ) ;
+  uplen += len ;
+}
+
+
+void handle_upload ( AsyncWebServerRequest *request )
+{
+  AllocScope             scope ( ALLOC_APP ) ;          // Count allocations as firmware
+  static FixedString<80> reply ;                        // Reply, copied by send
+  const char*            name = upload_name ( request ) ; // Name of the file
+  FixedString<36>        gzpath ;                       // Gzipped version of the file
+  const char*            errmsg = nullptr ;             // Reason of rejection
+  int                    code = 400 ;                   // HTTP code of rejection
+  bool                   owner = ( upowner == request ) ; // UPLOAD_FILE is ours
+
+  dbgprint ( "HTTP upload request" ) ;
+  upowner = nullptr ;
+  if ( name == nullptr )
+  {
+    errmsg = "Parameter file missing or name not allowed" ;
+  }
+  else if ( ! owner )
+  {
+    errmsg = "No body, no room or another upload started" ;
+  }
+  else if ( ( strcmp ( name, "/index.html" ) == 0 ) && page_busy() )
+  {
+    errmsg = "Home page is being sent, try again" ;
+    code = 503 ;
+  }
+  else if ( ! upok || ( uplen != request->contentLength() ) ||
+            ! hal_fs_rename ( UPLOAD_FILE, name ) )
+  {
+    errmsg = "Writing file failed" ;
+  }
+  if ( errmsg )
+  {
+    if ( owner && hal_fs_exists ( UPLOAD_FILE ) )
+    {
+      hal_fs_remove ( UPLOAD_FILE ) ;                   // Half written, do not keep it
+    }
+    dbgprint ( "%s", errmsg ) ;
+    request->send_P ( code, "text/plain", errmsg ) ;
+    return ;
+  }
+  gzpath = name ;
+  gzpath += ".gz" ;
+  if ( hal_fs_exists ( gzpath.c_str() ) )               // Older gzipped version?
+  {
+    hal_fs_remove ( gzpath.c_str() ) ;                  // Yes, remove it
+    remove_asset ( gzpath.c_str() ) ;
+  }
+  set_asset ( name, upcrc ) ;                           // New ETag
+  if ( strcmp ( name, "/index.html" ) == 0 )
+  {
+    load_index() ;                                      // Fields have moved
+  }
+  reply.clear() ;
+  reply.printf ( "Upload of %s accepted, %u bytes", name, (unsigned)uplen ) ;
+  dbgprint ( "%s", reply.c_str() ) ;
+  request->send_P ( 200, "text/plain", reply.c_str() ) ;
+}
+
+
+//******************************************************************************************
+//                               R E Q U E S T _ G O N E                                   *
+//******************************************************************************************
+// The connection of a request is closed.  Its snapshots of the state are free again.  A   *
+// request that was disconnected before its body was complete still owns a buffer; release *
+// it, so the next request does not compare with a pointer that may be reused for a new    *
+// request.                                                                                *
+//******************************************************************************************
+void request_gone ( AsyncWebServerRequest *request )
+{
+  for ( int i = 0 ; i < STATE_SLOTS ; i++ )             // Snapshots of its response
+  {
+    if ( states[i].owner == request )
+    {
+      if ( states[i].page )
+      {
+        hal_fs_close ( states[i].file ) ;               // Page read from LittleFS
+      }
+      states[i].owner = nullptr ;
+    }
+  }
+  if ( bodyowner == request )
+  {
+    bodyowner = nullptr ;
+  }
+  if ( confowner == request )
+  {
+    confowner = nullptr ;
+  }
+  if ( upowner == request )
+  {
+    upowner = nullptr ;
+  }
+}
+
+
+//******************************************************************************************
+//                                   S H O W F I L E                                       *
+//******************************************************************************************
+// Show name and size of a file in the LittleFS and add it to the static files.            *
+//******************************************************************************************
+void showfile ( const char* name, size_t size )
+{
+  dbgprint ( "%-32s - %6d",                          // Show name and size
+             name, (int)size ) ;
+  add_asset ( name, size ) ;                         // Get ETag
+}
+
+
+//******************************************************************************************
+//                                   O T A S T A R T                                       *
+//******************************************************************************************
+// Update via WiFi has been started by Arduino IDE.                                        *
+//******************************************************************************************
+void otastart()
+{
+  dbgprint ( "OTA Started" ) ;
+  flush_settings() ;                                        // Do not lose settings
+}
+
+
+//******************************************************************************************
+//                               R U N _ C O M M A N D S                                   *
+//******************************************************************************************
+// Execute the commands queued by the handlers.  Called by loop().  Of a burst of new      *
+// settings only the last one is saved, so the flash is written once.                      *
+//******************************************************************************************
+void run_commands()
+{
+  cmd_t        cmd ;                                        // Command from queue
+  static set_t newset ;                                     // Latest settings from queue
+  bool         save = false ;                               // newset to be saved
+
+  while ( cmdqueue.pop ( cmd ) )
+  {
+    switch ( cmd.code )
+    {
+      case CMD_SETCONF :
+        overrule = false ;                                  // No more overrule
+        preview = false ;                                   // And no preview
+        newset = cmd.set ;                                  // Save later, only the last
+        save = true ;
+        break ;
+      case CMD_OVERRULE :
+        overrule = true ;                                   // Set overrule flag
+        preview = false ;                                   // End of preview
+        ovA = cmd.a ;                                       // Set overule lamp A value
+        ovB = cmd.b ;                                       // Set overule lamp B value
+        ovtime = 0 ;                                        // Until the next change
+        break ;
+      case CMD_PREVIEW :
+        pvA = cmd.a ;                                       // Keep latest values
+        pvB = cmd.b ;
+        pvtime = hal_millis() ;
+        preview = true ;
+        break ;
+      case CMD_BATCH :                                      // See handle_batch()
+        if ( cmd.flags & ( BATCH_SET | BATCH_OVERRULE | BATCH_CLEAR ) )
+        {
+          preview = false ;
+        }
+        if ( cmd.flags & BATCH_SET )
+        {
+          newset = cmd.set ;
+          save = true ;
+        }
+        if ( cmd.flags & BATCH_CLEAR )
+        {
+          overrule = false ;
+        }
+        if ( cmd.flags & BATCH_OVERRULE )
+        {
+          overrule = true ;
+          ovA = cmd.a ;
+          ovB = cmd.b ;
+          ovtime = cmd.ovtime ;                             // 0 for no end
+          ovstart = hal_millis() ;
+        }
+        break ;
+      case CMD_RESET :
+        if ( save )
+        {
+          save_settings ( newset ) ;                        // Accept queued settings
+        }
+        flush_settings() ;                                  // and save them now
+        hal_delay ( 100 ) ;                                 // Give reply time to go out
+        hal_reset() ;
+        break ;
+    }
+  }
+  if ( save )
+  {
+    save_settings ( newset ) ;                              // Accept, save later
+  }
+}
+
+
+//******************************************************************************************
+//                          M I G R A T E _ S E T T I N G S                                *
+//******************************************************************************************
+// Convert saved settings of an older layout in place.  migrations[n] converts layout n    *
+// to layout n+1.  When set_t changes, SETLAYOUT is raised and a migration is added here.  *
+//******************************************************************************************
+static void migrate_v0 ( uint8_t* data, size_t* len )     // Bare set_t, EEPROM or journal
+{                                                         // before setrec_t
+  setrec_t* rec = (setrec_t*)data ;
+
+  memmove ( &rec->set, data, sizeof(rec->set) ) ;         // Make room for the header
+  rec->magic = SETMAGIC ;
+  rec->layout = 1 ;
+  rec->len = sizeof(rec->set) ;
+  rec->crc = crc32 ( &rec->set, sizeof(rec->set) ) ;
+  *len = sizeof(setrec_t) ;
+}
+
+static void (* const migrations[SETLAYOUT])( uint8_t* data, size_t* len ) =
+{
+  migrate_v0                                              // 0 -> 1
+} ;
+
+
+//******************************************************************************************
+//                            C H E C K _ S E T T I N G S                                  *
+//******************************************************************************************
+// Bring saved settings to the current layout and check them.  data must have room for     *
+// JOURNAL_MAXDATA bytes.  Returns false if the settings cannot be used.                   *
+// Data of the size of a set_t is always bare settings: the values 65, 65, 81, 83 at the   *
+// start look like SETMAGIC, but a record with a header is longer.  Only bare settings are *
+// layout 0; a record with a header and layout 0 is damaged, migrate_v0() would shift the  *
+// header into the values and give the result a valid CRC.                                 *
+//******************************************************************************************
+static bool check_settings ( uint8_t* data, size_t len )
+{
+  setrec_t* rec = (setrec_t*)data ;
+  uint16_t  layout ;                                        // Layout of the data
+  int       i ;                                             // Loop control
+
+  if ( ( len != sizeof(set_t) ) && ( len >= sizeof(setrec_t) - sizeof(set_t) ) &&
+       ( rec->magic == SETMAGIC ) && ( rec->layout > 0 ) )
+  {
+    layout = rec->layout ;                                  // Record with a header
+  }
+  else if ( len == sizeof(set_t) )
+  {
+    layout = 0 ;                                            // Bare settings
+  }
+  else
+  {
+    return false ;                                          // Unknown
+  }
+  while ( layout < SETLAYOUT )                              // Convert to current layout
+  {
+    migrations[layout++] ( data, &len ) ;
+  }
+  if ( ( len != sizeof(setrec_t) ) || ( rec->layout != SETLAYOUT ) ||
+       ( rec->len != sizeof(rec->set) ) ||
+       ( rec->crc != crc32 ( &rec->set, sizeof(rec->set) ) ) )
+  {
+    return false ;                                          // Newer firmware or damaged
+  }
+  for ( i = 0 ; i < 48 ; i++ )
+  {
+    if ( rec->set.values[i] > MAXINTENSITY )                // Erased flash or garbage?
+    {
+      return false ;
+    }
+  }
+  return true ;
+}
+
+
+//******************************************************************************************
+//                             L O A D _ S E T T I N G S                                   *
+//******************************************************************************************
+// Get the settings from the journal.  If there is no journal yet, the settings of an      *
+// older version are imported from EEPROM.  A journal that is there but cannot be used     *
+// gives the defaults: EEPROM is older than any journal, its values would silently replace *
+// newer settings.  If EEPROM is unusable as well the defaults are taken.                  *
+// Imported, converted or default settings are saved in the journal by the next loop().    *
+// Returns the source of the settings.                                                     *
+//******************************************************************************************
+const char* load_settings()
+{
+  static uint8_t data[JOURNAL_MAXDATA] ;                    // Saved settings
+  setrec_t*      rec = (setrec_t*)data ;
+  size_t         len = 0 ;                                  // Length of data
+  const char*    from = "journal" ;                         // Source of the settings
+  bool           ok = false ;                               // Settings usable
+  bool           current = false ;                          // Journal in current layout
+
+  if ( journal_load ( data, sizeof(data), &len ) )
+  {
+    current = ( rec->magic == SETMAGIC ) &&                 // Current layout?
+              ( rec->layout == SETLAYOUT ) ;
+    ok = check_settings ( data, len ) ;
+  }
+  if ( ( ! ok ) && ( ! hal_fs_exists ( JOURNAL_FILE ) ) )
+  {
+    hal_eeprom_begin ( 512 ) ;                              // No journal, try EEPROM
+    hal_eeprom_read ( 0, data, sizeof(set_t) ) ;
+    hal_eeprom_end() ;                                      // Shadow no longer needed
+    from = "EEPROM" ;
+    ok = check_settings ( data, sizeof(set_t) ) ;
+  }
+  if ( ! ok )
+  {
+    memcpy_P ( &rec->set, &defset, sizeof(defset) ) ;       // Unusable, take defaults
+    from = "defaults" ;
+  }
+  if ( ! ( ok && current ) )                                // Not from journal as is?
+  {
+    savedue = true ;                                        // Save in journal
+    savetime = hal_millis() - SAVE_DELAY ;                  // as soon as possible
+  }
+  reqset = rec->set ;
+  dbgprint ( "Settings from %s", from ) ;
+  publish_settings ( reqset ) ;                             // Also the base for patches
+  return from ;
+}
+
+
+//******************************************************************************************
+//                                   S E T U P                                             *
+//******************************************************************************************
+// Setup for the program.  Everything that needs the heap is allocated here.               *
+//******************************************************************************************
+void setup()
+{
+  size_t      total, used ;                          // LittleFS info
+
+  hal_begin() ;                                      // For debugging
+  dbgprint ( "Starting " HOSTNAME "..." ) ;          // Show activity
+  dbgprint ( "Version " VERSION ) ;
+  hal_pwm_begin ( MAXINTENSITY ) ;                   // PWM range 0..100 percent
+  hal_led ( true ) ;                                 // Show LED for test
+  hal_delay ( 500 ) ;                                // For at least 500 msec
+  // Show some info about the LittleFS
+  hal_fs_begin() ;                                   // Enable file system
+  hal_fs_info ( &total, &used ) ;
+  dbgprint ( "FS Total %d, used %d",                 // Show FS overview
+             (int)total, (int)used ) ;
+  hal_fs_list ( showfile ) ;                         // Show files in FS, get ETags
+  load_index() ;                                     // Find fields of home page
+  load_settings() ;                                  // Settings from journal
+  hal_wifi_begin ( HOSTNAME ) ;                      // Connect to the best network
+  httpserver = new AsyncWebServer ( HTTPPORT ) ;     // Create HTTP server
+  httpserver->addHandler ( new AdmitHandler ) ;      // Must be first, sees all requests
+  httpserver->on ( "/",         handle_root ) ;      // Homepage request
+  httpserver->on ( "/index.html", handle_root ) ;    // Same, from the menu
+  httpserver->on ( "/logging",  handle_logging ) ;   // Handle logging by a callback
+  httpserver->on ( "/getconf",  handle_getconf ) ;   // Handle get configuration
+  httpserver->on ( "/setconf",  HTTP_POST,          // Configuration in the body
+                   handle_setconf, nullptr, handle_setconf_body ) ;
+  httpserver->on ( "/patchconf", HTTP_POST,
+                   handle_patchconf, nullptr, handle_patchconf_body ) ;
+  httpserver->on ( "/setconf",  handle_setconf ) ;   // Handle get configuration
+  httpserver->on ( "/patchconf", handle_patchconf ) ; // Handle partial configuration
+  httpserver->on ( "/upload",   HTTP_POST,           // Write a file in LittleFS
+                   handle_upload, nullptr, handle_upload_body ) ;
+  httpserver->on ( "/overrule", handle_overrule ) ;  // Handle get configuration
+  httpserver->on ( "/preview",  handle_preview ) ;   // Live preview, not saved
+  httpserver->on ( "/batch",    handle_batch ) ;     // Several operations at once
+  httpserver->on ( "/events",   HTTP_GET,            // Changes pushed to clients
+                   handle_events ) ;
+  httpserver->on ( "/wait",     HTTP_GET,            // Long poll for a change
+                   handle_wait ) ;
+  httpserver->on ( "/conf.bin", HTTP_GET,            // Binary configuration
+                   handle_getconfbin ) ;
+  httpserver->on ( "/conf.bin", HTTP_POST,
+                   handle_putconfbin, nullptr, handle_confbin_body ) ;
+  httpserver->on ( "/reset",    handle_reset ) ;     // Handle reset request
+  httpserver->on ( "/test",     handle_test ) ;      // Handle test request
+  httpserver->on ( "/api/state", handle_state ) ;    // State as JSON
+  httpserver->onNotFound ( onFileRequest ) ;         // Handling of other requests
+  httpserver->begin() ;                              // Start http server
+  dbgprint ( "HTTP-server started on port %d",       // Show event
+             HTTPPORT ) ;
+  hal_ota_begin ( HOSTNAME, otastart ) ;             // Allow update over the air
+  hal_ntp_begin() ;                                  // Enable NTP service
+  hal_timer_1sec ( timer1sec ) ;                     // Every 1000 msec
+  hal_led ( false ) ;                                // Turn LED off
+  alloc_reset() ;                                    // Count allocations from here
+}
+
+
+//******************************************************************************************
+//                            P U B L I S H _ S T A T E                                    *
+//******************************************************************************************
+// Called by loop() after the outputs are set.  Publishes a frame for the clients of       *
+// /events when something changed, with the most important change as event name, or a      *
+// heartbeat after PUSH_HEARTBEAT msec without a change.  Every frame has the whole state. *
+// A change also raises stateversion, that ends the waiting of /wait, and wakes the parked *
+// /wait requests at once.                                                                 *
+//******************************************************************************************
+static void publish_state ( uint32_t millisnow )
+{
+  static uint8_t  lastA, lastB ;                            // State in the last frame
+  static bool     lastov, lastpv ;
+  static uint8_t  lastovA, lastovB ;
+  static uint32_t lastver ;
+  static uint32_t lasttime ;                                // Time of the last frame
+  char            data[PUSH_FRAMELEN - 40] ;                // Leave room for id and event
+  const char*     event ;                                   // Name of the event
+  uint32_t        ver = __atomic_load_n ( &setversion, __ATOMIC_ACQUIRE ) ;
+  uint32_t        left = 0 ;                                // Seconds of overrule left
+
+  if ( ver != lastver )
+  {
+    event = "config" ;
+  }
+  else if ( ( overrule != lastov ) || ( ovA != lastovA ) || ( ovB != lastovB ) )
+  {
+    event = "overrule" ;
+  }
+  else if ( ( intensityA != lastA ) || ( intensityB != lastB ) || ( preview != lastpv ) )
+  {
+    event = "output" ;
+  }
+  else if ( ( millisnow - lasttime >= PUSH_HEARTBEAT ) || ( push_seq() == 0 ) )
+  {
+    event = "heartbeat" ;
+  }
+  else
+  {
+    return ;                                                // Nothing to tell
+  }
+  if ( strcmp ( event, "heartbeat" ) )                      // A change?
+  {
+    __atomic_store_n ( &stateversion, stateversion + 1, __ATOMIC_RELEASE ) ;  // For /wait
+  }
+  if ( overrule && ovtime && ( millisnow - ovstart < ovtime ) )
+  {
+    left = ( ovtime - ( millisnow - ovstart ) + 999 ) / 1000 ;
+  }
+  snprintf ( data, sizeof(data),
+             "{\"A\":%u,\"B\":%u,\"overrule\":%s,\"ovA\":%u,\"ovB\":%u,"
+             "\"remaining\":%u,\"preview\":%s,\"settings_version\":%u,"
+             "\"state_version\":%u}",
+             intensityA, intensityB, overrule ? "true" : "false", ovA, ovB,
+             (unsigned)left, preview ? "true" : "false", (unsigned)ver,
+             (unsigned)stateversion ) ;
+  push_publish ( event, data ) ;
+  lastA = intensityA ;
+  lastB = intensityB ;
+  lastov = overrule ;
+  lastpv = preview ;
+  lastovA = ovA ;
+  lastovB = ovB ;
+  lastver = ver ;
+  lasttime = millisnow ;
+}
+
+
+//******************************************************************************************
+//                                   L O O P                                               *
+//******************************************************************************************
+// Main loop of the program.                                                               *
+//******************************************************************************************
+void loop()
+{
+  AllocScope      scope ( ALLOC_APP ) ;                     // Count allocations as firmware
+  static uint32_t rfrltm = 0 ;                              // Timer for refresh local time
+  uint32_t        millisnow ;                               // Current value of 
+  uint8_t         inx ;                                     // Index in settings
+  const set_t*    cur ;                                     // Active settings
+  uint8_t         newA ;                                    // New intensity for lamp A
+  uint8_t         newB ;                                    // New intensity for lamp B
+
+  run_commands() ;                                          // Changes from the handlers
+  millisnow = hal_millis() ;                                // Get runtime
+  if ( savedue && ( millisnow - savetime >= SAVE_DELAY ) )  // Time to save settings?
+  {
+    flush_settings() ;                                      // Yes, add to journal
+  }
+  time_ok = hal_ntp_update() ;                              // Update time
+  if ( time_ok )                                            // Do we know the time?
+  {
+    if ( millisnow > rfrltm )                               // Yes, need for refresh?
+    {
+      rfrltm = millisnow * 1000 * 600 ;                     // Yes, set new refreshmoment
+      ltime = hal_ntp_localtime() ;                         // Get local time
+    }
+  }
+  if ( preview && ( millisnow - pvtime > PREVIEW_TIME ) )   // Preview abandoned?
+  {
+    preview = false ;                                       // Yes, back to normal
+  }
+  if ( overrule && ovtime && ( millisnow - ovstart >= ovtime ) )  // Overrule ended?
+  {
+    overrule = false ;                                      // Yes, back to schedule
+  }
+  if ( preview )                                            // Live preview?
+  {
+    newA = pvA ;                                            // Yes, show latest values
+    newB = pvB ;
+  }
+  else if ( overrule )                                      // Overrule timed setting?
+  {
+    newA = ovA ;                                            // Yes, get new setting
+    newB = ovB ;
+  }
+  else
+  {
+    cur = active_settings() ;                               // One consistent schedule
+    inx = hour ( ltime ) ;                                  // Index in settings (0..47)
+    newA = cur->values[inx*2] ;                             // Get intensity lamp A
+    newB = cur->values[inx*2+1] ;                           // Get intensity lamp B
+  }
+  if ( newA != intensityA )                                 // Lamp A change needed?
+  {
+    intensityA = newA ;                                     // Yes, remember new value
+    hal_pwm_write ( LAMP_A, intensityA ) ;                  // Set intensity lamp A
+  }
+  if ( newB != intensityB )                                 // Lamp B change needed?
+  {
+    intensityB = newB ;                                     // Yes, remember new value
+    hal_pwm_write ( LAMP_B, intensityB ) ;                  // Set intensity lamp B
+  }
+  publish_state ( millisnow ) ;                             // Tell clients of /events
+  hal_net_loop() ;                                          // Handle mDNS and OTA
+}
@@ -0,0 +1,231 @@
+//******************************************************************************************
+// mimetype.cpp - Content type of a file by its extension, and files that are never served.*
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Tables in PROGMEM                                                      *
+//******************************************************************************************
+#include "mimetype.h"
+#include "hal.h"
+#include <string.h>
+
+//******************************************************************************************
+// An extension of at most 4 characters is packed into a number, so the search compares    *
+// numbers instead of strings.  The table below is in alphabetical order; the compiler     *
+// makes a copy sorted on that number, with the content types in it.  Only that copy is    *
+// in the firmware, in PROGMEM: on the ESP8266 a constexpr table and its strings would be  *
+// in RAM.  The search reads it with pgm_read_dword(), the type is copied with memcpy_P(). *
+//******************************************************************************************
+constexpr uint32_t ext_key ( const char* ext )
+{
+  uint32_t key = 0 ;
+
+  for ( int i = 0 ; ( i < 4 ) && ext[i] ; i++ )
+  {
+    key |= (uint32_t)(uint8_t)ext[i] << ( 8 * i ) ;
+  }
+  return key ;
+}
+
+struct mime_t
+{
+  const char* ext ;                                           // Extension, lower case
+  const char* type ;                                          // Content type
+} ;
+
+static constexpr mime_t mimetypes[] =                         // Only used by the compiler
+{
+  { "css",  "text/css" },
+  { "gif",  "image/gif" },
+  { "gz",   "application/x-gzip" },
+  { "html", "text/html" },
+  { "ico",  "image/x-icon" },
+  { "jpg",  "image/jpeg" },
+  { "js",   "application/javascript" },
+  { "json", "application/json" },
+  { "png",  "image/png" },
+  { "svg",  "image/svg+xml" },
+  { "zip",  "application/x-zip" },
+} ;
+#define NMIMETYPES ( sizeof(mimetypes) / sizeof(mimetypes[0]) )
+#define MAXEXT     4                                          // Longest ext in mimetypes
+
+struct mimetab_t                                              // mimetypes, sorted on key
+{
+  uint32_t    key[NMIMETYPES] ;
+  char        type[NMIMETYPES][MIME_TYPELEN] ;
+} ;
+
+constexpr void copy_type ( char* dst, const char* src )       // Cut off, see mimetypes_ok()
+{
+  for ( size_t n = 0 ; ( n < MIME_TYPELEN - 1 ) && src[n] ; n++ )
+  {
+    dst[n] = src[n] ;
+  }
+}
+
+constexpr mimetab_t sort_mimetypes()
+{
+  mimetab_t t {} ;
+  size_t    i = 0 ;
+  size_t    j = 0 ;
+
+  for ( i = 0 ; i < NMIMETYPES ; i++ )                        // Insertion sort
+  {
+    for ( j = i ; ( j > 0 ) && ( t.key[j-1] > ext_key ( mimetypes[i].ext ) ) ; j-- )
+    {
+      t.key[j] = t.key[j-1] ;
+      for ( size_t n = 0 ; n < MIME_TYPELEN ; n++ )
+      {
+        t.type[j][n] = t.type[j-1][n] ;
+      }
+    }
+    t.key[j] = ext_key ( mimetypes[i].ext ) ;
+    for ( size_t n = 0 ; n < MIME_TYPELEN ; n++ )
+    {
+      t.type[j][n] = '\0' ;
+    }
+    copy_type ( t.type[j], mimetypes[i].type ) ;
+  }
+  return t ;
+}
+
+static constexpr mimetab_t sorted = sort_mimetypes() ;       // For the checks
+static const mimetab_t mimetab PROGMEM = sort_mimetypes() ;
+
+constexpr bool mimetypes_ok()                                 // Short and unique?
+{
+  for ( size_t i = 0 ; i < NMIMETYPES ; i++ )
+  {
+    if ( ( mimetypes[i].ext[0] == '\0' ) || ( i && ( sorted.key[i-1] == sorted.key[i] ) ) )
+    {
+      return false ;
+    }
+    for ( size_t n = 0 ; mimetypes[i].ext[n] ; n++ )
+    {
+      if ( n == MAXEXT )
+      {
+        return false ;
+      }
+    }
+    for ( size_t n = 0 ; mimetypes[i].type[n] ; n++ )
+    {
+      if ( n == MIME_TYPELEN - 1 )
+      {
+        return false ;
+      }
+    }
+  }
+  return true ;
+}
+
+static_assert ( mimetypes_ok(), "extensions in mimetypes[] must be unique, 1..4 characters, "
+                                "types shorter than MIME_TYPELEN" ) ;
+
+struct deny_t
+{
+  char        suffix[12] ;                                    // End of name, lower case
+  uint8_t     len ;                                           // Length of suffix
+} ;
+
+#define DENY(s) { s, sizeof(s) - 1 }
+static const deny_t denied[] PROGMEM =                        // Secret files
+{
+  DENY ( ".pw" ),                                             // WiFi passwords
+  DENY ( ".jnl" ),                                            // Settings journal
+  DENY ( ".jnl.new" ),                                        // Journal being compacted
+  DENY ( ".tmp" )                                             // Upload being written
+} ;
+
+
+//******************************************************************************************
+//                                M I M E _ D E N I E D                                    *
+//******************************************************************************************
+static bool denied_suffix ( const char* path, size_t n )    // n is the length of path
+{
+  const char* p ;                                             // Compared part of path
+  size_t      i ;
+  size_t      len ;                                           // Length of a suffix
+
+  for ( const deny_t& d : denied )
+  {
+    len = pgm_read_byte ( &d.len ) ;
+    if ( len <= n )
+    {
+      p = path + n - len ;
+      for ( i = 0 ; ( i < len ) && ( ( p[i] | 0x20 ) == pgm_read_byte ( &d.suffix[i] ) ) ;
+            i++ ) ;
+      if ( i == len )                                         // All characters equal?
+      {
+        return true ;                                         // Yes, secret
+      }
+    }
+  }
+  return false ;
+}
+
+
+bool mime_denied ( const char* path )
+{
+  return denied_suffix ( path, strlen ( path ) ) ;
+}
+
+
+//******************************************************************************************
+//                                  M I M E _ T Y P E                                      *
+//******************************************************************************************
+// Only the last MAXEXT+1 characters of path are looked at to find the extension.          *
+//******************************************************************************************
+const char* mime_type ( const char* path, char* type )
+{
+  size_t      n = strlen ( path ) ;                           // Length of path
+  size_t      i ;                                             // Length of extension + 1
+  const char* p ;                                             // The extension
+  uint32_t    key = 0 ;                                       // ext_key() in lower case
+  uint32_t    midkey ;                                        // Key of mid in the table
+  size_t      lo = 0 ;                                        // First candidate
+  size_t      hi = NMIMETYPES ;                               // Behind last candidate
+  size_t      mid ;
+  char        c ;
+
+  strcpy_P ( type, PSTR ( "text/plain" ) ) ;                 // When not found
+  if ( denied_suffix ( path, n ) )                            // Secret?
+  {
+    *type = '\0' ;                                            // Yes, no type at all
+    return type ;
+  }
+  for ( i = 1 ; ( i <= n ) && ( path[n-i] != '.' ) ; i++ )    // Search the dot
+  {
+    if ( ( i > MAXEXT ) || ( path[n-i] == '/' ) )
+    {
+      return type ;                                           // Too long or no extension
+    }
+  }
+  if ( i > n )
+  {
+    return type ;                                             // No dot at all
+  }
+  for ( p = path + n - i + 1, i = 0 ; p[i] ; i++ )            // Pack the extension
+  {
+    c = ( p[i] >= 'A' && p[i] <= 'Z' ) ? p[i] + 'a' - 'A' : p[i] ;
+    key |= (uint32_t)(uint8_t)c << ( 8 * i ) ;
+  }
+  while ( lo < hi )
+  {
+    mid = ( lo + hi ) / 2 ;
+    midkey = pgm_read_dword ( &mimetab.key[mid] ) ;
+    if ( key == midkey )
+    {
+      memcpy_P ( type, mimetab.type[mid], MIME_TYPELEN ) ;
+      return type ;
+    }
+    if ( key < midkey )
+    {
+      hi = mid ;
+    }
+    else
+    {
+      lo = mid + 1 ;
+    }
+  }
+  return type ;
+}
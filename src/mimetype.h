@@ -0,0 +1,32 @@
+//******************************************************************************************
+// mimetype.h - Content type of a file by its extension, and files that are never served.  *
+//******************************************************************************************
+// The extensions are in a table that is sorted at compile time and searched with a binary *
+// search.  The extension is compared without regard to case.                              *
+// The deny list is checked on its own, before the table, so it does not depend on the     *
+// order of the table.  mime_type() returns "" for a denied file: WiFi passwords, the      *
+// settings journal and an upload that is not complete.                                    *
+// The tables are in PROGMEM, the content type is copied to a buffer of the caller.        *
+//******************************************************************************************
+// 16-10-2026, AG - First setup, replaces the endsWith() chain in getContentType()         *
+// 17-10-2026, AG - Tables in PROGMEM, type copied to the caller                           *
+//******************************************************************************************
+#ifndef MIMETYPE_H
+#define MIMETYPE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+constexpr int const_strcmp ( const char* a, const char* b )   // strcmp() for the compiler
+{
+  return ( *a != *b || *a == '\0' ) ? (uint8_t)*a - (uint8_t)*b : const_strcmp ( a + 1, b + 1 ) ;
+}
+
+#define MIME_TYPELEN  24                                      // Longest content type + 1
+
+bool        mime_denied ( const char* path ) ;                // Never send this file
+const char* mime_type ( const char* path,                     // Content type in type,
+                        char* type ) ;                        // MIME_TYPELEN; "text/plain"
+                                                              // if unknown, "" if denied
+
+#endif
@@ -0,0 +1,96 @@
+//******************************************************************************************
+// alloc_native.cpp - Heap functions of the host build.                                   *
+//******************************************************************************************
+// malloc() and friends are replaced by versions that count and then call the glibc        *
+// originals, or the replacement heap of a harness.  operator new uses malloc(), so C++    *
+// allocations are counted as well.  free() and realloc() find the owner of a block by its *
+// address, so blocks can be freed after the replacement heap is switched off.             *
+//******************************************************************************************
+// 16-10-2026, AG - First setup, counting moved from host/bench                            *
+//******************************************************************************************
+#include "hal_native.h"
+#include "alloccount.h"
+
+hal_alloc_t              hal_alloc ;                          // Totals
+static const hal_heap_t* heap ;                               // Replacement heap, if any
+static bool              useheap ;                            // New blocks from heap
+
+
+void hal_set_heap ( const hal_heap_t* h )
+{
+  heap = h ;
+}
+
+
+void hal_use_heap ( bool on )
+{
+  useheap = on && heap ;
+}
+
+
+static inline void count ( size_t size )
+{
+  alloc_note() ;
+  __atomic_fetch_add ( &hal_alloc.allocs, 1, __ATOMIC_RELAXED ) ;
+  __atomic_fetch_add ( &hal_alloc.bytes, size, __ATOMIC_RELAXED ) ;
+}
+
+
+extern "C"
+{
+  void* __libc_malloc ( size_t size ) ;
+  void* __libc_calloc ( size_t n, size_t size ) ;
+  void* __libc_realloc ( void* ptr, size_t size ) ;
+  void  __libc_free ( void* ptr ) ;
+
+  void* malloc ( size_t size )
+  {
+    count ( size ) ;
+    if ( useheap )
+    {
+      return heap->malloc ( size ) ;
+    }
+    return __libc_malloc ( size ) ;
+  }
+
+  void* calloc ( size_t n, size_t size )
+  {
+    void* p ;
+
+    count ( n * size ) ;
+    if ( useheap )
+    {
+      if ( ( p = heap->malloc ( n * size ) ) )
+      {
+        memset ( p, 0, n * size ) ;
+      }
+      return p ;
+    }
+    return __libc_calloc ( n, size ) ;
+  }
+
+  void* realloc ( void* ptr, size_t size )
+  {
+    count ( size ) ;                                          // Grow counts as allocation
+    if ( heap && ( ptr ? heap->owns ( ptr ) : useheap ) )
+    {
+      return heap->realloc ( ptr, size ) ;
+    }
+    return __libc_realloc ( ptr, size ) ;
+  }
+
+  void free ( void* ptr )
+  {
+    if ( ptr == nullptr )
+    {
+      return ;
+    }
+    __atomic_fetch_add ( &hal_alloc.frees, 1, __ATOMIC_RELAXED ) ;
+    if ( heap && heap->owns ( ptr ) )
+    {
+      heap->free ( ptr ) ;
+      return ;
+    }
+    __libc_free ( ptr ) ;
+  }
+}
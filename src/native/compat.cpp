@@ -0,0 +1,369 @@
+//******************************************************************************************
+// compat.cpp - Arduino compatible String class for the host (Linux) build.               *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "compat.h"
+#include <ctype.h>
+
+
+//******************************************************************************************
+//                          C O N S T R U C T O R S                                        *
+//******************************************************************************************
+String::String ( const char* cstr )
+{
+  if ( cstr )
+  {
+    copy ( cstr, strlen ( cstr ) ) ;
+  }
+}
+
+
+String::String ( const String& str )
+{
+  *this = str ;
+}
+
+
+String::String ( String&& str )
+{
+  *this = static_cast<String&&>( str ) ;
+}
+
+
+String::String ( char c )
+{
+  copy ( &c, 1 ) ;
+}
+
+
+String::String ( unsigned char value, unsigned char base )
+  : String ( (unsigned long)value, base )
+{
+}
+
+
+String::String ( int value, unsigned char base )
+  : String ( (long)value, base )
+{
+}
+
+
+String::String ( unsigned int value, unsigned char base )
+  : String ( (unsigned long)value, base )
+{
+}
+
+
+String::String ( long value, unsigned char base )
+{
+  char buf[2 + 8 * sizeof(long)] ;
+
+  if ( ( base == 10 ) && ( value < 0 ) )
+  {
+    snprintf ( buf, sizeof(buf), "-%lu", 0UL - (unsigned long)value ) ;
+    copy ( buf, strlen ( buf ) ) ;
+  }
+  else
+  {
+    *this = String ( (unsigned long)value, base ) ;
+  }
+}
+
+
+String::String ( unsigned long value, unsigned char base )
+{
+  char  buf[1 + 8 * sizeof(unsigned long)] ;
+  char* p = buf + sizeof(buf) - 1 ;
+
+  *p = '\0' ;
+  do
+  {
+    unsigned long d = value % base ;
+    *--p = d < 10 ? '0' + d : 'a' + d - 10 ;
+    value /= base ;
+  } while ( value ) ;
+  copy ( p, strlen ( p ) ) ;
+}
+
+
+String::~String()
+{
+  if ( ! isSSO() )
+  {
+    free ( buffer() ) ;
+  }
+}
+
+
+//******************************************************************************************
+//                          M E M O R Y   M A N A G E M E N T                              *
+//******************************************************************************************
+void String::invalidate()
+{
+  if ( ! isSSO() )
+  {
+    free ( buffer() ) ;
+  }
+  setSSO() ;
+}
+
+
+bool String::reserve ( unsigned int size )
+{
+  char* newbuffer ;
+
+  if ( capacity() >= size )                          // Fits in current buffer?
+  {
+    return true ;
+  }
+  if ( size > 0xFFFF )                               // Length is 16 bits, as on the ESP
+  {
+    return false ;
+  }
+  if ( isSSO() )                                     // Move from internal buffer to heap
+  {
+    newbuffer = (char*)malloc ( size + 1 ) ;
+    if ( newbuffer )
+    {
+      memcpy ( newbuffer, sso.buff, len() + 1 ) ;
+    }
+  }
+  else
+  {
+    newbuffer = (char*)realloc ( buffer(), size + 1 ) ;
+  }
+  if ( newbuffer == nullptr )
+  {
+    return false ;
+  }
+  setHeap ( newbuffer, size, len() ) ;
+  return true ;
+}
+
+
+void String::copy ( const char* cstr, unsigned int length )
+{
+  if ( ! reserve ( length ) )
+  {
+    invalidate() ;
+    return ;
+  }
+  setLen ( length ) ;
+  memmove ( buffer(), cstr, length ) ;
+  buffer()[len()] = '\0' ;
+}
+
+
+bool String::concat ( const char* cstr, unsigned int length )
+{
+  if ( length == 0 )
+  {
+    return true ;
+  }
+  if ( ! reserve ( len() + length ) )
+  {
+    return false ;
+  }
+  memmove ( buffer() + len(), cstr, length ) ;
+  setLen ( len() + length ) ;
+  buffer()[len()] = '\0' ;
+  return true ;
+}
+
+
+//******************************************************************************************
+//                                O P E R A T O R S                                        *
+//******************************************************************************************
+String& String::operator = ( const String& rhs )
+{
+  if ( this != &rhs )
+  {
+    copy ( rhs.buffer(), rhs.len() ) ;
+  }
+  return *this ;
+}
+
+
+String& String::operator = ( String&& rhs )
+{
+  if ( this != &rhs )
+  {
+    if ( rhs.isSSO() )                               // Short string, just copy
+    {
+      copy ( rhs.buffer(), rhs.len() ) ;
+    }
+    else                                             // Take over heap buffer
+    {
+      invalidate() ;
+      setHeap ( rhs.ptr.buff, rhs.ptr.cap, rhs.ptr.len ) ;
+      rhs.setSSO() ;
+    }
+  }
+  return *this ;
+}
+
+
+String& String::operator = ( const char* cstr )
+{
+  if ( cstr )
+  {
+    copy ( cstr, strlen ( cstr ) ) ;
+  }
+  else
+  {
+    invalidate() ;
+  }
+  return *this ;
+}
+
+
+char String::operator [] ( unsigned int index ) const
+{
+  if ( index >= len() )
+  {
+    return '\0' ;
+  }
+  return buffer()[index] ;
+}
+
+
+String operator + ( const String& lhs, const String& rhs )
+{
+  String res ( lhs ) ;
+
+  res += rhs ;
+  return res ;
+}
+
+
+String operator + ( const String& lhs, const char* rhs )
+{
+  String res ( lhs ) ;
+
+  res += rhs ;
+  return res ;
+}
+
+
+//******************************************************************************************
+//                        C O M P A R E   A N D   S E A R C H                              *
+//******************************************************************************************
+bool String::equals ( const char* cstr ) const
+{
+  return strcmp ( buffer(), cstr ? cstr : "" ) == 0 ;
+}
+
+
+bool String::equalsIgnoreCase ( const String& s ) const
+{
+  return ( len() == s.len() ) && ( strcasecmp ( c_str(), s.c_str() ) == 0 ) ;
+}
+
+
+bool String::startsWith ( const char* prefix ) const
+{
+  size_t n = strlen ( prefix ) ;
+
+  return ( n <= len() ) && ( strncmp ( c_str(), prefix, n ) == 0 ) ;
+}
+
+
+bool String::endsWith ( const char* suffix ) const
+{
+  size_t n = strlen ( suffix ) ;
+
+  return ( n <= len() ) && ( strcmp ( c_str() + len() - n, suffix ) == 0 ) ;
+}
+
+
+int String::indexOf ( char c, unsigned int from ) const
+{
+  const char* p ;
+
+  if ( from >= len() )
+  {
+    return -1 ;
+  }
+  p = strchr ( buffer() + from, c ) ;
+  return p ? p - buffer() : -1 ;
+}
+
+
+int String::indexOf ( const char* s, unsigned int from ) const
+{
+  const char* p ;
+
+  if ( from >= len() )
+  {
+    return -1 ;
+  }
+  p = strstr ( buffer() + from, s ) ;
+  return p ? p - buffer() : -1 ;
+}
+
+
+//******************************************************************************************
+//                             M O D I F I C A T I O N                                     *
+//******************************************************************************************
+String String::substring ( unsigned int from, unsigned int to ) const
+{
+  String res ;
+
+  if ( from > to )
+  {
+    unsigned int t = from ;
+    from = to ;
+    to = t ;
+  }
+  if ( from >= len() )
+  {
+    return res ;
+  }
+  if ( to > len() )
+  {
+    to = len() ;
+  }
+  res.copy ( buffer() + from, to - from ) ;
+  return res ;
+}
+
+
+void String::trim()
+{
+  char* begin ;
+  char* end ;
+
+  if ( len() == 0 )
+  {
+    return ;
+  }
+  begin = buffer() ;
+  while ( isspace ( *begin ) )
+  {
+    begin++ ;
+  }
+  end = buffer() + len() - 1 ;
+  while ( ( end >= begin ) && isspace ( *end ) )
+  {
+    end-- ;
+  }
+  setLen ( end + 1 - begin ) ;
+  memmove ( buffer(), begin, len() ) ;
+  buffer()[len()] = '\0' ;
+}
+
+
+void String::toLowerCase()
+{
+  for ( unsigned int i = 0 ; i < len() ; i++ )
+  {
+    buffer()[i] = tolower ( buffer()[i] ) ;
+  }
+}
+
+
+long String::toInt() const
+{
+  return atol ( buffer() ) ;
+}
@@ -0,0 +1,131 @@
+//******************************************************************************************
+// compat.h - Arduino compatible definitions for the host (Linux) build.                  *
+//******************************************************************************************
+// Only the parts of the Arduino core that are used by the application are here:           *
+//  - String, a subset of the Arduino WString class with the same allocation behaviour     *
+//    and the same layout (16 bytes on a 64 bit host, 12 on the ESP8266).                  *
+//  - hour(), minute(), second() from TimeLib.                                             *
+//  - PROGMEM and friends, which are no-ops on the host.                                   *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - pgm_read_dword() and strcpy_P()                                         *
+//******************************************************************************************
+#ifndef COMPAT_H
+#define COMPAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <vector>
+
+#define PROGMEM
+#define PGM_P              const char*
+#define PSTR(s)            (s)
+#define F(s)               (s)
+#define pgm_read_byte(p)   (*(const uint8_t*)(p))
+#define pgm_read_dword(p)  (*(const uint32_t*)(p))
+#define memcpy_P           memcpy
+#define strlen_P           strlen
+#define strcpy_P           strcpy
+#define strcmp_P           strcmp
+#define strncmp_P          strncmp
+
+typedef uint8_t byte ;
+
+//******************************************************************************************
+// Time functions as in TimeLib.  The time is seconds since 1970.                          *
+//******************************************************************************************
+inline int hour   ( time_t t ) { return ( t / 3600 ) % 24 ; }
+inline int minute ( time_t t ) { return ( t / 60 ) % 60 ; }
+inline int second ( time_t t ) { return t % 60 ; }
+
+
+//******************************************************************************************
+// Subset of the Arduino String class.  Like the ESP8266 core version, strings up to 11    *
+// characters are kept inside the object (SSO).  Longer strings are on the heap and grow   *
+// with realloc() when the string is extended.                                             *
+//******************************************************************************************
+class String
+{
+  public:
+    String ( const char* cstr = "" ) ;
+    String ( const String& str ) ;
+    String ( String&& str ) ;
+    explicit String ( char c ) ;
+    explicit String ( unsigned char value, unsigned char base = 10 ) ;
+    explicit String ( int value, unsigned char base = 10 ) ;
+    explicit String ( unsigned int value, unsigned char base = 10 ) ;
+    explicit String ( long value, unsigned char base = 10 ) ;
+    explicit String ( unsigned long value, unsigned char base = 10 ) ;
+    ~String() ;
+
+    String&      operator = ( const String& rhs ) ;
+    String&      operator = ( String&& rhs ) ;
+    String&      operator = ( const char* cstr ) ;
+    String&      operator += ( const String& rhs )  { concat ( rhs.buffer(), rhs.len() ) ; return *this ; }
+    String&      operator += ( const char* cstr )   { concat ( cstr, strlen ( cstr ) ) ; return *this ; }
+    String&      operator += ( char c )             { concat ( &c, 1 ) ; return *this ; }
+    bool         operator == ( const String& rhs ) const { return equals ( rhs.c_str() ) ; }
+    bool         operator == ( const char* cstr ) const  { return equals ( cstr ) ; }
+    bool         operator != ( const String& rhs ) const { return ! equals ( rhs.c_str() ) ; }
+    bool         operator != ( const char* cstr ) const  { return ! equals ( cstr ) ; }
+    char         operator [] ( unsigned int index ) const ;
+    friend String operator + ( const String& lhs, const String& rhs ) ;
+    friend String operator + ( const String& lhs, const char* rhs ) ;
+
+    bool         reserve ( unsigned int size ) ;
+    bool         concat ( const char* cstr, unsigned int length ) ;
+    const char*  c_str() const                      { return buffer() ; }
+    unsigned int length() const                     { return len() ; }
+    bool         equals ( const char* cstr ) const ;
+    bool         equalsIgnoreCase ( const String& s ) const ;
+    bool         startsWith ( const char* prefix ) const ;
+    bool         endsWith ( const char* suffix ) const ;
+    bool         endsWith ( const String& suffix ) const { return endsWith ( suffix.c_str() ) ; }
+    char         charAt ( unsigned int index ) const { return (*this)[index] ; }
+    int          indexOf ( char c, unsigned int from = 0 ) const ;
+    int          indexOf ( const char* s, unsigned int from = 0 ) const ;
+    String       substring ( unsigned int from ) const { return substring ( from, len() ) ; }
+    String       substring ( unsigned int from, unsigned int to ) const ;
+    void         trim() ;
+    void         toLowerCase() ;
+    long         toInt() const ;
+
+  private:
+    static const unsigned int SSOSIZE = 11 ;         // Internal buffer, as in the ESP8266 core
+    struct ptr_t                                     // String on the heap
+    {
+      char*      buff ;
+      uint16_t   cap ;
+      uint16_t   len ;
+    } ;
+    struct sso_t                                     // Short string in the object itself
+    {
+      char       buff[SSOSIZE] ;
+      uint8_t    pad[sizeof(ptr_t) - SSOSIZE - 1] ;
+      uint8_t    len   : 7 ;
+      uint8_t    isHeap : 1 ;
+    } ;
+    union
+    {
+      ptr_t      ptr ;
+      sso_t      sso = {} ;
+    } ;
+    bool         isSSO() const                      { return ! sso.isHeap ; }
+    char*        buffer()                           { return isSSO() ? sso.buff : ptr.buff ; }
+    const char*  buffer() const                     { return isSSO() ? sso.buff : ptr.buff ; }
+    unsigned int capacity() const                   { return isSSO() ? SSOSIZE - 1 : ptr.cap ; }
+    unsigned int len() const                        { return isSSO() ? sso.len : ptr.len ; }
+    void         setLen ( unsigned int n )          { if ( isSSO() ) sso.len = n ; else ptr.len = n ; }
+    void         setSSO()                           { sso = sso_t() ; }
+    void         setHeap ( char* buf, unsigned int cap, unsigned int n )
+                 { ptr.buff = buf ; ptr.cap = cap ; ptr.len = n ; sso.isHeap = 1 ; }
+    void         copy ( const char* cstr, unsigned int length ) ;
+    void         invalidate() ;
+} ;
+
+#endif
@@ -0,0 +1,655 @@
+//******************************************************************************************
+// hal_native.cpp - Hardware abstraction layer, implementation for a Linux host.          *
+//******************************************************************************************
+// All files are kept in a host directory, given by the environment variable AQ_HOST_DIR.  *
+// Without it a new temporary directory is made.  The directory holds:                     *
+//  - fs/          the "LittleFS".  Filled from AQ_DATA_DIR (default "data") if empty.      *
+//  - eeprom.bin   the "EEPROM", only read to import old settings.                         *
+//  - pwm.trace    a line "<millis> <lamp> <value>" for every PWM output change.           *
+// There is no WiFi; the webserver listens on localhost (see native/webserver.h).          *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Index changed only after the file was removed or renamed               *
+// 17-10-2026, AG - File system asked for a hash that is shared in the index               *
+// 17-10-2026, AG - Files that stay open, in a table of HAL_FS_FILES as on the ESP         *
+//******************************************************************************************
+#include "hal_native.h"
+#include "alloccount.h"
+#include "fsindex.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+static std::mutex     syslock ;                               // Serializes SYS and loop
+static char           hostdir[256] ;                          // Root of host files
+static FILE*          pwmtrace ;                              // Trace of PWM output
+static uint8_t*       eeprom ;                                // RAM shadow of EEPROM
+static size_t         eepromsize ;                            // Size of EEPROM
+static bool           console = true ;                        // Console output enabled
+static uint32_t       (*freeheap)() ;                         // Heap model, if any
+static std::chrono::steady_clock::time_point t0 =             // Start time
+                      std::chrono::steady_clock::now() ;
+
+
+void hal_sys_lock()
+{
+  syslock.lock() ;
+}
+
+
+void hal_sys_unlock()
+{
+  syslock.unlock() ;
+}
+
+
+//******************************************************************************************
+//                              H A L _ H O S T _ D I R                                    *
+//******************************************************************************************
+// Return the host directory.  Create it the first time.                                   *
+//******************************************************************************************
+const char* hal_host_dir()
+{
+  const char* env ;
+
+  if ( *hostdir == '\0' )
+  {
+    env = getenv ( "AQ_HOST_DIR" ) ;
+    if ( env )
+    {
+      snprintf ( hostdir, sizeof(hostdir), "%s", env ) ;
+      mkdir ( hostdir, 0755 ) ;
+    }
+    else
+    {
+      snprintf ( hostdir, sizeof(hostdir), "/tmp/aqled-XXXXXX" ) ;
+      if ( mkdtemp ( hostdir ) == nullptr )
+      {
+        perror ( "mkdtemp" ) ;
+        exit ( 1 ) ;
+      }
+    }
+  }
+  return hostdir ;
+}
+
+
+//******************************************************************************************
+// Map a LittleFS path like "/index.html" to a host path.                                  *
+//******************************************************************************************
+const char* hal_fs_path ( const char* path, char* buf, size_t len )
+{
+  while ( *path == '/' )
+  {
+    path++ ;
+  }
+  snprintf ( buf, len, "%s/fs/%s", hal_host_dir(), path ) ;
+  return buf ;
+}
+
+
+//******************************************************************************************
+//                      C O N S O L E ,   T I M I N G   A N D   S Y S T E M                *
+//******************************************************************************************
+void hal_begin()
+{
+  setvbuf ( stdout, nullptr, _IOLBF, 0 ) ;
+  printf ( "\nHost files in %s\n", hal_host_dir() ) ;
+}
+
+
+void hal_console ( const char* line )
+{
+  if ( console )
+  {
+    puts ( line ) ;
+  }
+}
+
+
+void hal_console_enable ( bool on )
+{
+  console = on ;
+}
+
+
+uint32_t hal_millis()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>
+         ( std::chrono::steady_clock::now() - t0 ).count() ;
+}
+
+
+void hal_delay ( uint32_t ms )
+{
+  std::this_thread::sleep_for ( std::chrono::milliseconds ( ms ) ) ;
+}
+
+
+//******************************************************************************************
+// The 1 second timer runs in a thread of its own, but holds the SYS lock while the        *
+// callback runs, like the Ticker on the ESP8266.                                          *
+//******************************************************************************************
+void hal_timer_1sec ( void (*cb)() )
+{
+  std::thread ( [cb]()
+  {
+    auto next = std::chrono::steady_clock::now() ;
+    while ( true )
+    {
+      next += std::chrono::seconds ( 1 ) ;
+      std::this_thread::sleep_until ( next ) ;
+      SysLock lock ;
+      cb() ;
+    }
+  } ).detach() ;
+}
+
+
+//******************************************************************************************
+// The host has no meaningful heap limit.  Report the free heap of a freshly started       *
+// ESP8266, so heap dependent code behaves as on the device.  A harness with a model of    *
+// the ESP8266 heap can supply the real figure.                                            *
+//******************************************************************************************
+uint32_t hal_free_heap()
+{
+  return freeheap ? freeheap() : 45000 ;
+}
+
+
+void hal_set_free_heap ( uint32_t (*fn)() )
+{
+  freeheap = fn ;
+}
+
+
+void hal_reset()
+{
+  printf ( "Reset requested, exit\n" ) ;
+  exit ( 0 ) ;
+}
+
+
+//******************************************************************************************
+//                                   O U T P U T S                                         *
+//******************************************************************************************
+void hal_pwm_begin ( uint16_t range )
+{
+  char path[300] ;
+
+  snprintf ( path, sizeof(path), "%s/pwm.trace", hal_host_dir() ) ;
+  pwmtrace = fopen ( path, "a" ) ;
+  if ( pwmtrace )
+  {
+    fprintf ( pwmtrace, "%u range %d\n", hal_millis(), range ) ;
+  }
+}
+
+
+void hal_pwm_write ( uint8_t lamp, uint8_t value )
+{
+  if ( pwmtrace )
+  {
+    fprintf ( pwmtrace, "%u %c %d\n", hal_millis(), 'A' + lamp, value ) ;
+    fflush ( pwmtrace ) ;
+  }
+}
+
+
+void hal_led ( bool on )
+{
+}
+
+
+//******************************************************************************************
+//                                    E E P R O M                                          *
+//******************************************************************************************
+static const char* eeprom_path()
+{
+  static char path[300] ;
+
+  snprintf ( path, sizeof(path), "%s/eeprom.bin", hal_host_dir() ) ;
+  return path ;
+}
+
+
+void hal_eeprom_begin ( size_t size )
+{
+  int fd ;
+
+  eeprom = (uint8_t*)realloc ( eeprom, size ) ;               // RAM shadow, on the heap
+  eepromsize = size ;
+  memset ( eeprom, 0xFF, size ) ;                             // Erased flash
+  if ( ( fd = open ( eeprom_path(), O_RDONLY ) ) >= 0 )
+  {
+    read ( fd, eeprom, size ) ;
+    close ( fd ) ;
+  }
+}
+
+
+void hal_eeprom_read ( size_t addr, void* data, size_t len )
+{
+  if ( addr + len <= eepromsize )
+  {
+    memcpy ( data, eeprom + addr, len ) ;
+  }
+}
+
+
+void hal_eeprom_end()
+{
+  free ( eeprom ) ;                                           // Free RAM shadow
+  eeprom = nullptr ;
+  eepromsize = 0 ;
+}
+
+
+//******************************************************************************************
+//                                F I L E S Y S T E M                                      *
+//******************************************************************************************
+// The "LittleFS" is a flat directory, like the root of the LittleFS on the device.        *
+//******************************************************************************************
+bool hal_fs_begin()
+{
+  char        fsdir[300] ;
+  char        src[600] ;
+  char        dst[600] ;
+  const char* datadir ;
+  DIR*        dir ;
+  DIR*        sdir ;
+  dirent*     de ;
+  bool        empty = true ;
+
+  snprintf ( fsdir, sizeof(fsdir), "%s/fs", hal_host_dir() ) ;
+  mkdir ( fsdir, 0755 ) ;
+  if ( ( dir = opendir ( fsdir ) ) == nullptr )
+  {
+    return false ;
+  }
+  while ( ( de = readdir ( dir ) ) )
+  {
+    if ( *de->d_name != '.' )
+    {
+      empty = false ;
+    }
+  }
+  closedir ( dir ) ;
+  datadir = getenv ( "AQ_DATA_DIR" ) ;
+  if ( datadir == nullptr )
+  {
+    datadir = "data" ;
+  }
+  if ( empty && ( sdir = opendir ( datadir ) ) )              // Fill like "Upload FS image"
+  {
+    while ( ( de = readdir ( sdir ) ) )
+    {
+      FILE*  in ;
+      FILE*  out ;
+      char   buf[4096] ;
+      size_t n ;
+      if ( *de->d_name == '.' )
+      {
+        continue ;
+      }
+      snprintf ( src, sizeof(src), "%s/%s", datadir, de->d_name ) ;
+      snprintf ( dst, sizeof(dst), "%s/%s", fsdir, de->d_name ) ;
+      if ( ( in = fopen ( src, "rb" ) ) == nullptr )
+      {
+        continue ;
+      }
+      if ( ( out = fopen ( dst, "wb" ) ) )
+      {
+        while ( ( n = fread ( buf, 1, sizeof(buf), in ) ) > 0 )
+        {
+          fwrite ( buf, 1, n, out ) ;
+        }
+        fclose ( out ) ;
+      }
+      fclose ( in ) ;
+    }
+    closedir ( sdir ) ;
+  }
+  fsindex_clear() ;                                           // Fill the index, once
+  hal_fs_list ( []( const char* name, size_t size ) { fsindex_add ( name, size ) ; } ) ;
+  return true ;
+}
+
+
+void hal_fs_info ( size_t* total, size_t* used )
+{
+  char        fsdir[300] ;
+  char        path[600] ;
+  DIR*        dir ;
+  dirent*     de ;
+  struct stat st ;
+
+  *total = 1024 * 1024 - 8192 ;                               // Like eagle.flash.4m1m.ld
+  *used = 0 ;
+  snprintf ( fsdir, sizeof(fsdir), "%s/fs", hal_host_dir() ) ;
+  if ( ( dir = opendir ( fsdir ) ) )
+  {
+    while ( ( de = readdir ( dir ) ) )
+    {
+      snprintf ( path, sizeof(path), "%s/%s", fsdir, de->d_name ) ;
+      if ( ( *de->d_name != '.' ) && ( stat ( path, &st ) == 0 ) )
+      {
+        *used += ( st.st_size + 4095 ) & ~4095 ;              // Blocks of 4 kB
+      }
+    }
+    closedir ( dir ) ;
+  }
+}
+
+
+void hal_fs_list ( void (*cb)( const char* name, size_t size ) )
+{
+  char        fsdir[300] ;
+  char        path[600] ;
+  DIR*        dir ;
+  dirent*     de ;
+  struct stat st ;
+
+  snprintf ( fsdir, sizeof(fsdir), "%s/fs", hal_host_dir() ) ;
+  if ( ( dir = opendir ( fsdir ) ) )
+  {
+    while ( ( de = readdir ( dir ) ) )
+    {
+      snprintf ( path, sizeof(path), "%s/%s", fsdir, de->d_name ) ;
+      if ( ( *de->d_name != '.' ) && ( stat ( path, &st ) == 0 ) && S_ISREG ( st.st_mode ) )
+      {
+        cb ( de->d_name, st.st_size ) ;
+      }
+    }
+    closedir ( dir ) ;
+  }
+}
+
+
+//******************************************************************************************
+// Send a file.  Like ESPAsyncWebServer, "name.gz" is sent if "name" does not exist.       *
+//******************************************************************************************
+void hal_fs_send ( AsyncWebServerRequest* request, const char* path,
+                   const char* contenttype )
+{
+  AllocScope              scope ( ALLOC_WEB ) ;           // Count as webserver
+  char                    hpath[600] ;
+  struct stat             st ;
+  AsyncWebServerResponse* response ;
+
+  hal_fs_path ( path, hpath, sizeof(hpath) - 3 ) ;
+  if ( stat ( hpath, &st ) == 0 )
+  {
+    request->send ( new AsyncFileResponse ( hpath, contenttype ) ) ;
+    return ;
+  }
+  strcat ( hpath, ".gz" ) ;
+  if ( stat ( hpath, &st ) == 0 )
+  {
+    response = new AsyncFileResponse ( hpath, contenttype ) ;
+    response->addHeader ( "Content-Encoding", "gzip" ) ;
+    request->send ( response ) ;
+    return ;
+  }
+  request->send ( 404 ) ;
+}
+
+
+AsyncWebServerResponse* hal_fs_response ( AsyncWebServerRequest* request, const char* path,
+                                          const char* contenttype )
+{
+  AllocScope  scope ( ALLOC_WEB ) ;                           // Count as webserver
+  char        hpath[300] ;
+
+  if ( ! hal_fs_exists ( path ) )
+  {
+    return nullptr ;
+  }
+  return new AsyncFileResponse ( hal_fs_path ( path, hpath, sizeof(hpath) ), contenttype ) ;
+}
+
+
+//******************************************************************************************
+// True if the hash of path is in the index for another file, so path gets a shared entry  *
+// when it is created.  To be called before the write or rename that creates it.           *
+//******************************************************************************************
+static bool other_hash ( const char* path )
+{
+  char        hpath[300] ;
+  struct stat st ;
+
+  return ( fsindex_find ( path, nullptr ) == FSINDEX_YES ) &&
+         ( stat ( hal_fs_path ( path, hpath, sizeof(hpath) ), &st ) != 0 ) ;
+}
+
+
+bool hal_fs_exists ( const char* path )
+{
+  char        hpath[300] ;
+  struct stat st ;
+  fsfind_t    found = fsindex_find ( path, nullptr ) ;
+
+  if ( found == FSINDEX_YES )
+  {
+    return true ;
+  }
+  if ( ( found == FSINDEX_NO ) && fsindex_complete() )
+  {
+    return false ;
+  }
+  return stat ( hal_fs_path ( path, hpath, sizeof(hpath) ), &st ) == 0 ;  // Shared hash
+}
+
+
+long hal_fs_size ( const char* path )
+{
+  char        hpath[300] ;
+  struct stat st ;
+  uint32_t    size ;
+  fsfind_t    found = fsindex_find ( path, &size ) ;
+
+  if ( found == FSINDEX_YES )
+  {
+    return size ;
+  }
+  if ( ( ( found == FSINDEX_NO ) && fsindex_complete() ) ||
+       ( stat ( hal_fs_path ( path, hpath, sizeof(hpath) ), &st ) != 0 ) )
+  {
+    return -1 ;
+  }
+  return st.st_size ;
+}
+
+
+size_t hal_fs_read ( const char* path, size_t offset, void* data, size_t len )
+{
+  char    hpath[300] ;
+  int     fd ;
+  ssize_t n ;
+
+  if ( ! hal_fs_exists ( path ) ||                            // No need to try a missing file
+       ( ( fd = open ( hal_fs_path ( path, hpath, sizeof(hpath) ), O_RDONLY ) ) < 0 ) )
+  {
+    return 0 ;
+  }
+  n = pread ( fd, data, len, offset ) ;
+  close ( fd ) ;
+  return n > 0 ? n : 0 ;
+}
+
+
+//******************************************************************************************
+// Files that stay open.  The file number is the index in files[], as on the ESP8266, so   *
+// the number of open files is limited the same way.                                       *
+//******************************************************************************************
+static int files[HAL_FS_FILES] ;                              // File descriptor + 1, 0 if
+                                                              // free
+
+int hal_fs_open ( const char* path )
+{
+  char hpath[300] ;
+  int  i ;
+  int  fd ;
+
+  for ( i = 0 ; ( i < HAL_FS_FILES ) && files[i] ; i++ ) ;   // Find a free one
+  if ( ( i == HAL_FS_FILES ) || ! hal_fs_exists ( path ) ||
+       ( ( fd = open ( hal_fs_path ( path, hpath, sizeof(hpath) ), O_RDONLY ) ) < 0 ) )
+  {
+    return -1 ;
+  }
+  files[i] = fd + 1 ;
+  return i ;
+}
+
+
+size_t hal_fs_pread ( int file, size_t offset, void* data, size_t len )
+{
+  ssize_t n ;
+
+  if ( ( file < 0 ) || ( file >= HAL_FS_FILES ) || ( files[file] == 0 ) )
+  {
+    return 0 ;
+  }
+  n = pread ( files[file] - 1, data, len, offset ) ;
+  return n > 0 ? n : 0 ;
+}
+
+
+void hal_fs_close ( int file )
+{
+  if ( ( file >= 0 ) && ( file < HAL_FS_FILES ) && files[file] )
+  {
+    close ( files[file] - 1 ) ;
+    files[file] = 0 ;
+  }
+}
+
+
+bool hal_fs_write ( const char* path, const void* data, size_t len, bool append )
+{
+  char        hpath[300] ;
+  int         fd ;
+  ssize_t     n ;
+  struct stat st ;
+  bool        other = other_hash ( path ) ;                   // Before open() creates it
+
+  if ( ( fd = open ( hal_fs_path ( path, hpath, sizeof(hpath) ),
+                     O_WRONLY | O_CREAT | ( append ? O_APPEND : O_TRUNC ), 0644 ) ) < 0 )
+  {
+    return false ;
+  }
+  n = write ( fd, data, len ) ;
+  if ( fstat ( fd, &st ) == 0 )                               // Keep index current
+  {
+    if ( other )
+    {
+      fsindex_add ( path, st.st_size ) ;
+    }
+    else
+    {
+      fsindex_set ( path, st.st_size ) ;
+    }
+  }
+  close ( fd ) ;
+  return n == (ssize_t)len ;
+}
+
+
+bool hal_fs_rename ( const char* from, const char* to )
+{
+  char        hfrom[300] ;
+  char        hto[300] ;
+  uint32_t    size = 0 ;
+  struct stat st ;
+  fsfind_t    found = fsindex_find ( from, &size ) ;
+  bool        other = other_hash ( to ) ;                     // Before "to" is replaced
+
+  if ( rename ( hal_fs_path ( from, hfrom, sizeof(hfrom) ),
+                hal_fs_path ( to, hto, sizeof(hto) ) ) != 0 )
+  {
+    return false ;
+  }
+  if ( found == FSINDEX_YES )                                 // Keep index current
+  {
+    fsindex_remove ( from ) ;
+  }
+  else if ( stat ( hto, &st ) == 0 )                          // Shared or not indexed, size
+  {                                                           // from the file system
+    size = st.st_size ;
+  }
+  if ( other )
+  {
+    fsindex_add ( to, size ) ;
+  }
+  else
+  {
+    fsindex_set ( to, size ) ;
+  }
+  return true ;
+}
+
+
+bool hal_fs_remove ( const char* path )
+{
+  char hpath[300] ;
+
+  if ( unlink ( hal_fs_path ( path, hpath, sizeof(hpath) ) ) != 0 )
+  {
+    return false ;                                            // File is still there
+  }
+  fsindex_remove ( path ) ;                                   // Keep index current
+  return true ;
+}
+
+
+//******************************************************************************************
+//                          N E T W O R K   A N D   T I M E                                *
+//******************************************************************************************
+// No WiFi, mDNS or OTA on the host.  The time is the local time of the host.              *
+//******************************************************************************************
+void hal_wifi_begin ( const char* hostname )
+{
+  dbgprint ( "Host build, no WiFi needed" ) ;
+}
+
+
+int hal_wifi_rssi()
+{
+  return -50 ;                                                // A good signal
+}
+
+
+void hal_ota_begin ( const char* hostname, void (*onstart)() )
+{
+}
+
+
+void hal_ntp_begin()
+{
+}
+
+
+bool hal_ntp_update()
+{
+  return true ;
+}
+
+
+time_t hal_ntp_localtime()
+{
+  AllocScope scope ( ALLOC_SYS ) ;                            // glibc loads the timezone
+  time_t     t = time ( nullptr ) ;
+  struct tm  tm ;
+
+  localtime_r ( &t, &tm ) ;
+  return t + tm.tm_gmtoff ;
+}
+
+
+void hal_net_loop()
+{
+}
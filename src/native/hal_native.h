@@ -0,0 +1,50 @@
+//******************************************************************************************
+// hal_native.h - Extra functions of the host (Linux) HAL, not part of hal.h.             *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+#include "hal.h"
+
+// The SYS lock serializes loop(), the 1 second ticker and the webserver callbacks, like the
+// single core of the ESP8266 does.
+void        hal_sys_lock() ;
+void        hal_sys_unlock() ;
+
+struct SysLock                                                // Holds the SYS lock in a scope
+{
+  SysLock()                                    { hal_sys_lock() ; }
+  ~SysLock()                                   { hal_sys_unlock() ; }
+} ;
+
+void        hal_console_enable ( bool on ) ;                  // Console output on/off
+void        hal_set_free_heap ( uint32_t (*fn)() ) ;          // Source for hal_free_heap()
+const char* hal_host_dir() ;                                  // Root of the host files
+const char* hal_fs_path ( const char* path, char* buf,        // Map LittleFS path to host path
+                          size_t len ) ;
+
+// All heap allocations of the process go through native/alloc_native.cpp.  It counts them
+// per subsystem (alloccount.h) and in total.  A harness can put a model of the ESP8266 heap
+// in place of glibc.
+struct hal_alloc_t                                            // Totals, all threads
+{
+  uint64_t    allocs ;                                        // Number of malloc/realloc
+  uint64_t    bytes ;                                         // Bytes requested
+  uint64_t    frees ;                                         // Number of free
+} ;
+
+struct hal_heap_t                                             // Replacement heap
+{
+  void*       (*malloc) ( size_t size ) ;
+  void*       (*realloc) ( void* ptr, size_t size ) ;
+  void        (*free) ( void* ptr ) ;
+  bool        (*owns) ( const void* ptr ) ;                   // Block is from this heap
+} ;
+
+extern hal_alloc_t hal_alloc ;
+void        hal_set_heap ( const hal_heap_t* heap ) ;         // Install replacement heap
+void        hal_use_heap ( bool on ) ;                        // New allocations from it
+
+#endif
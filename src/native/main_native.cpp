@@ -0,0 +1,29 @@
+//******************************************************************************************
+// main_native.cpp - Entry point for the host (Linux) build.                              *
+//******************************************************************************************
+// Runs setup() once and then loop() forever, like the Arduino core does.  Each loop() runs *
+// under the SYS lock, so it never overlaps with a webserver callback or the ticker.       *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "hal_native.h"
+
+void setup() ;
+void loop() ;
+
+int main ( int argc, char* argv[] )
+{
+  {
+    SysLock lock ;
+    setup() ;
+  }
+  while ( true )
+  {
+    {
+      SysLock lock ;
+      loop() ;
+    }
+    hal_delay ( 1 ) ;                                         // Give SYS a chance
+  }
+  return 0 ;
+}
@@ -0,0 +1,1134 @@
+//******************************************************************************************
+// webserver.cpp - Subset of ESPAsyncWebServer for the host (Linux) build.                *
+//******************************************************************************************
+// One thread runs a poll() loop over the listening socket and all open connections.       *
+// Request parsing follows ESPAsyncWebServer: the URL and the query parameters are         *
+// urldecoded, an urlencoded POST body is added to the parameters, any other body is       *
+// passed to the body handler of the matching route while it arrives.                      *
+//******************************************************************************************
+// Allocations of the server itself count for the subsystem "web" (see alloccount.h), also *
+// when a handler of the firmware calls it.                                                *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - One disconnect handler per request, as in the library                  *
+// 17-10-2026, AG - Filler asked again after 500 msec, like the TCP poll                   *
+// 17-10-2026, AG - AsyncClient::close(), the connection is closed by the server thread    *
+//******************************************************************************************
+#include "webserver.h"
+#include "hal_native.h"
+#include "alloccount.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <algorithm>
+#include <arpa/inet.h>
+
+#define MAXHEAD     8192                                      // Max size of request head
+#define RXTIMEOUT   3000                                      // Max idle time while receiving
+#define SEGSIZE     1460                                      // Size of one body part (TCP MSS)
+#define POLLTIME     500                                      // Retry of a filler without data
+
+struct AsyncWebServer::Conn
+{
+  int                    fd ;                                 // Socket of this connection
+  enum { HEAD, BODY, RESPOND } state = HEAD ;                 // Parsing state
+  std::vector<uint8_t>   in ;                                 // Received, not yet processed
+  AsyncWebServerRequest* request = nullptr ;                  // Request being handled
+  const Handler*         handler = nullptr ;                  // Matching route, if any
+  bool                   isForm = false ;                     // Body is urlencoded form
+  String                 form ;                               // Collected form body
+  size_t                 bodyIndex = 0 ;                      // Body bytes received so far
+  std::vector<uint8_t>   out ;                                // Output not yet written
+  size_t                 outPos = 0 ;                         // Written part of out
+  bool                   headSent = false ;                   // Response head is in out
+  bool                   finished = false ;                   // Last byte is in out
+  bool                   tryAgain = false ;                   // Filler had no data yet
+  uint32_t               lastTry ;                            // Time of that fill()
+  uint32_t               lastRx ;                             // Time of last received data
+} ;
+
+
+//******************************************************************************************
+//                                  U R L D E C O D E                                      *
+//******************************************************************************************
+static String urldecode ( const char* p, size_t len )
+{
+  String res ;
+  char   hex[3] = { 0, 0, 0 } ;
+
+  res.reserve ( len ) ;
+  while ( len-- )
+  {
+    char c = *p++ ;
+    if ( ( c == '%' ) && ( len >= 2 ) )
+    {
+      hex[0] = *p++ ;
+      hex[1] = *p++ ;
+      len -= 2 ;
+      c = (char)strtol ( hex, nullptr, 16 ) ;
+    }
+    else if ( c == '+' )
+    {
+      c = ' ' ;
+    }
+    res += c ;
+  }
+  return res ;
+}
+
+
+//******************************************************************************************
+// Split "a=1&b=2" into parameters.                                                        *
+//******************************************************************************************
+static void addParams ( std::vector<AsyncWebParameter*>& params, const char* p,
+                        size_t len, bool form )
+{
+  const char* end = p + len ;
+
+  while ( p < end )
+  {
+    const char* amp = (const char*)memchr ( p, '&', end - p ) ;
+    const char* eq ;
+    if ( amp == nullptr )
+    {
+      amp = end ;
+    }
+    eq = (const char*)memchr ( p, '=', amp - p ) ;
+    if ( amp > p )
+    {
+      if ( eq )
+      {
+        params.push_back ( new AsyncWebParameter ( urldecode ( p, eq - p ),
+                                                   urldecode ( eq + 1, amp - eq - 1 ),
+                                                   form ) ) ;
+      }
+      else
+      {
+        params.push_back ( new AsyncWebParameter ( urldecode ( p, amp - p ), "",
+                                                   form ) ) ;
+      }
+    }
+    p = amp + 1 ;
+  }
+}
+
+
+//******************************************************************************************
+//                                  R E S P O N S E S                                      *
+//******************************************************************************************
+static const char* reason ( int code )
+{
+  switch ( code )
+  {
+    case 200 : return "OK" ;
+    case 204 : return "No Content" ;
+    case 206 : return "Partial Content" ;
+    case 301 : return "Moved Permanently" ;
+    case 302 : return "Found" ;
+    case 304 : return "Not Modified" ;
+    case 400 : return "Bad Request" ;
+    case 403 : return "Forbidden" ;
+    case 404 : return "Not Found" ;
+    case 405 : return "Method Not Allowed" ;
+    case 408 : return "Request Time-out" ;
+    case 409 : return "Conflict" ;
+    case 411 : return "Length Required" ;
+    case 412 : return "Precondition Failed" ;
+    case 413 : return "Request Entity Too Large" ;
+    case 415 : return "Unsupported Media Type" ;
+    case 422 : return "Unprocessable Entity" ;
+    case 429 : return "Too Many Requests" ;
+    case 500 : return "Internal Server Error" ;
+    case 501 : return "Not Implemented" ;
+    case 503 : return "Service Unavailable" ;
+  }
+  return "" ;
+}
+
+
+void AsyncWebServerResponse::addHeader ( const String& name, const String& value )
+{
+  AllocScope scope ( ALLOC_WEB ) ;
+
+  _headers.push_back ( AsyncWebHeader ( name, value ) ) ;
+}
+
+
+String AsyncWebServerResponse::head() const
+{
+  char   line[64] ;
+  String res ;
+
+  snprintf ( line, sizeof(line), "HTTP/1.1 %d %s\r\n", _code, reason ( _code ) ) ;
+  res = line ;
+  for ( const AsyncWebHeader& h : _headers )
+  {
+    res += h.name() ;
+    res += ": " ;
+    res += h.value() ;
+    res += "\r\n" ;
+  }
+  if ( _contentType.length() )
+  {
+    res += "Content-Type: " ;
+    res += _contentType ;
+    res += "\r\n" ;
+  }
+  if ( chunked() )
+  {
+    res += "Transfer-Encoding: chunked\r\n" ;
+  }
+  else
+  {
+    snprintf ( line, sizeof(line), "Content-Length: %zu\r\n", _contentLength ) ;
+    res += line ;
+  }
+  res += "Connection: close\r\n\r\n" ;
+  return res ;
+}
+
+
+AsyncBasicResponse::AsyncBasicResponse ( int code, const String& contentType,
+                                         const String& content )
+  : AsyncWebServerResponse ( code, contentType, content.length() ),
+    _content ( content )
+{
+  if ( _content.length() && ( _contentType.length() == 0 ) )
+  {
+    _contentType = "text/plain" ;
+  }
+}
+
+
+size_t AsyncBasicResponse::fill ( uint8_t* buf, size_t maxLen )
+{
+  size_t n = _contentLength - _index ;
+
+  if ( n > maxLen )
+  {
+    n = maxLen ;
+  }
+  memcpy ( buf, _content.c_str() + _index, n ) ;
+  _index += n ;
+  return n ;
+}
+
+
+AsyncProgmemResponse::AsyncProgmemResponse ( int code, const String& contentType,
+                                             const uint8_t* content, size_t len )
+  : AsyncWebServerResponse ( code, contentType, len ), _content ( content )
+{
+}
+
+
+size_t AsyncProgmemResponse::fill ( uint8_t* buf, size_t maxLen )
+{
+  size_t n = _contentLength - _index ;
+
+  if ( n > maxLen )
+  {
+    n = maxLen ;
+  }
+  memcpy ( buf, _content + _index, n ) ;
+  _index += n ;
+  return n ;
+}
+
+
+AsyncCallbackResponse::AsyncCallbackResponse ( const String& contentType, size_t len,
+                                               AwsResponseFiller callback )
+  : AsyncWebServerResponse ( 200, contentType, len ), _callback ( callback )
+{
+}
+
+
+size_t AsyncCallbackResponse::fill ( uint8_t* buf, size_t maxLen )
+{
+  size_t n ;
+
+  if ( ! chunked() )                                          // Known length?
+  {
+    if ( _index >= _contentLength )                           // Yes, all delivered?
+    {
+      return 0 ;
+    }
+    if ( maxLen > _contentLength - _index )
+    {
+      maxLen = _contentLength - _index ;
+    }
+  }
+  n = _callback ( buf, maxLen, _index ) ;
+  if ( n != RESPONSE_TRY_AGAIN )
+  {
+    _index += n ;
+  }
+  return n ;
+}
+
+
+AsyncFileResponse::AsyncFileResponse ( const char* hostpath, const String& contentType )
+  : AsyncWebServerResponse ( 200, contentType )
+{
+  _file = fopen ( hostpath, "rb" ) ;
+  if ( _file )
+  {
+    fseek ( _file, 0, SEEK_END ) ;
+    _contentLength = ftell ( _file ) ;
+    fseek ( _file, 0, SEEK_SET ) ;
+  }
+}
+
+
+AsyncFileResponse::~AsyncFileResponse()
+{
+  if ( _file )
+  {
+    fclose ( _file ) ;
+  }
+}
+
+
+size_t AsyncFileResponse::fill ( uint8_t* buf, size_t maxLen )
+{
+  if ( _file == nullptr )
+  {
+    return 0 ;
+  }
+  return fread ( buf, 1, maxLen, _file ) ;
+}
+
+
+//******************************************************************************************
+//                                   R E Q U E S T                                         *
+//******************************************************************************************
+AsyncWebServerRequest::AsyncWebServerRequest ( const char* url,
+                                               WebRequestMethodComposite method )
+  : _url ( url ), _method ( method )
+{
+}
+
+
+AsyncWebServerRequest::~AsyncWebServerRequest()
+{
+  for ( AsyncWebParameter* p : _params )
+  {
+    delete p ;
+  }
+  for ( AsyncWebHeader* h : _headers )
+  {
+    delete h ;
+  }
+  delete _response ;
+  free ( _tempObject ) ;                                      // Like ESPAsyncWebServer
+}
+
+
+const char* AsyncWebServerRequest::methodToString() const
+{
+  switch ( _method )
+  {
+    case HTTP_GET     : return "GET" ;
+    case HTTP_POST    : return "POST" ;
+    case HTTP_DELETE  : return "DELETE" ;
+    case HTTP_PUT     : return "PUT" ;
+    case HTTP_PATCH   : return "PATCH" ;
+    case HTTP_HEAD    : return "HEAD" ;
+    case HTTP_OPTIONS : return "OPTIONS" ;
+  }
+  return "UNKNOWN" ;
+}
+
+
+AsyncWebParameter* AsyncWebServerRequest::getParam ( size_t num ) const
+{
+  return num < _params.size() ? _params[num] : nullptr ;
+}
+
+
+AsyncWebParameter* AsyncWebServerRequest::getParam ( const String& name, bool post,
+                                                     bool file ) const
+{
+  for ( AsyncWebParameter* p : _params )
+  {
+    if ( ( p->name() == name ) && ( p->isPost() == post ) && ( p->isFile() == file ) )
+    {
+      return p ;
+    }
+  }
+  return nullptr ;
+}
+
+
+bool AsyncWebServerRequest::hasParam ( const String& name, bool post, bool file ) const
+{
+  return getParam ( name, post, file ) != nullptr ;
+}
+
+
+const String& AsyncWebServerRequest::arg ( const String& name ) const
+{
+  static const String empty ;
+
+  for ( AsyncWebParameter* p : _params )
+  {
+    if ( p->name() == name )
+    {
+      return p->value() ;
+    }
+  }
+  return empty ;
+}
+
+
+AsyncWebHeader* AsyncWebServerRequest::getHeader ( const String& name ) const
+{
+  for ( AsyncWebHeader* h : _headers )
+  {
+    if ( h->name().equalsIgnoreCase ( name ) )
+    {
+      return h ;
+    }
+  }
+  return nullptr ;
+}
+
+
+AsyncWebHeader* AsyncWebServerRequest::getHeader ( size_t num ) const
+{
+  return num < _headers.size() ? _headers[num] : nullptr ;
+}
+
+
+bool AsyncWebServerRequest::hasHeader ( const String& name ) const
+{
+  return getHeader ( name ) != nullptr ;
+}
+
+
+const String& AsyncWebServerRequest::header ( const char* name ) const
+{
+  AllocScope          scope ( ALLOC_WEB ) ;
+  static const String empty ;
+  AsyncWebHeader*     h = getHeader ( String ( name ) ) ;
+
+  return h ? h->value() : empty ;
+}
+
+
+void AsyncWebServerRequest::onDisconnect ( ArDisconnectHandler fn )
+{
+  AllocScope scope ( ALLOC_WEB ) ;
+
+  _onDisconnect = fn ;
+}
+
+
+//******************************************************************************************
+// Call the disconnect handler, as the server does when the connection is closed.          *
+//******************************************************************************************
+void AsyncWebServerRequest::disconnect()
+{
+  if ( _onDisconnect )
+  {
+    _onDisconnect() ;
+  }
+}
+
+
+void AsyncWebServerRequest::send ( AsyncWebServerResponse* response )
+{
+  if ( _response )                                            // Already answered?
+  {
+    delete response ;                                         // Yes, ignore
+    return ;
+  }
+  _response = response ;
+}
+
+
+void AsyncWebServerRequest::send ( int code, const String& contentType,
+                                   const String& content )
+{
+  send ( beginResponse ( code, contentType, content ) ) ;
+}
+
+
+void AsyncWebServerRequest::send_P ( int code, const String& contentType,
+                                     const uint8_t* content, size_t len )
+{
+  send ( beginResponse_P ( code, contentType, content, len ) ) ;
+}
+
+
+void AsyncWebServerRequest::send_P ( int code, const String& contentType,
+                                     PGM_P content )
+{
+  send_P ( code, contentType, (const uint8_t*)content, strlen ( content ) ) ;
+}
+
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse ( int code,
+                                                               const String& contentType,
+                                                               const String& content )
+{
+  AllocScope scope ( ALLOC_WEB ) ;
+
+  return new AsyncBasicResponse ( code, contentType, content ) ;
+}
+
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse_P ( int code,
+                                                                 const String& contentType,
+                                                                 const uint8_t* content,
+                                                                 size_t len )
+{
+  AllocScope scope ( ALLOC_WEB ) ;
+
+  return new AsyncProgmemResponse ( code, contentType, content, len ) ;
+}
+
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse ( const String& contentType,
+                                                               size_t len,
+                                                               AwsResponseFiller callback )
+{
+  AllocScope scope ( ALLOC_WEB ) ;
+
+  return new AsyncCallbackResponse ( contentType, len, callback ) ;
+}
+
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse (
+                                                 const String& contentType,
+                                                 AwsResponseFiller callback )
+{
+  AllocScope scope ( ALLOC_WEB ) ;
+
+  return new AsyncChunkedResponse ( contentType, callback ) ;
+}
+
+
+//******************************************************************************************
+// Helpers for harnesses on the host.                                                      *
+//******************************************************************************************
+void AsyncWebServerRequest::addParam ( const String& name, const String& value, bool post )
+{
+  _params.push_back ( new AsyncWebParameter ( name, value, post ) ) ;
+}
+
+
+void AsyncWebServerRequest::addHeader ( const String& name, const String& value )
+{
+  _headers.push_back ( new AsyncWebHeader ( name, value ) ) ;
+}
+
+
+void AsyncWebServerRequest::clearResponse()
+{
+  delete _response ;
+  _response = nullptr ;
+}
+
+
+//******************************************************************************************
+//                                     S E R V E R                                         *
+//******************************************************************************************
+// The port may be overruled by the environment variable AQ_HTTP_PORT.  Otherwise ports    *
+// below 1024 are moved up by 8000 (80 becomes 8080), so no root access is needed.         *
+//******************************************************************************************
+AsyncWebServer::AsyncWebServer ( uint16_t port )
+{
+  const char* env = getenv ( "AQ_HTTP_PORT" ) ;
+
+  if ( env )
+  {
+    port = atoi ( env ) ;
+  }
+  else if ( port && ( port < 1024 ) )
+  {
+    port += 8000 ;
+  }
+  _port = port ;
+}
+
+
+AsyncWebServer::~AsyncWebServer()
+{
+  end() ;
+}
+
+
+void AsyncWebServer::on ( const char* uri, ArRequestHandlerFunction onRequest )
+{
+  on ( uri, HTTP_ANY, onRequest ) ;
+}
+
+
+void AsyncWebServer::on ( const char* uri, WebRequestMethodComposite method,
+                          ArRequestHandlerFunction onRequest )
+{
+  _handlers.push_back ( { uri, method, onRequest, nullptr, nullptr } ) ;
+}
+
+
+void AsyncWebServer::on ( const char* uri, WebRequestMethodComposite method,
+                          ArRequestHandlerFunction onRequest,
+                          ArUploadHandlerFunction onUpload,
+                          ArBodyHandlerFunction onBody )
+{
+  _handlers.push_back ( { uri, method, onRequest, onBody, nullptr } ) ;
+}
+
+
+AsyncWebHandler& AsyncWebServer::addHandler ( AsyncWebHandler* handler )
+{
+  _handlers.push_back ( { String(), 0, nullptr, nullptr, handler } ) ;
+  return *handler ;
+}
+
+
+void AsyncWebServer::onNotFound ( ArRequestHandlerFunction fn )
+{
+  _notFound = fn ;
+}
+
+
+void AsyncWebServer::begin()
+{
+  struct sockaddr_in addr ;
+  socklen_t          alen = sizeof(addr) ;
+  int                one = 1 ;
+
+  _fd = socket ( AF_INET, SOCK_STREAM, 0 ) ;
+  setsockopt ( _fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one) ) ;
+  memset ( &addr, 0, sizeof(addr) ) ;
+  addr.sin_family = AF_INET ;
+  addr.sin_port = htons ( _port ) ;
+  addr.sin_addr.s_addr = htonl ( INADDR_LOOPBACK ) ;          // Only on localhost
+  if ( ( bind ( _fd, (struct sockaddr*)&addr, sizeof(addr) ) < 0 ) ||
+       ( listen ( _fd, 64 ) < 0 ) )
+  {
+    fprintf ( stderr, "HTTP server can not listen on port %d: %s\n",
+              _port, strerror ( errno ) ) ;
+    close ( _fd ) ;
+    _fd = -1 ;
+    return ;
+  }
+  getsockname ( _fd, (struct sockaddr*)&addr, &alen ) ;       // Port 0 gives a free port
+  _port = ntohs ( addr.sin_port ) ;
+  fcntl ( _fd, F_SETFL, O_NONBLOCK ) ;
+  _running = true ;
+  _thread = std::thread ( &AsyncWebServer::run, this ) ;
+}
+
+
+void AsyncWebServer::end()
+{
+  if ( _running )
+  {
+    _running = false ;
+    _thread.join() ;
+    while ( _conns.size() )
+    {
+      close_conn ( _conns.front() ) ;
+    }
+    close ( _fd ) ;
+    _fd = -1 ;
+  }
+}
+
+
+//******************************************************************************************
+// The network thread.                                                                     *
+//******************************************************************************************
+void AsyncWebServer::run()
+{
+  std::vector<struct pollfd> pfds ;
+  std::vector<Conn*>         polled ;
+  int                        timeout ;
+  uint32_t                   waited ;                         // Since fill() had no data
+
+  alloc_sub = ALLOC_WEB ;                                     // This thread is the server
+  while ( _running )
+  {
+    pfds.clear() ;
+    polled.clear() ;
+    pfds.push_back ( { _fd, POLLIN, 0 } ) ;
+    timeout = 100 ;
+    for ( Conn* c : _conns )
+    {
+      short events = ( c->state == Conn::RESPOND ) ? POLLOUT : POLLIN ;
+      if ( c->tryAgain )                                      // Waiting for data to send?
+      {
+        events = 0 ;                                          // Yes, retry at the next poll
+        waited = hal_millis() - c->lastTry ;
+        if ( waited >= POLLTIME )
+        {
+          timeout = 0 ;
+        }
+        else if ( (int)( POLLTIME - waited ) < timeout )
+        {
+          timeout = POLLTIME - waited ;
+        }
+      }
+      pfds.push_back ( { c->fd, events, 0 } ) ;
+      polled.push_back ( c ) ;
+    }
+    if ( poll ( pfds.data(), pfds.size(), timeout ) < 0 )
+    {
+      continue ;
+    }
+    if ( pfds[0].revents & POLLIN )
+    {
+      accept_conn() ;
+    }
+    for ( size_t i = 0 ; i < polled.size() ; i++ )
+    {
+      Conn* c = polled[i] ;
+      short ev = pfds[i + 1].revents ;
+      bool  keep = ! c->request->_client._closing ;           // Closed by the application?
+      if ( keep && ( c->state != Conn::RESPOND ) )
+      {
+        if ( ev & ( POLLIN | POLLHUP | POLLERR ) )
+        {
+          keep = handle_read ( c ) ;
+        }
+        else if ( hal_millis() - c->lastRx > RXTIMEOUT )      // Client too slow?
+        {
+          keep = false ;
+        }
+      }
+      if ( keep && ( c->state == Conn::RESPOND ) )
+      {
+        if ( ev & ( POLLHUP | POLLERR ) )
+        {
+          keep = false ;
+        }
+        else if ( c->tryAgain ? ( hal_millis() - c->lastTry >= POLLTIME )
+                              : ( ( ev & POLLOUT ) || ( c->headSent == false ) ) )
+        {
+          keep = handle_write ( c ) ;
+        }
+      }
+      if ( ! keep )
+      {
+        close_conn ( c ) ;
+      }
+    }
+  }
+}
+
+
+void AsyncWebServer::accept_conn()
+{
+  struct sockaddr_in addr ;
+  socklen_t          alen = sizeof(addr) ;
+  int                fd ;
+  int                one = 1 ;
+  Conn*              c ;
+
+  while ( ( fd = accept ( _fd, (struct sockaddr*)&addr, &alen ) ) >= 0 )
+  {
+    fcntl ( fd, F_SETFL, O_NONBLOCK ) ;
+    setsockopt ( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one) ) ;
+    c = new Conn ;
+    c->fd = fd ;
+    c->lastRx = hal_millis() ;
+    c->request = new AsyncWebServerRequest ;
+    c->request->_client._ip = addr.sin_addr.s_addr ;
+    c->request->_client._port = ntohs ( addr.sin_port ) ;
+    _conns.push_back ( c ) ;
+    alen = sizeof(addr) ;
+  }
+}
+
+
+void AsyncWebServer::close_conn ( Conn* c )
+{
+  close ( c->fd ) ;
+  {
+    SysLock lock ;
+    c->request->disconnect() ;
+    delete c->request ;
+  }
+  _conns.remove ( c ) ;
+  delete c ;
+}
+
+
+//******************************************************************************************
+// Read data from a connection.  Returns false if the connection has to be closed.         *
+//******************************************************************************************
+bool AsyncWebServer::handle_read ( Conn* c )
+{
+  uint8_t buf[SEGSIZE] ;
+  ssize_t n ;
+
+  n = recv ( c->fd, buf, sizeof(buf), 0 ) ;
+  if ( n < 0 )
+  {
+    return ( errno == EAGAIN ) || ( errno == EINTR ) ;
+  }
+  if ( n == 0 )                                               // Closed by client
+  {
+    return false ;
+  }
+  c->lastRx = hal_millis() ;
+  if ( c->state == Conn::BODY )
+  {
+    feed_body ( c, buf, n ) ;
+    return true ;
+  }
+  c->in.insert ( c->in.end(), buf, buf + n ) ;
+  if ( ! parse_head ( c ) )                                   // Complete head?
+  {
+    if ( c->in.size() > MAXHEAD )                             // No, too long?
+    {
+      return false ;
+    }
+    return true ;
+  }
+  start_body ( c ) ;
+  return true ;
+}
+
+
+//******************************************************************************************
+// Parse the request line and the headers if complete.                                     *
+//******************************************************************************************
+bool AsyncWebServer::parse_head ( Conn* c )
+{
+  AsyncWebServerRequest* r = c->request ;
+  const char*            p = (const char*)c->in.data() ;
+  const char*            end ;
+  const char*            eol ;
+  const char*            sp ;
+  const char*            q ;
+  size_t                 n = c->in.size() ;
+
+  end = (const char*)memmem ( p, n, "\r\n\r\n", 4 ) ;
+  if ( end == nullptr )
+  {
+    return false ;
+  }
+  // Request line: METHOD URI VERSION
+  eol = (const char*)memmem ( p, end - p + 2, "\r\n", 2 ) ;
+  sp = (const char*)memchr ( p, ' ', eol - p ) ;
+  if ( sp == nullptr )
+  {
+    sp = eol ;
+  }
+  struct { const char* name ; WebRequestMethod m ; } methods[] =
+    { { "GET", HTTP_GET }, { "POST", HTTP_POST }, { "DELETE", HTTP_DELETE },
+      { "PUT", HTTP_PUT }, { "PATCH", HTTP_PATCH }, { "HEAD", HTTP_HEAD },
+      { "OPTIONS", HTTP_OPTIONS } } ;
+  for ( auto& m : methods )
+  {
+    if ( ( strlen ( m.name ) == (size_t)( sp - p ) ) &&
+         ( strncmp ( p, m.name, sp - p ) == 0 ) )
+    {
+      r->_method = m.m ;
+    }
+  }
+  p = sp < eol ? sp + 1 : eol ;
+  sp = (const char*)memchr ( p, ' ', eol - p ) ;
+  if ( sp == nullptr )
+  {
+    sp = eol ;
+  }
+  q = (const char*)memchr ( p, '?', sp - p ) ;
+  if ( q )
+  {
+    r->_url = urldecode ( p, q - p ) ;
+    addParams ( r->_params, q + 1, sp - q - 1, false ) ;
+  }
+  else
+  {
+    r->_url = urldecode ( p, sp - p ) ;
+  }
+  // Headers
+  p = eol + 2 ;
+  while ( p < end + 2 )
+  {
+    const char* colon ;
+    const char* v ;
+    eol = (const char*)memmem ( p, end + 2 - p, "\r\n", 2 ) ;
+    colon = (const char*)memchr ( p, ':', eol - p ) ;
+    if ( colon )
+    {
+      v = colon + 1 ;
+      while ( ( v < eol ) && ( *v == ' ' ) )
+      {
+        v++ ;
+      }
+      String name ;
+      String value ;
+      name.concat ( p, colon - p ) ;
+      value.concat ( v, eol - v ) ;
+      r->_headers.push_back ( new AsyncWebHeader ( name, value ) ) ;
+      if ( name.equalsIgnoreCase ( "Content-Length" ) )
+      {
+        r->_contentLength = value.toInt() ;
+      }
+      else if ( name.equalsIgnoreCase ( "Content-Type" ) )
+      {
+        r->_contentType = value ;
+      }
+    }
+    p = eol + 2 ;
+  }
+  // Keep what is left, that is the start of the body
+  c->in.erase ( c->in.begin(), c->in.begin() + ( end + 4 - (const char*)c->in.data() ) ) ;
+  return true ;
+}
+
+
+//******************************************************************************************
+// Head is complete.  Find the route and process the part of the body already received.    *
+//******************************************************************************************
+void AsyncWebServer::start_body ( Conn* c )
+{
+  std::vector<uint8_t> rest ;
+
+  {
+    SysLock lock ;                                            // canHandle() is application
+    c->handler = find_handler ( c->request ) ;
+  }
+  c->isForm = c->request->_contentType.startsWith ( "application/x-www-form-urlencoded" ) ;
+  c->state = Conn::BODY ;
+  rest.swap ( c->in ) ;
+  if ( c->request->_contentLength == 0 )
+  {
+    dispatch ( c ) ;
+  }
+  else if ( rest.size() )
+  {
+    feed_body ( c, rest.data(), rest.size() ) ;
+  }
+}
+
+
+void AsyncWebServer::feed_body ( Conn* c, uint8_t* data, size_t len )
+{
+  AsyncWebServerRequest* r = c->request ;
+  size_t                 total = r->_contentLength ;
+
+  if ( len > total - c->bodyIndex )                           // Ignore extra data
+  {
+    len = total - c->bodyIndex ;
+  }
+  if ( c->isForm )
+  {
+    c->form.concat ( (const char*)data, len ) ;
+  }
+  else if ( c->handler && c->handler->custom )
+  {
+    SysLock lock ;
+    c->handler->custom->handleBody ( r, data, len, c->bodyIndex, total ) ;
+  }
+  else if ( c->handler && c->handler->onBody )
+  {
+    SysLock lock ;
+    c->handler->onBody ( r, data, len, c->bodyIndex, total ) ;
+  }
+  c->bodyIndex += len ;
+  if ( c->bodyIndex >= total )                                // Body complete?
+  {
+    if ( c->isForm )
+    {
+      addParams ( r->_params, c->form.c_str(), c->form.length(), true ) ;
+    }
+    dispatch ( c ) ;
+  }
+}
+
+
+const AsyncWebServer::Handler* AsyncWebServer::find_handler (
+                                                  AsyncWebServerRequest* request ) const
+{
+  const String& url = request->url() ;
+
+  for ( const Handler& h : _handlers )
+  {
+    if ( h.custom )
+    {
+      if ( h.custom->canHandle ( request ) )
+      {
+        return &h ;
+      }
+      continue ;
+    }
+    if ( ( h.method & request->method() ) == 0 )
+    {
+      continue ;
+    }
+    if ( ( url == h.uri ) || url.startsWith ( ( h.uri + "/" ).c_str() ) )
+    {
+      return &h ;
+    }
+    if ( h.uri.endsWith ( "*" ) &&
+         ( strncmp ( url.c_str(), h.uri.c_str(), h.uri.length() - 1 ) == 0 ) )
+    {
+      return &h ;
+    }
+  }
+  return nullptr ;
+}
+
+
+//******************************************************************************************
+// Call the handler of the request.                                                        *
+//******************************************************************************************
+void AsyncWebServer::dispatch ( Conn* c )
+{
+  AsyncWebServerRequest* r = c->request ;
+
+  c->state = Conn::RESPOND ;
+  SysLock lock ;
+  if ( c->handler && c->handler->custom )
+  {
+    c->handler->custom->handleRequest ( r ) ;
+  }
+  else if ( c->handler )
+  {
+    c->handler->onRequest ( r ) ;
+  }
+  else if ( _notFound )
+  {
+    _notFound ( r ) ;
+  }
+  else
+  {
+    r->send ( 404 ) ;
+  }
+  if ( r->_response == nullptr )                              // Handler did not answer?
+  {
+    r->send ( 500 ) ;
+  }
+  prime ( c ) ;
+}
+
+
+//******************************************************************************************
+// ESPAsyncWebServer starts sending inside send(): the head and the first part of the      *
+// body go to the TCP send buffer (2 segments) before the handler returns.  A handler may  *
+// rely on that and send a small body from a buffer that is reused later, so do the same.  *
+// Must be called with the SYS lock held.                                                  *
+//******************************************************************************************
+void AsyncWebServer::prime ( Conn* c )
+{
+  AsyncWebServerResponse* resp = c->request->_response ;
+  uint8_t                 buf[SEGSIZE] ;
+  size_t                  n ;
+
+  if ( resp->chunked() )                                      // Chunks are sent later
+  {
+    return ;
+  }
+  String head = resp->head() ;
+  c->out.assign ( head.c_str(), head.c_str() + head.length() ) ;
+  c->headSent = true ;
+  if ( c->request->method() == HTTP_HEAD )
+  {
+    c->finished = true ;
+    return ;
+  }
+  while ( c->out.size() < 2 * SEGSIZE )                       // Fill the send buffer
+  {
+    n = resp->fill ( buf, std::min ( sizeof(buf), 2 * SEGSIZE - c->out.size() ) ) ;
+    if ( n == RESPONSE_TRY_AGAIN )
+    {
+      break ;
+    }
+    if ( n == 0 )                                             // End of body
+    {
+      c->finished = true ;
+      break ;
+    }
+    c->out.insert ( c->out.end(), buf, buf + n ) ;
+  }
+}
+
+
+//******************************************************************************************
+// Write the response.  Returns false if the connection has to be closed.                  *
+//******************************************************************************************
+bool AsyncWebServer::handle_write ( Conn* c )
+{
+  AsyncWebServerResponse* resp = c->request->_response ;
+  uint8_t                 buf[SEGSIZE + 16] ;
+  uint8_t*                data = buf + 8 ;                    // Space for chunk length
+  size_t                  n ;
+  ssize_t                 w ;
+
+  c->tryAgain = false ;
+  while ( true )
+  {
+    if ( c->outPos < c->out.size() )                          // Output pending?
+    {
+      w = send ( c->fd, c->out.data() + c->outPos, c->out.size() - c->outPos,
+                 MSG_NOSIGNAL ) ;
+      if ( w < 0 )
+      {
+        return ( errno == EAGAIN ) || ( errno == EINTR ) ;
+      }
+      c->outPos += w ;
+      if ( c->outPos < c->out.size() )                        // Socket full?
+      {
+        return true ;
+      }
+    }
+    c->out.clear() ;
+    c->outPos = 0 ;
+    if ( c->finished )                                        // All sent?
+    {
+      return false ;                                          // Yes, close connection
+    }
+    if ( ! c->headSent )
+    {
+      String head = resp->head() ;
+      c->out.assign ( head.c_str(), head.c_str() + head.length() ) ;
+      c->headSent = true ;
+      if ( c->request->method() == HTTP_HEAD )
+      {
+        c->finished = true ;
+      }
+      continue ;
+    }
+    {
+      SysLock lock ;
+      n = resp->fill ( data, SEGSIZE ) ;                      // Get next part of body
+    }
+    if ( n == RESPONSE_TRY_AGAIN )                            // Data not yet available?
+    {
+      c->tryAgain = true ;                                    // Retry later
+      c->lastTry = hal_millis() ;
+      return true ;
+    }
+    if ( resp->chunked() )
+    {
+      char hdr[12] ;
+      int  hl = snprintf ( hdr, sizeof(hdr), "%zx\r\n", n ) ;
+      memcpy ( data - hl, hdr, hl ) ;
+      c->out.assign ( data - hl, data + n ) ;
+      c->out.push_back ( '\r' ) ;
+      c->out.push_back ( '\n' ) ;
+      if ( n == 0 )                                           // Last chunk?
+      {
+        c->finished = true ;
+      }
+    }
+    else
+    {
+      c->out.assign ( data, data + n ) ;
+      if ( n == 0 )
+      {
+        c->finished = true ;
+      }
+    }
+  }
+}
@@ -0,0 +1,329 @@
+//******************************************************************************************
+// webserver.h - Subset of ESPAsyncWebServer for the host (Linux) build.                  *
+//******************************************************************************************
+// The classes and methods have the same names and behaviour as in ESPAsyncWebServer, so  *
+// the request handlers in main.cpp compile unchanged for both platforms.                  *
+// The server runs in its own thread, a poll() loop that plays the role of the LWIP/SYS    *
+// context on the ESP8266.  All callbacks into the application (handlers, body handlers,   *
+// response fillers, disconnect handlers) run while holding the SYS lock, so they never    *
+// run at the same time as loop(), just like on the real hardware.                         *
+// Connections are closed after every response ("Connection: close"), as on the ESP.       *
+// A filler that returned RESPONSE_TRY_AGAIN is asked again after POLLTIME msec, like the  *
+// poll of the TCP stack.                                                                  *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - One disconnect handler per request, as in the library                  *
+// 17-10-2026, AG - Filler asked again after 500 msec, like the TCP poll                   *
+// 17-10-2026, AG - AsyncClient::close(), the connection is closed by the server thread    *
+//******************************************************************************************
+#ifndef WEBSERVER_H
+#define WEBSERVER_H
+
+#include "compat.h"
+#include <functional>
+#include <vector>
+#include <list>
+#include <thread>
+#include <atomic>
+
+typedef enum
+{
+  HTTP_GET     = 0b00000001,
+  HTTP_POST    = 0b00000010,
+  HTTP_DELETE  = 0b00000100,
+  HTTP_PUT     = 0b00001000,
+  HTTP_PATCH   = 0b00010000,
+  HTTP_HEAD    = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY     = 0b01111111,
+} WebRequestMethod ;
+typedef uint8_t WebRequestMethodComposite ;
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+class AsyncWebServerRequest ;
+class AsyncWebServerResponse ;
+class AsyncWebServer ;
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction ;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename,
+                           size_t index, uint8_t* data, size_t len,
+                           bool final)> ArUploadHandlerFunction ;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                           size_t index, size_t total)> ArBodyHandlerFunction ;
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen,
+                             size_t index)> AwsResponseFiller ;
+typedef std::function<void(void)> ArDisconnectHandler ;
+
+
+//******************************************************************************************
+// A parameter from the query string or from an urlencoded POST body.                      *
+//******************************************************************************************
+class AsyncWebParameter
+{
+  public:
+    AsyncWebParameter ( const String& name, const String& value, bool form = false )
+      : _name ( name ), _value ( value ), _isForm ( form ) {}
+    const String&   name() const                    { return _name ; }
+    const String&   value() const                   { return _value ; }
+    size_t          size() const                    { return _value.length() ; }
+    bool            isPost() const                  { return _isForm ; }
+    bool            isFile() const                  { return false ; }
+  private:
+    String          _name ;
+    String          _value ;
+    bool            _isForm ;
+} ;
+
+
+//******************************************************************************************
+// A request or response header.                                                           *
+//******************************************************************************************
+class AsyncWebHeader
+{
+  public:
+    AsyncWebHeader ( const String& name, const String& value )
+      : _name ( name ), _value ( value ) {}
+    const String&   name() const                    { return _name ; }
+    const String&   value() const                   { return _value ; }
+  private:
+    String          _name ;
+    String          _value ;
+} ;
+
+
+//******************************************************************************************
+// The remote side of a connection.  remoteIP() is in network order, like the uint32_t    *
+// conversion of IPAddress on the ESP8266.                                                 *
+//******************************************************************************************
+class AsyncClient
+{
+  public:
+    uint32_t        remoteIP() const                { return _ip ; }
+    uint16_t        remotePort() const              { return _port ; }
+    void            close ( bool now = false )      { _closing = true ; } // At next poll
+    uint32_t        _ip = 0 ;
+    uint16_t        _port = 0 ;
+    bool            _closing = false ;                                 // close() was called
+} ;
+
+
+//******************************************************************************************
+// Base class for all responses.  fill() delivers the next part of the body, 0 at the end  *
+// or RESPONSE_TRY_AGAIN if the data is not available yet.                                 *
+//******************************************************************************************
+class AsyncWebServerResponse
+{
+  public:
+    AsyncWebServerResponse ( int code, const String& contentType, size_t length = 0 )
+      : _code ( code ), _contentType ( contentType ), _contentLength ( length ) {}
+    virtual ~AsyncWebServerResponse() {}
+    void            setCode ( int code )            { _code = code ; }
+    void            setContentLength ( size_t len ) { _contentLength = len ; }
+    void            setContentType ( const String& type ) { _contentType = type ; }
+    void            addHeader ( const String& name, const String& value ) ;
+    int             code() const                    { return _code ; }
+    String          head() const ;                  // Status line and headers
+    virtual size_t  fill ( uint8_t* buf, size_t maxLen ) = 0 ;
+    virtual bool    chunked() const                 { return false ; }
+  protected:
+    int             _code ;                         // HTTP status code
+    String          _contentType ;
+    size_t          _contentLength ;                // Length of body if not chunked
+    size_t          _index = 0 ;                    // Number of body bytes delivered
+    std::vector<AsyncWebHeader> _headers ;          // Extra headers
+} ;
+
+
+class AsyncBasicResponse : public AsyncWebServerResponse
+{
+  public:
+    AsyncBasicResponse ( int code, const String& contentType, const String& content ) ;
+    size_t          fill ( uint8_t* buf, size_t maxLen ) override ;
+  private:
+    String          _content ;
+} ;
+
+
+class AsyncProgmemResponse : public AsyncWebServerResponse
+{
+  public:
+    AsyncProgmemResponse ( int code, const String& contentType, const uint8_t* content,
+                           size_t len ) ;
+    size_t          fill ( uint8_t* buf, size_t maxLen ) override ;
+  private:
+    const uint8_t*  _content ;
+} ;
+
+
+class AsyncCallbackResponse : public AsyncWebServerResponse
+{
+  public:
+    AsyncCallbackResponse ( const String& contentType, size_t len,
+                            AwsResponseFiller callback ) ;
+    size_t          fill ( uint8_t* buf, size_t maxLen ) override ;
+  protected:
+    AwsResponseFiller _callback ;
+} ;
+
+
+class AsyncChunkedResponse : public AsyncCallbackResponse
+{
+  public:
+    AsyncChunkedResponse ( const String& contentType, AwsResponseFiller callback )
+      : AsyncCallbackResponse ( contentType, 0, callback ) {}
+    bool            chunked() const override        { return true ; }
+} ;
+
+
+class AsyncFileResponse : public AsyncWebServerResponse
+{
+  public:
+    AsyncFileResponse ( const char* hostpath, const String& contentType ) ;
+    ~AsyncFileResponse() ;
+    size_t          fill ( uint8_t* buf, size_t maxLen ) override ;
+  private:
+    FILE*           _file ;
+} ;
+
+
+//******************************************************************************************
+// A request as seen by the handlers.                                                      *
+//******************************************************************************************
+class AsyncWebServerRequest
+{
+  friend class AsyncWebServer ;
+  public:
+    AsyncWebServerRequest ( const char* url = "/",
+                            WebRequestMethodComposite method = HTTP_GET ) ;
+    ~AsyncWebServerRequest() ;
+    void*                     _tempObject = nullptr ;  // Free for use by handlers, free()d
+
+    AsyncClient*              client()              { return &_client ; }
+    const String&             url() const           { return _url ; }
+    WebRequestMethodComposite method() const        { return _method ; }
+    const char*               methodToString() const ;
+    const String&             contentType() const   { return _contentType ; }
+    size_t                    contentLength() const { return _contentLength ; }
+
+    size_t                    params() const        { return _params.size() ; }
+    AsyncWebParameter*        getParam ( size_t num ) const ;
+    AsyncWebParameter*        getParam ( const String& name, bool post = false,
+                                         bool file = false ) const ;
+    bool                      hasParam ( const String& name, bool post = false,
+                                         bool file = false ) const ;
+    const String&             arg ( const String& name ) const ;
+
+    size_t                    headers() const       { return _headers.size() ; }
+    bool                      hasHeader ( const String& name ) const ;
+    AsyncWebHeader*           getHeader ( const String& name ) const ;
+    AsyncWebHeader*           getHeader ( size_t num ) const ;
+    const String&             header ( const char* name ) const ;
+
+    void                      onDisconnect ( ArDisconnectHandler fn ) ; // Replaces earlier
+
+    void                      send ( AsyncWebServerResponse* response ) ;
+    void                      send ( int code, const String& contentType = String(),
+                                     const String& content = String() ) ;
+    void                      send_P ( int code, const String& contentType,
+                                       const uint8_t* content, size_t len ) ;
+    void                      send_P ( int code, const String& contentType,
+                                       PGM_P content ) ;
+    AsyncWebServerResponse*   beginResponse ( int code,
+                                              const String& contentType = String(),
+                                              const String& content = String() ) ;
+    AsyncWebServerResponse*   beginResponse_P ( int code, const String& contentType,
+                                                const uint8_t* content, size_t len ) ;
+    AsyncWebServerResponse*   beginResponse ( const String& contentType, size_t len,
+                                              AwsResponseFiller callback ) ;
+    AsyncWebServerResponse*   beginChunkedResponse ( const String& contentType,
+                                                     AwsResponseFiller callback ) ;
+
+    // Host only, for harnesses that call the handlers without a connection
+    void                      addParam ( const String& name, const String& value,
+                                         bool post = false ) ;
+    void                      addHeader ( const String& name, const String& value ) ;
+    AsyncWebServerResponse*   response() const      { return _response ; }
+    void                      clearResponse() ;
+    void                      disconnect() ;        // As when the connection is closed
+  private:
+    AsyncClient               _client ;
+    String                    _url ;
+    WebRequestMethodComposite _method = 0 ;
+    String                    _contentType ;
+    size_t                    _contentLength = 0 ;
+    std::vector<AsyncWebParameter*> _params ;
+    std::vector<AsyncWebHeader*>    _headers ;
+    ArDisconnectHandler       _onDisconnect ;
+    AsyncWebServerResponse*   _response = nullptr ;
+} ;
+
+
+//******************************************************************************************
+// A handler object, added with addHandler().  Like on() routes, handlers are asked in the *
+// order they were added; the first one whose canHandle() returns true gets the request.   *
+// canHandle() is called when the head of the request is complete, before the body.        *
+//******************************************************************************************
+class AsyncWebHandler
+{
+  public:
+    virtual         ~AsyncWebHandler() {}
+    virtual bool    canHandle ( AsyncWebServerRequest* request )    { return false ; }
+    virtual void    handleRequest ( AsyncWebServerRequest* request ) {}
+    virtual void    handleBody ( AsyncWebServerRequest* request, uint8_t* data,
+                                 size_t len, size_t index, size_t total ) {}
+} ;
+
+
+//******************************************************************************************
+// The server itself.                                                                      *
+//******************************************************************************************
+class AsyncWebServer
+{
+  public:
+    AsyncWebServer ( uint16_t port ) ;
+    ~AsyncWebServer() ;
+    void            begin() ;
+    void            end() ;
+    void            on ( const char* uri, ArRequestHandlerFunction onRequest ) ;
+    void            on ( const char* uri, WebRequestMethodComposite method,
+                         ArRequestHandlerFunction onRequest ) ;
+    void            on ( const char* uri, WebRequestMethodComposite method,
+                         ArRequestHandlerFunction onRequest,
+                         ArUploadHandlerFunction onUpload,
+                         ArBodyHandlerFunction onBody = nullptr ) ;
+    void            onNotFound ( ArRequestHandlerFunction fn ) ;
+    AsyncWebHandler& addHandler ( AsyncWebHandler* handler ) ;
+    uint16_t        port() const                    { return _port ; }
+
+  private:
+    struct Handler                                  // Registered handler
+    {
+      String                    uri ;
+      WebRequestMethodComposite method ;
+      ArRequestHandlerFunction  onRequest ;
+      ArBodyHandlerFunction     onBody ;
+      AsyncWebHandler*          custom ;            // Added with addHandler()
+    } ;
+    struct Conn ;                                   // Connection state, see webserver.cpp
+    uint16_t                  _port ;               // Port we are listening on
+    int                       _fd = -1 ;            // Listening socket
+    std::vector<Handler>      _handlers ;
+    ArRequestHandlerFunction  _notFound ;
+    std::list<Conn*>          _conns ;              // Open connections
+    std::thread               _thread ;             // Network thread
+    std::atomic<bool>         _running { false } ;
+    void            run() ;
+    void            accept_conn() ;
+    bool            handle_read ( Conn* c ) ;
+    bool            handle_write ( Conn* c ) ;
+    bool            parse_head ( Conn* c ) ;
+    void            start_body ( Conn* c ) ;
+    void            feed_body ( Conn* c, uint8_t* data, size_t len ) ;
+    void            dispatch ( Conn* c ) ;
+    void            prime ( Conn* c ) ;
+    void            close_conn ( Conn* c ) ;
+    const Handler*  find_handler ( AsyncWebServerRequest* request ) const ;
+} ;
+
+#endif
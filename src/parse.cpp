@@ -0,0 +1,581 @@
+//******************************************************************************************
+// parse.cpp - Parsing of request parameters.                                             *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Line end after a body, trailing comma after the intensities of O       *
+//******************************************************************************************
+#include "parse.h"
+
+
+static bool fail ( parse_err_t* err, size_t pos, const char* msg )
+{
+  err->pos = pos ;
+  err->msg = msg ;
+  return false ;
+}
+
+
+//******************************************************************************************
+// Read a decimal number at text[*pos].  The value is limited to just above hi, so it      *
+// cannot overflow.  Returns false if there are no digits.                                 *
+//******************************************************************************************
+static bool get_number ( const char* text, size_t len, size_t* pos, int hi, long* v )
+{
+  size_t start = *pos ;                                       // Start of number
+
+  *v = 0 ;
+  while ( ( *pos < len ) && ( text[*pos] >= '0' ) && ( text[*pos] <= '9' ) )
+  {
+    if ( *v <= hi )                                           // Stop growing, avoid overflow
+    {
+      *v = *v * 10 + ( text[*pos] - '0' ) ;
+    }
+    (*pos)++ ;
+  }
+  return *pos != start ;
+}
+
+
+//******************************************************************************************
+//                             P A R S E _ N U M B E R                                     *
+//******************************************************************************************
+// Parse one decimal number in the range 0..hi.  hi is limited, so that get_number()       *
+// cannot overflow a 32 bit long.                                                          *
+//******************************************************************************************
+bool parse_number ( const char* text, size_t len, long hi, long* value, parse_err_t* err )
+{
+  size_t pos = 0 ;                                            // Position in text
+
+  err->pos = -1 ;
+  err->msg = "" ;
+  if ( ! get_number ( text, len, &pos, hi, value ) )
+  {
+    return fail ( err, pos, "number expected" ) ;
+  }
+  if ( pos < len )
+  {
+    return fail ( err, pos, "end expected" ) ;
+  }
+  if ( *value > hi )
+  {
+    return fail ( err, 0, "value out of range" ) ;
+  }
+  return true ;
+}
+
+
+//******************************************************************************************
+//                            P A R S E _ I N T L I S T                                    *
+//******************************************************************************************
+// Parse exactly n decimal numbers, separated by commas.  A comma after the last number is *
+// allowed (the web page sends one).  Every number must be in the range lo..hi.  On error  *
+// the contents of values is undefined.                                                    *
+//******************************************************************************************
+bool parse_intlist ( const char* text, size_t len, uint8_t* values, int n,
+                     int lo, int hi, parse_err_t* err )
+{
+  size_t pos = 0 ;                                            // Position in text
+  int    count = 0 ;                                          // Number of values seen
+  size_t start ;                                              // Start of current number
+  long   v ;                                                  // Value of current number
+
+  err->pos = -1 ;
+  err->msg = "" ;
+  while ( pos < len )
+  {
+    if ( count == n )                                         // All values seen?
+    {
+      return fail ( err, pos, "too many values" ) ;
+    }
+    start = pos ;
+    if ( ! get_number ( text, len, &pos, hi, &v ) )           // No digits?
+    {
+      return fail ( err, pos, "number expected" ) ;
+    }
+    if ( ( v < lo ) || ( v > hi ) )
+    {
+      return fail ( err, start, "value out of range" ) ;
+    }
+    values[count++] = v ;
+    if ( pos < len )                                          // Not at the end?
+    {
+      if ( text[pos] != ',' )                                 // Then a comma must follow
+      {
+        return fail ( err, pos, "comma expected" ) ;
+      }
+      pos++ ;
+    }
+  }
+  if ( count < n )
+  {
+    return fail ( err, pos, "too few values" ) ;
+  }
+  return true ;
+}
+
+
+//******************************************************************************************
+//                               P A R S E _ P A T C H                                     *
+//******************************************************************************************
+// Parse a list of changes for the schedule and apply them to values.  Every change is     *
+// "<lamp><hour>=<value>" or "<lamp><hour>-<hour>=<value>", lamp is A or B, hours are      *
+// 0..23.  Changes are separated by commas, a trailing comma is allowed.  Examples:        *
+//   "A7=40"            lamp A at 07:00 to 40                                              *
+//   "A8-17=80,B8-17=60" both lamps from 08:00 until 17:00                                 *
+// values holds 2 entries per hour, lamp A first.  On error values may be partly changed,  *
+// so the caller should work on a copy.                                                    *
+//******************************************************************************************
+bool parse_patch ( const char* text, size_t len, uint8_t* values, int hi,
+                   parse_err_t* err )
+{
+  size_t pos = 0 ;                                            // Position in text
+  size_t start ;                                              // Start of current number
+  int    lamp ;                                               // 0 for A, 1 for B
+  long   h1, h2 ;                                             // First and last hour
+  long   v ;                                                  // New value
+
+  err->pos = -1 ;
+  err->msg = "" ;
+  if ( len == 0 )
+  {
+    return fail ( err, 0, "nothing to change" ) ;
+  }
+  while ( pos < len )
+  {
+    switch ( text[pos] | 0x20 )                               // Lamp, case does not matter
+    {
+      case 'a' : lamp = 0 ; break ;
+      case 'b' : lamp = 1 ; break ;
+      default  : return fail ( err, pos, "lamp A or B expected" ) ;
+    }
+    start = ++pos ;
+    if ( ! get_number ( text, len, &pos, 23, &h1 ) )          // First hour
+    {
+      return fail ( err, pos, "hour expected" ) ;
+    }
+    if ( h1 > 23 )
+    {
+      return fail ( err, start, "hour out of range" ) ;
+    }
+    h2 = h1 ;                                                 // Assume a single hour
+    if ( ( pos < len ) && ( text[pos] == '-' ) )              // Range of hours?
+    {
+      start = ++pos ;
+      if ( ! get_number ( text, len, &pos, 23, &h2 ) )        // Yes, get last hour
+      {
+        return fail ( err, pos, "hour expected" ) ;
+      }
+      if ( ( h2 > 23 ) || ( h2 < h1 ) )
+      {
+        return fail ( err, start, "hour out of range" ) ;
+      }
+    }
+    if ( ( pos == len ) || ( text[pos] != '=' ) )
+    {
+      return fail ( err, pos, "'=' expected" ) ;
+    }
+    start = ++pos ;
+    if ( ! get_number ( text, len, &pos, hi, &v ) )           // New value
+    {
+      return fail ( err, pos, "number expected" ) ;
+    }
+    if ( v > hi )
+    {
+      return fail ( err, start, "value out of range" ) ;
+    }
+    for ( ; h1 <= h2 ; h1++ )                                 // Apply to all hours
+    {
+      values[h1 * 2 + lamp] = v ;
+    }
+    if ( pos < len )                                          // Not at the end?
+    {
+      if ( text[pos] != ',' )                                 // Then a comma must follow
+      {
+        return fail ( err, pos, "comma expected" ) ;
+      }
+      pos++ ;
+    }
+  }
+  return true ;
+}
+
+
+//******************************************************************************************
+//                               P A R S E _ B A T C H                                     *
+//******************************************************************************************
+// Parse a list of operations, separated by ';', a trailing ';' is allowed.  Operations:   *
+//   "P:<patch>"        change the schedule, see parse_patch()                             *
+//   "O:<a>,<b>[,]"     overrule with intensities a and b                                  *
+//   "O:<a>,<b>,<min>"  the same, ends after min minutes                                   *
+//   "C"                clear the overrule                                                 *
+//   "G"                get the state                                                      *
+// The letter may be in lower case.  A later O or C replaces an earlier one.  Patches are  *
+// applied to values in order; on error values may be partly changed, so the caller        *
+// should work on a copy, and the position of the error is in the whole text.              *
+//******************************************************************************************
+bool parse_batch ( const char* text, size_t len, uint8_t* values, int hi,
+                   batch_t* batch, parse_err_t* err )
+{
+  size_t  pos = 0 ;                                           // Start of operation
+  size_t  end ;                                               // End of operation
+  size_t  arg ;                                               // Start of argument
+  size_t  sep ;                                               // End of intensities
+  uint8_t ov[2] ;                                             // Overrule intensities
+  int     commas ;                                            // Commas in argument
+  long    v ;                                                 // Minutes of overrule
+  char    op ;                                                // Operation
+
+  err->pos = -1 ;
+  err->msg = "" ;
+  batch->flags = 0 ;
+  batch->ops = 0 ;
+  batch->ovA = batch->ovB = 0 ;
+  batch->ovmin = 0 ;
+  if ( len == 0 )
+  {
+    return fail ( err, 0, "no operations" ) ;
+  }
+  while ( pos < len )
+  {
+    for ( end = pos ; ( end < len ) && ( text[end] != ';' ) ; end++ ) ;
+    if ( batch->ops == BATCH_MAXOPS )
+    {
+      return fail ( err, pos, "too many operations" ) ;
+    }
+    op = text[pos] | 0x20 ;                                   // Case does not matter
+    arg = pos + 1 ;
+    if ( ( op == 'p' ) || ( op == 'o' ) )                     // Argument needed?
+    {
+      if ( ( arg == end ) || ( text[arg] != ':' ) )
+      {
+        return fail ( err, arg, "':' expected" ) ;
+      }
+      arg++ ;
+    }
+    else if ( ( op == 'c' ) || ( op == 'g' ) )
+    {
+      if ( arg != end )
+      {
+        return fail ( err, arg, "';' expected" ) ;
+      }
+    }
+    else
+    {
+      return fail ( err, pos, "operation P, O, C or G expected" ) ;
+    }
+    switch ( op )
+    {
+      case 'p' :
+        if ( ! parse_patch ( text + arg, end - arg, values, hi, err ) )
+        {
+          err->pos += arg ;                                   // Position in whole text
+          return false ;
+        }
+        batch->flags |= BATCH_SET ;
+        break ;
+      case 'o' :
+        commas = 0 ;                                          // Find the second comma
+        for ( sep = arg ; ( sep < end ) && ! ( text[sep] == ',' && ++commas == 2 ) ;
+              sep++ ) ;
+        if ( ! parse_intlist ( text + arg, sep - arg, ov, 2, 0, hi, err ) )
+        {
+          err->pos += arg ;
+          return false ;
+        }
+        v = 0 ;                                               // No end
+        if ( sep + 1 < end )                                  // Minutes follow, or only a
+        {                                                     // trailing comma?
+          arg = ++sep ;
+          if ( ! get_number ( text, end, &sep, BATCH_MAXMIN, &v ) || ( sep != end ) )
+          {
+            return fail ( err, sep, "minutes expected" ) ;
+          }
+          if ( v > BATCH_MAXMIN )
+          {
+            return fail ( err, arg, "minutes out of range" ) ;
+          }
+        }
+        batch->ovA = ov[0] ;
+        batch->ovB = ov[1] ;
+        batch->ovmin = v ;
+        batch->flags = ( batch->flags & ~BATCH_CLEAR ) | BATCH_OVERRULE ;
+        break ;
+      case 'c' :
+        batch->flags = ( batch->flags & ~BATCH_OVERRULE ) | BATCH_CLEAR ;
+        break ;
+      case 'g' :
+        batch->flags |= BATCH_STATE ;
+        break ;
+    }
+    batch->ops++ ;
+    pos = end + 1 ;                                           // Skip the ';'
+  }
+  return true ;
+}
+
+
+//******************************************************************************************
+//                                B O D Y _ F E E D                                        *
+//******************************************************************************************
+// Parse a POST body with the formats of parse_intlist() and parse_patch(), one character  *
+// at a time, so a body may be split anywhere.  Errors and their positions are the same as *
+// for the whole text.  Only values is changed, so a patch should work on a copy.          *
+// Line ends after the body are ignored (a file sent with curl has one); anything after a  *
+// line end is an error.                                                                   *
+//******************************************************************************************
+enum body_step_t
+{
+  STEP_NUMBER,                                                // Value of a list
+  STEP_LAMP,                                                  // Patch: A or B
+  STEP_HOUR1,                                                 // Patch: first hour
+  STEP_HOUR2,                                                 // Patch: last hour
+  STEP_VALUE,                                                 // Patch: new value
+  STEP_FAILED                                                 // Error found, in err
+} ;
+
+static void body_begin ( bodyparse_t* bp, uint8_t* values, int n, int lo, int hi,
+                         uint8_t step )
+{
+  bp->values = values ;
+  bp->n = n ;
+  bp->lo = lo ;
+  bp->hi = hi ;
+  bp->step = step ;
+  bp->count = 0 ;
+  bp->v = 0 ;
+  bp->digits = false ;
+  bp->pos = 0 ;
+  bp->tail = 0 ;
+  bp->err.pos = -1 ;
+  bp->err.msg = "" ;
+}
+
+
+void body_intlist ( bodyparse_t* bp, uint8_t* values, int n, int lo, int hi )
+{
+  body_begin ( bp, values, n, lo, hi, STEP_NUMBER ) ;
+}
+
+
+void body_patch ( bodyparse_t* bp, uint8_t* values, int hi )
+{
+  body_begin ( bp, values, 48, 0, hi, STEP_LAMP ) ;
+}
+
+
+static bool body_fail ( bodyparse_t* bp, size_t pos, const char* msg )
+{
+  bp->step = STEP_FAILED ;
+  return fail ( &bp->err, pos, msg ) ;
+}
+
+
+//******************************************************************************************
+// Add a digit to the number being read.  Like get_number(), the value is limited to just  *
+// above hi.                                                                               *
+//******************************************************************************************
+static void body_digit ( bodyparse_t* bp, char c, int hi )
+{
+  if ( ! bp->digits )
+  {
+    bp->digits = true ;
+    bp->start = bp->pos ;
+    bp->v = 0 ;
+  }
+  if ( bp->v <= hi )
+  {
+    bp->v = bp->v * 10 + ( c - '0' ) ;
+  }
+}
+
+
+//******************************************************************************************
+// The number being read is complete.  Check and store it, false on error.                 *
+//******************************************************************************************
+static bool body_number ( bodyparse_t* bp )
+{
+  long h ;
+
+  bp->digits = false ;
+  switch ( bp->step )
+  {
+    case STEP_NUMBER :
+      if ( ( bp->v < bp->lo ) || ( bp->v > bp->hi ) )
+      {
+        return body_fail ( bp, bp->start, "value out of range" ) ;
+      }
+      bp->values[bp->count++] = bp->v ;
+      break ;
+    case STEP_HOUR1 :
+      if ( bp->v > 23 )
+      {
+        return body_fail ( bp, bp->start, "hour out of range" ) ;
+      }
+      bp->h1 = bp->v ;
+      bp->h2 = bp->v ;                                        // Assume a single hour
+      break ;
+    case STEP_HOUR2 :
+      if ( ( bp->v > 23 ) || ( bp->v < bp->h1 ) )
+      {
+        return body_fail ( bp, bp->start, "hour out of range" ) ;
+      }
+      bp->h2 = bp->v ;
+      break ;
+    case STEP_VALUE :
+      if ( bp->v > bp->hi )
+      {
+        return body_fail ( bp, bp->start, "value out of range" ) ;
+      }
+      for ( h = bp->h1 ; h <= bp->h2 ; h++ )                  // Apply to all hours
+      {
+        bp->values[h * 2 + bp->lamp] = bp->v ;
+      }
+      break ;
+  }
+  return true ;
+}
+
+
+static bool body_char ( bodyparse_t* bp, char c )
+{
+  bool digit = ( c >= '0' ) && ( c <= '9' ) ;
+
+  switch ( bp->step )
+  {
+    case STEP_NUMBER :
+      if ( digit )
+      {
+        if ( ! bp->digits && ( bp->count == bp->n ) )         // All values seen?
+        {
+          return body_fail ( bp, bp->pos, "too many values" ) ;
+        }
+        body_digit ( bp, c, bp->hi ) ;
+        return true ;
+      }
+      if ( ! bp->digits )
+      {
+        return body_fail ( bp, bp->pos, "number expected" ) ;
+      }
+      if ( c != ',' )
+      {
+        return body_fail ( bp, bp->pos, "comma expected" ) ;
+      }
+      return body_number ( bp ) ;
+    case STEP_LAMP :
+      switch ( c | 0x20 )                                     // Case does not matter
+      {
+        case 'a' : bp->lamp = 0 ; break ;
+        case 'b' : bp->lamp = 1 ; break ;
+        default  : return body_fail ( bp, bp->pos, "lamp A or B expected" ) ;
+      }
+      bp->step = STEP_HOUR1 ;
+      return true ;
+    case STEP_HOUR1 :
+    case STEP_HOUR2 :
+      if ( digit )
+      {
+        body_digit ( bp, c, 23 ) ;
+        return true ;
+      }
+      if ( ! bp->digits )
+      {
+        return body_fail ( bp, bp->pos, "hour expected" ) ;
+      }
+      if ( ( c != '=' ) && ( ( c != '-' ) || ( bp->step == STEP_HOUR2 ) ) )
+      {
+        return body_fail ( bp, bp->pos, "'=' expected" ) ;
+      }
+      if ( ! body_number ( bp ) )
+      {
+        return false ;
+      }
+      bp->step = ( c == '-' ) ? STEP_HOUR2 : STEP_VALUE ;
+      return true ;
+    case STEP_VALUE :
+      if ( digit )
+      {
+        body_digit ( bp, c, bp->hi ) ;
+        return true ;
+      }
+      if ( ! bp->digits )
+      {
+        return body_fail ( bp, bp->pos, "number expected" ) ;
+      }
+      if ( c != ',' )
+      {
+        return body_fail ( bp, bp->pos, "comma expected" ) ;
+      }
+      if ( ! body_number ( bp ) )
+      {
+        return false ;
+      }
+      bp->step = STEP_LAMP ;
+      return true ;
+  }
+  return false ;                                              // STEP_FAILED
+}
+
+
+bool body_feed ( bodyparse_t* bp, const char* text, size_t len )
+{
+  char c ;
+
+  for ( size_t i = 0 ; ( i < len ) && ( bp->step != STEP_FAILED ) ; i++ )
+  {
+    c = text[i] ;
+    if ( ( c == '\r' ) || ( c == '\n' ) )                     // Line end after the body?
+    {
+      bp->tail++ ;
+    }
+    else if ( bp->tail )                                      // Text after the line end
+    {
+      return body_fail ( bp, bp->pos, "end expected" ) ;
+    }
+    else if ( ! body_char ( bp, c ) )
+    {
+      return false ;
+    }
+    bp->pos++ ;
+  }
+  return bp->step != STEP_FAILED ;
+}
+
+
+//******************************************************************************************
+// The body is complete.  A number at the end is taken, and a list must be complete.  The  *
+// positions of errors are before the line ends.                                           *
+//******************************************************************************************
+bool body_end ( bodyparse_t* bp )
+{
+  size_t end = bp->pos - bp->tail ;                           // End of body, no line ends
+
+  switch ( bp->step )
+  {
+    case STEP_NUMBER :
+      if ( bp->digits && ! body_number ( bp ) )
+      {
+        return false ;
+      }
+      if ( bp->count < bp->n )
+      {
+        return body_fail ( bp, end, "too few values" ) ;
+      }
+      return true ;
+    case STEP_LAMP :
+      if ( end == 0 )
+      {
+        return body_fail ( bp, 0, "nothing to change" ) ;
+      }
+      return true ;
+    case STEP_HOUR1 :
+    case STEP_HOUR2 :
+      return body_fail ( bp, end, bp->digits ? "'=' expected" : "hour expected" ) ;
+    case STEP_VALUE :
+      if ( ! bp->digits )
+      {
+        return body_fail ( bp, end, "number expected" ) ;
+      }
+      return body_number ( bp ) ;
+  }
+  return false ;                                              // STEP_FAILED
+}
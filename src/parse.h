@@ -0,0 +1,81 @@
+//******************************************************************************************
+// parse.h - Parsing of request parameters.                                               *
+//******************************************************************************************
+// The parameters are parsed in a single pass over the raw bytes, without copies and       *
+// without the heap.  Errors are reported with the position in the text, so the reply to   *
+// the client can tell what is wrong.                                                      *
+// The same formats can also be parsed from a POST body while it arrives: a bodyparse_t    *
+// keeps the state between the parts, so no part has to be kept.                           *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Line end after a body                                                  *
+//******************************************************************************************
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct parse_err_t                                            // Result of a parse
+{
+  int         pos ;                                           // Position of error, -1 if okay
+  const char* msg ;                                           // What is wrong
+} ;
+
+bool parse_number ( const char* text, size_t len,             // Parse one number 0..hi,
+                    long hi, long* value,                     // hi at most 200000000
+                    parse_err_t* err ) ;
+bool parse_intlist ( const char* text, size_t len,            // Parse "v1,v2,...,vn[,]",
+                                                              // 0 <= lo <= hi <= 255
+                     uint8_t* values, int n,
+                     int lo, int hi,
+                     parse_err_t* err ) ;
+bool parse_patch ( const char* text, size_t len,              // Parse "A8-17=80,B8=40" and
+                   uint8_t* values, int hi,                   // apply to values[48]
+                   parse_err_t* err ) ;
+
+#define BATCH_SET         0x01                                // Schedule changed
+#define BATCH_OVERRULE    0x02                                // Overrule set
+#define BATCH_CLEAR       0x04                                // Overrule cleared
+#define BATCH_STATE       0x08                                // State requested
+#define BATCH_MAXOPS        16                                // Operations in a batch
+#define BATCH_MAXMIN      1440                                // Longest overrule, a day
+
+struct batch_t                                                // Result of parse_batch()
+{
+  uint8_t     flags ;                                         // BATCH_SET etc.
+  uint8_t     ops ;                                           // Number of operations
+  uint8_t     ovA, ovB ;                                      // Overrule intensities
+  uint16_t    ovmin ;                                         // Minutes of overrule, 0 for
+} ;                                                           // no end
+
+bool parse_batch ( const char* text, size_t len,              // Parse "P:A8=40;O:80,60,30;G"
+                   uint8_t* values, int hi,                   // apply patches to values[48]
+                   batch_t* batch, parse_err_t* err ) ;
+
+struct bodyparse_t                                            // State of a body parse
+{
+  uint8_t*    values ;                                        // Result
+  int         n ;                                             // Number of values (list)
+  int         lo, hi ;                                        // Range of values
+  uint8_t     step ;                                          // What comes next
+  uint8_t     lamp ;                                          // Lamp of patch
+  uint8_t     h1, h2 ;                                        // Hours of patch
+  int         count ;                                         // Values seen (list)
+  long        v ;                                             // Number being read
+  bool        digits ;                                        // v has digits
+  size_t      pos ;                                           // Bytes seen
+  size_t      tail ;                                          // Line ends at the end
+  size_t      start ;                                         // Start of v
+  parse_err_t err ;                                           // First error
+} ;
+
+void body_intlist ( bodyparse_t* bp, uint8_t* values, int n,  // Start parse_intlist()
+                    int lo, int hi ) ;
+void body_patch ( bodyparse_t* bp, uint8_t* values, int hi ) ; // Start parse_patch()
+bool body_feed ( bodyparse_t* bp, const char* text,           // Next part, false after
+                 size_t len ) ;                               // an error
+bool body_end ( bodyparse_t* bp ) ;                           // Body complete, result of
+                                                              // the parse
+
+#endif
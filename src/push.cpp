@@ -0,0 +1,130 @@
+//******************************************************************************************
+// push.cpp - Changes pushed to web clients as Server-Sent Events.                        *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#include "push.h"
+#include "hal.h"
+#include <stdio.h>
+#include <string.h>
+
+struct frame_t                                                // One event
+{
+  uint16_t        len ;                                       // Bytes in text
+  char            text[PUSH_FRAMELEN] ;
+} ;
+
+static frame_t    frames[PUSH_FRAMES] ;                       // Frame n is in n % PUSH_FRAMES
+static uint32_t   pushseq ;                                   // Newest frame, 0 if none yet
+static uint8_t    nclients ;                                  // Clients connected
+
+
+bool push_join()
+{
+  if ( nclients == PUSH_CLIENTS )
+  {
+    return false ;
+  }
+  nclients++ ;
+  return true ;
+}
+
+
+void push_leave()
+{
+  if ( nclients )
+  {
+    nclients-- ;
+  }
+}
+
+
+uint8_t push_clients()
+{
+  return nclients ;
+}
+
+
+uint32_t push_seq()
+{
+  return __atomic_load_n ( &pushseq, __ATOMIC_ACQUIRE ) ;
+}
+
+
+//******************************************************************************************
+//                              P U S H _ P U B L I S H                                    *
+//******************************************************************************************
+// Format a new frame in the oldest slot of the ring.  data must be a single line.         *
+//******************************************************************************************
+void push_publish ( const char* event, const char* data )
+{
+  uint32_t seq = pushseq + 1 ;                                // Number of the new frame
+  frame_t* f = &frames[seq % PUSH_FRAMES] ;
+  int      n ;
+
+  n = snprintf ( f->text, sizeof(f->text), "id: %u\nevent: %s\ndata: %s\n\n",
+                 (unsigned)seq, event, data ) ;
+  if ( ( n < 0 ) || ( n >= (int)sizeof(f->text) ) )           // Too long for a frame?
+  {
+    return ;                                                  // Never a broken event
+  }
+  f->len = n ;
+  __atomic_store_n ( &pushseq, seq, __ATOMIC_RELEASE ) ;
+}
+
+
+//******************************************************************************************
+//                                 P U S H _ F I L L                                       *
+//******************************************************************************************
+// Filler of the chunked response of a client.  index is the number of bytes sent, so the  *
+// part of the current frame still to send follows from pos->base.  A new client starts    *
+// with the newest frame, the current state.  A frame that is overwritten while it is      *
+// only partly sent cannot be completed; the response then ends and the browser connects   *
+// again.                                                                                  *
+//******************************************************************************************
+size_t push_fill ( pushpos_t* pos, uint8_t* buf, size_t maxLen, size_t index )
+{
+  uint32_t       newest = push_seq() ;                        // Newest frame
+  const frame_t* f ;                                          // Current frame
+  size_t         off ;                                        // Bytes of it sent
+  size_t         n ;
+
+  if ( newest == 0 )                                          // Nothing published yet?
+  {
+    return RESPONSE_TRY_AGAIN ;
+  }
+  if ( pos->seq == 0 )                                        // First call?
+  {
+    pos->seq = newest ;
+    pos->base = index ;
+  }
+  while ( true )
+  {
+    off = index - pos->base ;
+    if ( pos->seq + PUSH_FRAMES <= newest )                   // Frame overwritten?
+    {
+      if ( off )
+      {
+        return 0 ;                                            // Yes, during the send
+      }
+      pos->seq = newest ;                                     // Continue with newest
+    }
+    f = &frames[pos->seq % PUSH_FRAMES] ;
+    if ( off < f->len )                                       // Part of frame left?
+    {
+      n = f->len - off ;
+      if ( n > maxLen )
+      {
+        n = maxLen ;
+      }
+      memcpy ( buf, f->text + off, n ) ;
+      return n ;
+    }
+    if ( pos->seq == newest )                                 // Frame complete, next one
+    {
+      return RESPONSE_TRY_AGAIN ;                             // is not there yet
+    }
+    pos->seq++ ;
+    pos->base = index ;
+  }
+}
@@ -0,0 +1,42 @@
+//******************************************************************************************
+// push.h - Changes pushed to web clients as Server-Sent Events.                          *
+//******************************************************************************************
+// loop() publishes a frame when the outputs, the overrule or the settings change, and a   *
+// heartbeat when nothing changed for PUSH_HEARTBEAT msec.  A frame is one complete event  *
+// ("id:", "event:" and "data:" lines) and is formatted once, into a ring of PUSH_FRAMES   *
+// frames.  Every client is a chunked response whose filler copies from that ring; all it  *
+// keeps is a pushpos_t, so the cost of a change does not grow with the number of clients. *
+// A filler without a new frame returns RESPONSE_TRY_AGAIN, the webserver asks again       *
+// later.  Every frame holds the whole state, so a client that is more than PUSH_FRAMES    *
+// behind simply continues with the newest frame.                                          *
+// The fillers run in the context of the TCP stack, which does not interrupt loop().       *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef PUSH_H
+#define PUSH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PUSH_FRAMES         4                                 // Frames kept in the ring
+#define PUSH_FRAMELEN     200                                 // Maximum size of a frame
+#define PUSH_CLIENTS        4                                 // Clients at the same time
+#define PUSH_HEARTBEAT  15000                                 // Heartbeat after 15 s idle
+
+struct pushpos_t                                              // Position of a client
+{
+  uint32_t  seq ;                                             // Frame being sent, 0 if none
+  uint32_t  base ;                                            // Stream index of its start
+} ;
+
+bool     push_join() ;                                        // New client, false if full
+void     push_leave() ;                                       // Client has gone
+uint8_t  push_clients() ;                                     // Number of clients
+void     push_publish ( const char* event,                    // New frame, by loop() only
+                        const char* data ) ;
+uint32_t push_seq() ;                                         // Number of newest frame
+size_t   push_fill ( pushpos_t* pos, uint8_t* buf,            // Filler of a client
+                     size_t maxLen, size_t index ) ;
+
+#endif
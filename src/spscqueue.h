@@ -0,0 +1,56 @@
+//******************************************************************************************
+// spscqueue.h - Bounded queue for one producer and one consumer, without locks.          *
+//******************************************************************************************
+// The producer (the webserver callbacks) only writes head, the consumer (loop()) only     *
+// writes tail.  An entry is copied in completely before head moves on, so the consumer    *
+// never sees half an entry.  N must be a power of 2 and at most 128.  One entry is kept   *
+// free to tell a full queue from an empty one, so N-1 entries can be queued.              *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+//******************************************************************************************
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <stdint.h>
+
+template <typename T, uint8_t N>
+class SpscQueue
+{
+  static_assert ( ( N & ( N - 1 ) ) == 0 && N <= 128, "N must be a power of 2" ) ;
+
+  public:
+    bool push ( const T& item )                     // Producer side, false if full
+    {
+      uint8_t h = __atomic_load_n ( &head, __ATOMIC_RELAXED ) ;
+      uint8_t next = ( h + 1 ) & ( N - 1 ) ;
+
+      if ( next == __atomic_load_n ( &tail, __ATOMIC_ACQUIRE ) )
+      {
+        return false ;                              // Full
+      }
+      items[h] = item ;
+      __atomic_store_n ( &head, next, __ATOMIC_RELEASE ) ;   // Publish the entry
+      return true ;
+    }
+
+    bool pop ( T& item )                            // Consumer side, false if empty
+    {
+      uint8_t t = __atomic_load_n ( &tail, __ATOMIC_RELAXED ) ;
+
+      if ( t == __atomic_load_n ( &head, __ATOMIC_ACQUIRE ) )
+      {
+        return false ;                              // Empty
+      }
+      item = items[t] ;
+      __atomic_store_n ( &tail, (uint8_t)( ( t + 1 ) & ( N - 1 ) ),  // Free the entry
+                         __ATOMIC_RELEASE ) ;
+      return true ;
+    }
+
+  private:
+    T       items[N] ;                              // The entries
+    uint8_t head = 0 ;                              // Next entry to fill
+    uint8_t tail = 0 ;                              // Next entry to take
+} ;
+
+#endif
@@ -0,0 +1,205 @@
+//******************************************************************************************
+// template.cpp - Fill the fields of a page in flash, part by part.                       *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Resume where the last chunk ended, a short read is an error            *
+//******************************************************************************************
+#include "template.h"
+#include <stdio.h>
+#include <string.h>
+
+
+TemplateWriter::TemplateWriter ( uint8_t* buf, size_t maxLen, size_t skip, size_t start )
+  : buf ( buf ), maxlen ( maxLen ), skip ( skip ), pos ( start )
+{
+}
+
+
+//******************************************************************************************
+// Add one character of the page.  Only the part after skip that fits is stored.           *
+//******************************************************************************************
+void TemplateWriter::put ( char c )
+{
+  if ( ( pos >= skip ) && ( out < maxlen ) )
+  {
+    buf[out++] = c ;
+  }
+  pos++ ;
+}
+
+
+void TemplateWriter::puts ( const char* s )
+{
+  while ( *s )
+  {
+    put ( *s++ ) ;
+  }
+}
+
+
+void TemplateWriter::putn ( long value )
+{
+  char num[12] ;                                              // Fits a 32 bit long
+
+  snprintf ( num, sizeof(num), "%ld", value ) ;
+  puts ( num ) ;
+}
+
+
+//******************************************************************************************
+// Add len bytes of the page from offset.  Bytes before skip are not read at all, and only *
+// the bytes that fit in the buffer are read, straight into the buffer.  If fewer bytes    *
+// come the page is not what was compiled: the writer fails, see error().                  *
+//******************************************************************************************
+void TemplateWriter::copy ( tpl_reader_t read, const void* src, size_t offset, size_t len )
+{
+  size_t from = 0 ;                                           // First byte to store
+  size_t n ;                                                  // Bytes to store
+
+  if ( pos < skip )                                           // Part was sent before?
+  {
+    from = skip - pos ;
+    if ( from >= len )
+    {
+      pos += len ;                                            // All of it
+      return ;
+    }
+  }
+  n = len - from ;
+  if ( n > maxlen - out )
+  {
+    n = maxlen - out ;                                        // Rest in next chunk
+  }
+  if ( n && ( read ( src, offset + from, buf + out, n ) != n ) )
+  {
+    failed = true ;                                           // Short read
+    return ;
+  }
+  out += n ;
+  pos += len ;
+}
+
+
+//******************************************************************************************
+//                               T P L _ C O M P I L E                                     *
+//******************************************************************************************
+// Find the fields in the page.  A field name may be split over two reads, so the scan     *
+// keeps the name found so far.                                                            *
+//******************************************************************************************
+bool tpl_compile ( tpl_t* tpl, tpl_reader_t read, const void* src, size_t len,
+                   const char* const names[], uint8_t nnames )
+{
+  uint8_t buf[64] ;                                           // Part of the page
+  char    name[TPL_NAMELEN + 1] ;                             // Name after a '%'
+  int     n = -1 ;                                            // Length of name, -1 if none
+  size_t  start = 0 ;                                         // Offset of the '%'
+  size_t  pos ;                                               // Offset of buf
+  size_t  got ;                                               // Bytes in buf
+  size_t  i ;
+  uint8_t id ;
+  char    c ;
+
+  tpl->read = read ;
+  tpl->len = len ;
+  tpl->nfields = 0 ;
+  for ( pos = 0 ; pos < len ; pos += got )
+  {
+    got = read ( src, pos, buf, ( len - pos ) < sizeof(buf) ? len - pos : sizeof(buf) ) ;
+    if ( got == 0 )
+    {
+      return false ;                                          // Page shorter than len
+    }
+    for ( i = 0 ; i < got ; i++ )
+    {
+      c = buf[i] ;
+      if ( ( n >= 0 ) && ( n < TPL_NAMELEN ) && ( ( c >= 'A' && c <= 'Z' ) || c == '_' ) )
+      {
+        name[n++] = c ;                                       // Name continues
+        continue ;
+      }
+      if ( ( c == '%' ) && ( n > 0 ) )                        // End of a name?
+      {
+        name[n] = '\0' ;
+        for ( id = 0 ; ( id < nnames ) && strcmp ( name, names[id] ) ; id++ ) ;
+        if ( id < nnames )                                    // Known field?
+        {
+          if ( tpl->nfields == TPL_FIELDS )
+          {
+            return false ;                                    // Yes, but no room
+          }
+          tpl->fields[tpl->nfields].offset = start ;
+          tpl->fields[tpl->nfields].len = n + 2 ;
+          tpl->fields[tpl->nfields].id = id ;
+          tpl->nfields++ ;
+          n = -1 ;
+          continue ;
+        }
+      }
+      n = -1 ;
+      if ( c == '%' )                                         // Maybe start of a name
+      {
+        n = 0 ;
+        start = pos + i ;
+      }
+    }
+  }
+  return true ;
+}
+
+
+//******************************************************************************************
+//                                 T P L _ B E G I N                                       *
+//******************************************************************************************
+// Start a response with the page read from src.                                           *
+//******************************************************************************************
+void tpl_begin ( tplcur_t* cur, const void* src )
+{
+  cur->src = src ;
+  cur->index = 0 ;
+  cur->pos = 0 ;
+  cur->tpos = 0 ;
+  cur->f = 0 ;
+}
+
+
+//******************************************************************************************
+//                                T P L _ R E N D E R                                      *
+//******************************************************************************************
+// Produce the chunk from index on.  Returns the number of bytes in buf, 0 at the end.     *
+// The page is made in steps: the text before a field, then the field.  The chunk starts   *
+// with the step where the last one ended, unless index is not where that was; then the    *
+// page is made from the start again.                                                      *
+//******************************************************************************************
+size_t tpl_render ( const tpl_t* tpl, tplcur_t* cur, tpl_filler_t fill, const void* ctx,
+                    uint8_t* buf, size_t maxLen, size_t index )
+{
+  size_t         tpos ;                                       // Position in the page
+  size_t         end ;                                        // End of text before field
+  uint8_t        f ;
+
+  if ( index != cur->index )                                  // Not the next chunk?
+  {
+    tpl_begin ( cur, cur->src ) ;                             // From the start then
+  }
+  TemplateWriter out ( buf, maxLen, index, cur->pos ) ;       // Writer for this chunk
+  tpos = cur->tpos ;
+  for ( f = cur->f ; ( f <= tpl->nfields ) && ! out.full() ; f++ )
+  {
+    cur->pos = out.position() ;                               // Step may end in the chunk,
+    cur->tpos = tpos ;                                        // the next one starts here
+    cur->f = f ;
+    end = ( f < tpl->nfields ) ? tpl->fields[f].offset : tpl->len ;
+    out.copy ( tpl->read, cur->src, tpos, end - tpos ) ;      // Text up to the field
+    if ( f < tpl->nfields )
+    {
+      fill ( tpl->fields[f].id, out, ctx ) ;                  // The field itself
+      tpos = end + tpl->fields[f].len ;
+    }
+  }
+  if ( out.error() )
+  {
+    return TPL_ERROR ;
+  }
+  cur->index = index + out.length() ;
+  return out.length() ;
+}
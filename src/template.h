@@ -0,0 +1,93 @@
+//******************************************************************************************
+// template.h - Fill the fields of a page in flash, part by part.                         *
+//******************************************************************************************
+// A template is a page with fields like %SLIDERS%: a percent sign, a name in capitals or  *
+// '_' and another percent sign.  tpl_compile() reads the page once and remembers where    *
+// the fields are; a percent sign with an unknown name is plain text.  The page itself     *
+// stays in flash, in LittleFS or in PROGMEM, it is read through a tpl_reader_t.           *
+// tpl_render() makes one chunk of a chunked response.  A tplcur_t remembers where the     *
+// chunk ended: the next chunk starts with the text or field that was cut off, the part of *
+// it that was sent is skipped.  Text is skipped by its length, only the part in the chunk *
+// is read.  A field is produced again by the fill function, that must give the same text  *
+// every time.  So the page is never in RAM as a whole.                                    *
+// The page must not change while it is sent.  If it cannot be read (a short read) the     *
+// render fails with TPL_ERROR, the response cannot be completed.                          *
+//******************************************************************************************
+// 16-10-2026, AG - First setup                                                            *
+// 17-10-2026, AG - Resume where the last chunk ended, a short read is an error            *
+//******************************************************************************************
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TPL_FIELDS      8                                     // Maximum fields in a page
+#define TPL_NAMELEN    15                                     // Maximum length of a name
+#define TPL_ERROR      ( (size_t)-1 )                         // Result of tpl_render() if
+                                                              // the page could not be read
+
+typedef size_t (*tpl_reader_t) ( const void* src, size_t offset,    // Read part of the
+                                 uint8_t* buf, size_t len ) ;        // page, return count
+
+class TemplateWriter                                          // Output of one chunk
+{
+  public:
+    TemplateWriter ( uint8_t* buf, size_t maxLen, size_t skip,  // Output of the page
+                     size_t start = 0 ) ;                     // from start on
+
+    void         put ( char c ) ;
+    void         puts ( const char* s ) ;
+    void         putn ( long value ) ;                        // Number in decimal
+    void         copy ( tpl_reader_t read, const void* src,   // Text of the page
+                        size_t offset, size_t len ) ;
+    bool         full() const            { return ( out == maxlen ) || failed ; }
+    bool         error() const           { return failed ; }  // A read was short
+    size_t       length() const          { return out ; }     // Bytes stored in buf
+    size_t       position() const        { return pos ; }     // Position in page
+
+  private:
+    uint8_t*     buf ;                                        // Output buffer
+    size_t       maxlen ;                                     // Size of buf
+    size_t       skip ;                                       // Bytes already sent
+    size_t       pos ;                                        // Position in page
+    size_t       out = 0 ;                                    // Bytes stored in buf
+    bool         failed = false ;                             // A read was short
+} ;
+
+typedef void (*tpl_filler_t) ( uint8_t field, TemplateWriter& out,  // Produce the text of
+                               const void* ctx ) ;                   // a field
+
+struct tplfield_t                                             // A field in the page
+{
+  uint32_t       offset ;                                     // Position of first '%'
+  uint8_t        len ;                                        // Length including the '%'s
+  uint8_t        id ;                                         // Index in names[]
+} ;
+
+struct tpl_t                                                  // A compiled template
+{
+  tpl_reader_t   read ;                                       // Reads the page
+  size_t         len ;                                        // Length of the page
+  uint8_t        nfields ;                                    // Fields found
+  tplfield_t     fields[TPL_FIELDS] ;                         // In order of offset
+} ;
+
+bool   tpl_compile ( tpl_t* tpl, tpl_reader_t read, const void* src, size_t len,
+                     const char* const names[], uint8_t nnames ) ;   // False on read error
+                                                                     // or too many fields
+struct tplcur_t                                               // Where a response is
+{
+  const void*    src ;                                        // Passed to read
+  size_t         index ;                                      // Output at end of last chunk
+  size_t         pos ;                                        // Output at start of step f
+  size_t         tpos ;                                       // Page at start of step f
+  uint8_t        f ;                                          // Step: text before field f
+} ;                                                           // and field f
+
+void   tpl_begin ( tplcur_t* cur, const void* src ) ;         // Before the first chunk
+size_t tpl_render ( const tpl_t* tpl, tplcur_t* cur,          // 0 at the end, TPL_ERROR
+                    tpl_filler_t fill, const void* ctx,       // on a read error
+                    uint8_t* buf, size_t maxLen, size_t index ) ;
+
+#endif